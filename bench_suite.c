@@ -0,0 +1,609 @@
+/* bench_suite.c - Microbenchmark suite for kacchiOS
+ *
+ * Every case times a batch of operations with the TSC, repeats the batch
+ * BENCH_TRIALS times from the same starting state and prints one line:
+ *
+ *   BENCH <name> <param>=<value>... ops=N trials=N min_ns=N median_ns=N max_ns=N median_cycles=N
+ *
+ * Times are per operation. Kernel messages are muted while a batch runs so
+ * serial output does not end up in the numbers. Compare two runs with
+ * tools/bench_compare.py.
+ */
+#include "types.h"
+#include "bench_suite.h"
+#include "memory.h"
+#include "process.h"
+#include "scheduler.h"
+#include "ipc.h"
+#include "ring.h"
+#include "deferred.h"
+#include "syscall.h"
+#include "initrd.h"
+#include "string.h"
+#include "serial.h"
+#include "clock.h"
+#include "math64.h"
+#include "kprintf.h"
+
+//Allocation size distribution
+typedef struct {
+    const char *name;
+    uint32_t min;
+    uint32_t max;
+    uint32_t log;               /* Pick a power-of-two multiple of min instead of a uniform size */
+} bench_dist_t;
+
+static const bench_dist_t bench_dists[] = {
+    { "small", 16, 256, 0 },
+    { "page", 4096, 4096, 0 },
+    { "mixed", 16, 16384, 1 },
+    { "large", 8192, 24576, 0 }
+};
+
+static const uint32_t bench_proc_counts[] = { 10, 100, 255 };
+
+static uint64_t bench_samples[BENCH_TRIALS];
+static uint64_t bench_samples2[BENCH_TRIALS];
+static uint32_t bench_sizes[BENCH_ALLOC_COUNT];
+static uint32_t bench_addrs[BENCH_ALLOC_COUNT];
+static uint32_t bench_order[BENCH_ALLOC_COUNT];
+static uint32_t bench_pids[MAX_PROCESSES];
+static uint32_t bench_rand_state;
+static uint32_t bench_errors = 0;
+
+/* Same LCG as the workload generator, so sequences are fixed per seed */
+static uint32_t bench_rand(uint32_t range) {
+    bench_rand_state = bench_rand_state * 1103515245 + 12345;
+    return (bench_rand_state >> 16) % range;
+}
+
+/* Fresh allocator, process table and scheduler; returns 0 if the policy is fixed to another one */
+static uint32_t bench_reset(scheduling_algorithm_t algorithm) {
+    uint32_t muted = serial_set_muted(1);
+    memory_init();
+    process_init();
+    scheduler_init(algorithm, 5);
+    serial_set_muted(muted);
+    return scheduler_get_algorithm() == algorithm;
+}
+
+static const char *bench_policy_name(scheduling_algorithm_t algorithm) {
+    return algorithm == FCFS ? "fcfs" : algorithm == MLFQ ? "mlfq" : "rr";
+}
+
+/* Create processes until count are live; returns how many were created */
+static uint32_t bench_spawn(uint32_t count) {
+    uint32_t i;
+    for (i = 0; i < count; i++) {
+        bench_pids[i] = process_create(1 + i % 4, 1024, 1024);
+        if (bench_pids[i] == 0) {
+            break;
+        }
+    }
+    return i;
+}
+
+/* Per-operation nanoseconds for a batch */
+static uint32_t bench_ns_per_op(uint64_t cycles, uint32_t ops) {
+    return (uint32_t)udiv64(clock_cycles_to_ns(cycles), ops);
+}
+
+/**
+ * Print one result line
+ * @param name: Operation measured
+ * @param params: Case parameters, "key=value" separated by spaces
+ * @param ops: Operations per trial
+ * @param samples: Cycles for each of the BENCH_TRIALS trials; sorted in place
+ */
+static void bench_report(const char *name, const char *params, uint32_t ops, uint64_t *samples) {
+    uint32_t i, j;
+    for (i = 1; i < BENCH_TRIALS; i++) {
+        uint64_t value = samples[i];
+        for (j = i; j > 0 && samples[j - 1] > value; j--) {
+            samples[j] = samples[j - 1];
+        }
+        samples[j] = value;
+    }
+    kprintf("BENCH %s %s ops=%u trials=%u min_ns=%u median_ns=%u max_ns=%u median_cycles=%u\n",
+            name, params, ops, BENCH_TRIALS, bench_ns_per_op(samples[0], ops),
+            bench_ns_per_op(samples[BENCH_TRIALS / 2], ops),
+            bench_ns_per_op(samples[BENCH_TRIALS - 1], ops),
+            (uint32_t)udiv64(samples[BENCH_TRIALS / 2], ops));
+}
+
+static void bench_error(const char *message) {
+    bench_errors++;
+    serial_puts("BENCH_ERROR ");
+    serial_puts(message);
+    serial_puts("\n");
+}
+
+/* ============================================================================
+   MEMORY MANAGER BENCHMARKS
+   ============================================================================ */
+
+//memory_allocate/memory_free throughput; blocks are freed in shuffled order
+void bench_memory(void) {
+    uint32_t d, i, trial;
+    char params[32];
+    for (d = 0; d < sizeof(bench_dists) / sizeof(bench_dists[0]); d++) {
+        const bench_dist_t *dist = &bench_dists[d];
+        uint32_t failed = 0;
+        bench_reset(RR);
+        bench_rand_state = d + 1;
+        for (i = 0; i < BENCH_ALLOC_COUNT; i++) {
+            if (dist->log) {
+                uint32_t steps = 0;
+                while ((dist->min << (steps + 1)) <= dist->max) {
+                    steps++;
+                }
+                bench_sizes[i] = dist->min << bench_rand(steps + 1);
+            }
+            else {
+                bench_sizes[i] = dist->min + bench_rand(dist->max - dist->min + 1);
+            }
+            bench_order[i] = i;
+        }
+        for (i = BENCH_ALLOC_COUNT - 1; i > 0; i--) {
+            uint32_t j = bench_rand(i + 1);
+            uint32_t tmp = bench_order[i];
+            bench_order[i] = bench_order[j];
+            bench_order[j] = tmp;
+        }
+        serial_set_muted(1);
+        for (trial = 0; trial < BENCH_TRIALS; trial++) {
+            uint64_t start = clock_cycles();
+            for (i = 0; i < BENCH_ALLOC_COUNT; i++) {
+                bench_addrs[i] = memory_allocate(bench_sizes[i], 1);
+            }
+            bench_samples[trial] = clock_cycles() - start;
+            for (i = 0; i < BENCH_ALLOC_COUNT; i++) {
+                failed += bench_addrs[i] == 0;
+            }
+            start = clock_cycles();
+            for (i = 0; i < BENCH_ALLOC_COUNT; i++) {
+                memory_free(bench_addrs[bench_order[i]]);
+            }
+            bench_samples2[trial] = clock_cycles() - start;
+        }
+        serial_set_muted(0);
+        if (failed) {
+            bench_error("memory_allocate failed during the memory benchmark");
+        }
+        ksnprintf(params, sizeof(params), "dist=%s", dist->name);
+        bench_report("memory_allocate", params, BENCH_ALLOC_COUNT, bench_samples);
+        bench_report("memory_free", params, BENCH_ALLOC_COUNT, bench_samples2);
+    }
+}
+
+/* ============================================================================
+   PROCESS MANAGER BENCHMARKS
+   ============================================================================ */
+
+//process_create/process_terminate cost, each trial from an empty table
+void bench_process_lifecycle(void) {
+    uint32_t i, trial;
+    uint32_t created = BENCH_PROC_COUNT;
+    char params[32];
+    for (trial = 0; trial < BENCH_TRIALS; trial++) {
+        uint64_t start;
+        uint32_t count;
+        bench_reset(RR);
+        serial_set_muted(1);
+        start = clock_cycles();
+        count = bench_spawn(BENCH_PROC_COUNT);
+        bench_samples[trial] = clock_cycles() - start;
+        start = clock_cycles();
+        for (i = 0; i < count; i++) {
+            process_terminate(bench_pids[i]);
+        }
+        bench_samples2[trial] = clock_cycles() - start;
+        serial_set_muted(0);
+        if (count < created) {
+            created = count;
+        }
+    }
+    if (created < BENCH_PROC_COUNT) {
+        bench_error("process_create failed during the lifecycle benchmark");
+        created = created ? created : 1;
+    }
+    ksnprintf(params, sizeof(params), "stack=%u heap=%u", 1024, 1024);
+    bench_report("process_create", params, created, bench_samples);
+    bench_report("process_terminate", params, created, bench_samples2);
+}
+
+/* ============================================================================
+   SCHEDULER BENCHMARKS
+   ============================================================================ */
+
+//scheduler_get_next_process() latency by policy and number of READY processes
+void bench_scheduler_pick(void) {
+    uint32_t p, n, i, trial;
+    char params[32];
+    for (p = FCFS; p <= MLFQ; p++) {
+        for (n = 0; n < sizeof(bench_proc_counts) / sizeof(bench_proc_counts[0]); n++) {
+            uint32_t procs = bench_proc_counts[n];
+            if (!bench_reset((scheduling_algorithm_t)p)) {
+                break;
+            }
+            serial_set_muted(1);
+            if (bench_spawn(procs) < procs) {
+                serial_set_muted(0);
+                bench_error("process_create failed while filling the run queue");
+                continue;
+            }
+            for (trial = 0; trial < BENCH_TRIALS; trial++) {
+                uint64_t start = clock_cycles();
+                for (i = 0; i < BENCH_PICK_CALLS; i++) {
+                    scheduler_get_next_process();
+                }
+                bench_samples[trial] = clock_cycles() - start;
+            }
+            serial_set_muted(0);
+            ksnprintf(params, sizeof(params), "policy=%s procs=%u",
+                      bench_policy_name((scheduling_algorithm_t)p), procs);
+            bench_report("scheduler_get_next_process", params, BENCH_PICK_CALLS, bench_samples);
+        }
+    }
+}
+
+//scheduler_update_time() cost per tick, including the preemption it triggers
+void bench_scheduler_tick(void) {
+    uint32_t p, n, i, trial;
+    char params[32];
+    for (p = FCFS; p <= MLFQ; p++) {
+        for (n = 0; n < sizeof(bench_proc_counts) / sizeof(bench_proc_counts[0]); n++) {
+            uint32_t procs = bench_proc_counts[n];
+            if (!bench_reset((scheduling_algorithm_t)p)) {
+                break;
+            }
+            serial_set_muted(1);
+            if (bench_spawn(procs) < procs) {
+                serial_set_muted(0);
+                bench_error("process_create failed while filling the run queue");
+                continue;
+            }
+            for (trial = 0; trial < BENCH_TRIALS; trial++) {
+                uint64_t start = clock_cycles();
+                for (i = 0; i < BENCH_TICKS; i++) {
+                    scheduler_update_time();
+                }
+                bench_samples[trial] = clock_cycles() - start;
+            }
+            serial_set_muted(0);
+            ksnprintf(params, sizeof(params), "policy=%s procs=%u",
+                      bench_policy_name((scheduling_algorithm_t)p), procs);
+            bench_report("scheduler_update_time", params, BENCH_TICKS, bench_samples);
+        }
+    }
+}
+
+/* ============================================================================
+   IPC BENCHMARKS
+   ============================================================================ */
+
+/*
+ * Client/server round trip: ipc_call() plus ipc_reply_wait(), each switching
+ * straight to the partner, against the same two switches made by blocking and
+ * waking through the run queue. Other READY processes make the pick cost show.
+ */
+void bench_ipc_round_trip(void) {
+    uint32_t n, i, trial, path;
+    char params[32];
+    ipc_msg_t msg = { { 1, 2, 3, 4 } };
+    uint32_t from;
+    for (n = 0; n < 2; n++) {
+        uint32_t procs = bench_proc_counts[n];
+        for (path = 0; path < 2; path++) {
+            uint32_t server, client;
+            uint32_t ok = 1;
+            bench_reset(RR);
+            serial_set_muted(1);
+            server = process_create(1, 1024, 1024);
+            client = process_create(1, 1024, 1024);
+            if (server == 0 || client == 0 || bench_spawn(procs) < procs) {
+                serial_set_muted(0);
+                bench_error("process_create failed while setting up the IPC benchmark");
+                continue;
+            }
+            scheduler_schedule();
+            if (path == 0) {
+                ipc_receive(server, IPC_ANY, &from, &msg);
+            }
+            else {
+                scheduler_block(server);
+            }
+            for (trial = 0; trial < BENCH_TRIALS; trial++) {
+                uint64_t start = clock_cycles();
+                for (i = 0; i < BENCH_IPC_ROUNDS; i++) {
+                    if (path == 0) {
+                        ipc_call(client, server, &msg);
+                        ipc_take(server, &from, &msg);
+                        ipc_reply_wait(server, client, &msg, IPC_ANY, &from, &msg);
+                        ipc_take(client, &from, &msg);
+                    }
+                    else {
+                        scheduler_wake(server);
+                        scheduler_block(client);
+                        scheduler_wake(client);
+                        scheduler_block(server);
+                    }
+                }
+                bench_samples[trial] = clock_cycles() - start;
+            }
+            ok = scheduler_current_process() == client;
+            serial_set_muted(0);
+            if (!ok) {
+                bench_error("IPC round trip did not end on the client");
+            }
+            ksnprintf(params, sizeof(params), "path=%s procs=%u", path == 0 ? "handoff" : "runqueue", procs);
+            bench_report("ipc_round_trip", params, BENCH_IPC_ROUNDS, bench_samples);
+        }
+    }
+}
+
+static const uint32_t bench_ring_batches[] = { 1, 16, 64 };
+
+/*
+ * Producer/consumer streaming through a 1024-entry ring in fixed batches.
+ * Both ends run on this CPU in turn, so this is the per-entry cost of the
+ * publish/consume paths themselves; the ring never blocks.
+ */
+void bench_ring_stream(void) {
+    uint32_t entries[64];
+    uint32_t b, i, trial;
+    char params[32];
+    for (i = 0; i < 64; i++) {
+        entries[i] = i;
+    }
+    for (b = 0; b < sizeof(bench_ring_batches) / sizeof(bench_ring_batches[0]); b++) {
+        uint32_t batch = bench_ring_batches[b];
+        uint32_t producer, consumer;
+        uint32_t moved = 0;
+        ring_t *ring;
+        bench_reset(RR);
+        serial_set_muted(1);
+        producer = process_create(1, 1024, 1024);
+        consumer = process_create(1, 1024, 1024);
+        ring = ring_create("bench", 1024, producer, consumer);
+        if (ring == NULL) {
+            serial_set_muted(0);
+            bench_error("ring_create failed while setting up the ring benchmark");
+            continue;
+        }
+        for (trial = 0; trial < BENCH_TRIALS; trial++) {
+            uint64_t start = clock_cycles();
+            for (i = 0; i < BENCH_RING_ENTRIES; i += batch) {
+                ring_publish(ring, entries, batch);
+                moved += ring_consume(ring, entries, batch);
+            }
+            bench_samples[trial] = clock_cycles() - start;
+        }
+        serial_set_muted(0);
+        if (moved != BENCH_TRIALS * BENCH_RING_ENTRIES) {
+            bench_error("Ring benchmark lost entries");
+        }
+        ksnprintf(params, sizeof(params), "batch=%u", batch);
+        bench_report("ring_stream", params, BENCH_RING_ENTRIES, bench_samples);
+    }
+}
+
+static const uint32_t bench_deferred_batches[] = { 1, 16, 64 };
+static deferred_work_t bench_deferred_items[64];
+static uint32_t bench_deferred_done;
+
+static void bench_deferred_count(void *arg) {
+    (void)arg;
+    bench_deferred_done++;
+}
+
+/*
+ * Interrupt-style producer and the worker as consumer: queue a batch of
+ * work items, then drain them with deferred_worker_run(). Times are per
+ * item and cover queueing, the queue-delay bookkeeping and the call.
+ */
+void bench_deferred_work(void) {
+    uint32_t b, i, trial;
+    char params[32];
+    for (i = 0; i < 64; i++) {
+        deferred_work_init(&bench_deferred_items[i], bench_deferred_count, NULL);
+    }
+    for (b = 0; b < sizeof(bench_deferred_batches) / sizeof(bench_deferred_batches[0]); b++) {
+        uint32_t batch = bench_deferred_batches[b];
+        bench_reset(RR);
+        serial_set_muted(1);
+        deferred_init();
+        bench_deferred_done = 0;
+        for (trial = 0; trial < BENCH_TRIALS; trial++) {
+            uint64_t start = clock_cycles();
+            for (i = 0; i < BENCH_DEFERRED_ITEMS; i += batch) {
+                uint32_t j;
+                for (j = 0; j < batch; j++) {
+                    deferred_queue(&bench_deferred_items[j]);
+                }
+                deferred_worker_run();
+            }
+            bench_samples[trial] = clock_cycles() - start;
+        }
+        serial_set_muted(0);
+        if (bench_deferred_done != BENCH_TRIALS * BENCH_DEFERRED_ITEMS) {
+            bench_error("Deferred work benchmark lost items");
+        }
+        ksnprintf(params, sizeof(params), "batch=%u", batch);
+        bench_report("deferred_work", params, BENCH_DEFERRED_ITEMS, bench_samples);
+    }
+}
+
+#ifndef KACCHI_HOSTED
+/* Ring 3 loops for the system call benchmark */
+static uint32_t bench_user_sysenter(uint32_t count) {
+    while (count--) {
+        syscall_sysenter(SYS_NULL, 0, 0, 0);
+    }
+    return 0;
+}
+
+static uint32_t bench_user_int80(uint32_t count) {
+    while (count--) {
+        syscall_int80(SYS_NULL, 0, 0, 0);
+    }
+    return 0;
+}
+#endif
+
+/*
+ * Null system call round trip from ring 3: SYSENTER/SYSEXIT against
+ * int 0x80/iret, with a plain call into the table as the floor. Each trial
+ * also pays one entry to and exit from ring 3, spread over BENCH_SYSCALLS.
+ * The hosted build has no ring 3 and skips this case.
+ */
+void bench_syscall_null(void) {
+#ifndef KACCHI_HOSTED
+    uint32_t path, i, trial;
+    uint32_t pid;
+    char params[32];
+    bench_reset(RR);
+    serial_set_muted(1);
+    pid = process_create(1, 4096, 1024);
+    serial_set_muted(0);
+    if (pid == 0) {
+        bench_error("process_create failed while setting up the syscall benchmark");
+        return;
+    }
+    for (path = 0; path < 3; path++) {
+        if (path == 1 && !syscall_sysenter_available()) {
+            continue;
+        }
+        for (trial = 0; trial < BENCH_TRIALS; trial++) {
+            uint64_t start = clock_cycles();
+            if (path == 0) {
+                for (i = 0; i < BENCH_SYSCALLS; i++) {
+                    syscall_dispatch(SYS_NULL, 0, 0, 0);
+                }
+            }
+            else {
+                syscall_run_user(pid, path == 1 ? bench_user_sysenter : bench_user_int80, BENCH_SYSCALLS);
+            }
+            bench_samples[trial] = clock_cycles() - start;
+        }
+        ksnprintf(params, sizeof(params), "path=%s", path == 0 ? "call" : path == 1 ? "sysenter" : "int80");
+        bench_report("syscall_null", params, BENCH_SYSCALLS, bench_samples);
+    }
+#endif
+}
+
+static const char *bench_initrd_paths[] = { "map", "read", "records" };
+static uint8_t bench_initrd_image[(BENCH_INITRD_KB + 2) * 1024] __attribute__((aligned(INITRD_BLOCK_SIZE)));
+static uint8_t bench_initrd_buf[INITRD_BENCH_CHUNK];
+
+/* Octal tar field with a trailing NUL */
+static void bench_initrd_octal(uint8_t *field, uint32_t len, uint32_t value) {
+    field[--len] = '\0';
+    while (len--) {
+        field[len] = (uint8_t)('0' + (value & 7));
+        value >>= 3;
+    }
+}
+
+/* One-file ustar archive; the data follows the header block */
+static void bench_initrd_build(void) {
+    uint32_t size = BENCH_INITRD_KB * 1024;
+    uint32_t sum = 0;
+    uint32_t i;
+    memset(bench_initrd_image, 0, sizeof(bench_initrd_image));
+    strcpy((char *)bench_initrd_image, "bench.bin");
+    bench_initrd_octal(bench_initrd_image + 124, 12, size);
+    bench_initrd_image[156] = '0';
+    memcpy(bench_initrd_image + 257, "ustar", 6);
+    memset(bench_initrd_image + 148, ' ', 8);
+    for (i = 0; i < INITRD_BLOCK_SIZE; i++) {
+        sum += bench_initrd_image[i];
+    }
+    bench_initrd_octal(bench_initrd_image + 148, 7, sum);
+    for (i = 0; i < size; i++) {
+        bench_initrd_image[INITRD_BLOCK_SIZE + i] = (uint8_t)(i * 7);
+    }
+}
+
+/*
+ * Reading a file off the RAM disk three ways: zero-copy initrd_map() of
+ * 4 KB blocks, initrd_read() of 4 KB aligned chunks (straight copies) and
+ * initrd_read() of 100-byte records (through the block cache). Every path
+ * sums the bytes it gets, so the differences are the copying and caching.
+ * Times are per KB.
+ */
+void bench_initrd_read(void) {
+    const initrd_file_t *file;
+    uint32_t path, trial;
+    uint32_t expected = 0;
+    char params[32];
+    bench_initrd_build();
+    serial_set_muted(1);
+    initrd_mount(bench_initrd_image, sizeof(bench_initrd_image));
+    serial_set_muted(0);
+    file = initrd_open("bench.bin");
+    if (file == NULL) {
+        bench_error("Could not mount the initrd benchmark image");
+        return;
+    }
+    for (path = 0; path < 3; path++) {
+        uint32_t sum = 0;
+        for (trial = 0; trial < BENCH_TRIALS; trial++) {
+            uint64_t start = clock_cycles();
+            uint32_t offset = 0;
+            sum = 0;
+            while (offset < file->size) {
+                uint32_t chunk = path == 2 ? INITRD_BENCH_RECORD : INITRD_BENCH_CHUNK;
+                const uint8_t *data = bench_initrd_buf;
+                uint32_t i;
+                if (chunk > file->size - offset) {
+                    chunk = file->size - offset;
+                }
+                if (path == 0) {
+                    data = (const uint8_t *)initrd_map(file, offset, chunk);
+                }
+                else {
+                    initrd_read(file, offset, bench_initrd_buf, chunk);
+                }
+                for (i = 0; i < chunk; i++) {
+                    sum += data[i];
+                }
+                offset += chunk;
+            }
+            bench_samples[trial] = clock_cycles() - start;
+        }
+        if (path == 0) {
+            expected = sum;
+        }
+        else if (sum != expected) {
+            bench_error("initrd reads differ from the mapped file");
+        }
+        ksnprintf(params, sizeof(params), "path=%s", bench_initrd_paths[path]);
+        bench_report("initrd_read", params, BENCH_INITRD_KB, bench_samples);
+    }
+    initrd_unmount();
+}
+
+/* ============================================================================
+   BENCHMARK RUNNER
+   ============================================================================ */
+
+void run_all_benchmarks(void) {
+    serial_puts("\n");
+    serial_puts("================================================================================\n");
+    serial_puts("                    kacchiOS BENCHMARKS\n");
+    serial_puts("================================================================================\n");
+    kprintf("BENCH_BEGIN tsc_khz=%u trials=%u\n", clock_tsc_khz(), BENCH_TRIALS);
+    
+    bench_memory();
+    bench_process_lifecycle();
+    bench_scheduler_pick();
+    bench_scheduler_tick();
+    bench_ipc_round_trip();
+    bench_ring_stream();
+    bench_deferred_work();
+    bench_syscall_null();
+    bench_initrd_read();
+    
+    kprintf("BENCH_END errors=%u\n", bench_errors);
+}
\ No newline at end of file
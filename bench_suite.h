@@ -0,0 +1,30 @@
+/* bench_suite.h - Microbenchmark suite header for kacchiOS */
+#ifndef BENCH_SUITE_H
+#define BENCH_SUITE_H
+
+#define BENCH_TRIALS        7       /* Repeats per case; min/median/max are reported */
+#define BENCH_ALLOC_COUNT   128     /* Blocks allocated then freed per memory trial */
+#define BENCH_PROC_COUNT    64      /* Processes created then terminated per trial */
+#define BENCH_PICK_CALLS    1000    /* scheduler_get_next_process() calls per trial */
+#define BENCH_TICKS         1000    /* scheduler_update_time() calls per trial */
+#define BENCH_IPC_ROUNDS    1000    /* Client/server round trips per trial */
+#define BENCH_RING_ENTRIES  65536   /* Entries streamed through a ring per trial */
+#define BENCH_DEFERRED_ITEMS 16384  /* Work items queued and run per trial */
+#define BENCH_SYSCALLS      10000   /* Null system calls per trial */
+#define BENCH_INITRD_KB     64      /* Size of the file read per initrd trial */
+
+/* Run all benchmarks */
+void run_all_benchmarks(void);
+
+/* Individual benchmarks */
+void bench_memory(void);
+void bench_process_lifecycle(void);
+void bench_scheduler_pick(void);
+void bench_scheduler_tick(void);
+void bench_ipc_round_trip(void);
+void bench_ring_stream(void);
+void bench_deferred_work(void);
+void bench_syscall_null(void);
+void bench_initrd_read(void);
+
+#endif
@@ -0,0 +1,162 @@
+/* clock.c - TSC-based monotonic clock calibrated against the PIT
+ *
+ * The TSC is cheap to read but ticks at an unknown rate. At boot, PIT
+ * channel 2 (whose input clock is fixed at 1.193182 MHz) times a short
+ * window with the speaker output gated off, and the TSC cycles counted
+ * across it give the rate. Everything after that is a rdtsc and a scale.
+ */
+#include "clock.h"
+#include "io.h"
+#include "math64.h"
+#include "serial.h"
+#include "kprintf.h"
+
+//PIT channel 2 is gated through the keyboard controller's port B
+#define PIT_CHANNEL0      0x40
+#define PIT_CHANNEL2      0x42
+#define PIT_COMMAND       0x43
+#define PIT_PORT_B        0x61
+#define PORT_B_GATE2      0x01
+#define PORT_B_SPEAKER    0x02
+#define PORT_B_OUT2       0x20
+#define PIT_CH2_ONESHOT   0xB0      /* Channel 2, lobyte/hibyte, mode 0, binary */
+#define PIT_CH0_PERIODIC  0x34      /* Channel 0, lobyte/hibyte, mode 2 (rate generator) */
+#define CLOCK_POLL_LIMIT  10000000  /* Port reads before giving up on the PIT */
+
+static uint32_t clock_khz = CLOCK_DEFAULT_KHZ;
+static uint64_t clock_boot_cycles = 0;
+
+#ifdef KACCHI_HOSTED
+uint64_t host_monotonic_ns(void);
+
+/* Hosted builds time the same window against the host's monotonic clock */
+static uint64_t clock_calibrate_once(uint32_t latch) {
+    uint64_t window = udiv64((uint64_t)latch * 1000000000, PIT_FREQUENCY_HZ);
+    uint64_t begin = host_monotonic_ns();
+    uint64_t start = rdtsc();
+    while (host_monotonic_ns() - begin < window) {
+        cpu_relax();
+    }
+    return rdtsc() - start;
+}
+#else
+/* Time one PIT window in TSC cycles; 0 if OUT2 never rises */
+static uint64_t clock_calibrate_once(uint32_t latch) {
+    uint64_t start;
+    uint32_t polls = 0;
+    outb(PIT_PORT_B, (inb(PIT_PORT_B) & ~PORT_B_SPEAKER) | PORT_B_GATE2);
+    outb(PIT_COMMAND, PIT_CH2_ONESHOT);
+    outb(PIT_CHANNEL2, latch & 0xFF);
+    outb(PIT_CHANNEL2, (latch >> 8) & 0xFF);
+    start = rdtsc();
+    while ((inb(PIT_PORT_B) & PORT_B_OUT2) == 0) {
+        if (++polls == CLOCK_POLL_LIMIT) {
+            return 0;
+        }
+    }
+    return rdtsc() - start;
+}
+#endif
+
+/**
+ * Calibrate the TSC against the PIT; call early with interrupts off
+ * @return: 1 on success, 0 if the PIT did not respond (the default rate stays in use)
+ */
+uint32_t clock_init(void) {
+    uint32_t latch = PIT_FREQUENCY_HZ * CLOCK_CALIBRATE_MS / 1000;
+    uint64_t best = 0;
+    uint32_t i;
+    uint32_t eax, ebx, ecx, edx;
+    clock_boot_cycles = rdtsc();
+    for (i = 0; i < CLOCK_CALIBRATE_RUNS; i++) {
+        uint64_t cycles = clock_calibrate_once(latch);
+        /* Interruptions only stretch a window, so the shortest is the most accurate */
+        if (cycles != 0 && (best == 0 || cycles < best)) {
+            best = cycles;
+        }
+    }
+    if (best == 0) {
+        serial_puts("[CLOCK] ERROR: PIT calibration timed out, assuming 1 GHz TSC\n");
+        return 0;
+    }
+    /* cycles per ms = cycles * PIT Hz / (latch * 1000) */
+    clock_khz = (uint32_t)udiv64(udiv64(best * PIT_FREQUENCY_HZ, latch), 1000);
+    kprintf("[CLOCK] TSC %u.%03u MHz", clock_khz / 1000, clock_khz % 1000);
+    cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+    if (eax >= 0x80000007) {
+        cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        serial_puts(edx & (1 << 8) ? " (invariant)\n" : " (not invariant: rate may follow CPU frequency)\n");
+    }
+    else {
+        serial_puts("\n");
+    }
+    return 1;
+}
+
+/**
+ * Program PIT channel 0 to raise IRQ 0 periodically
+ * @param hz: Requested interrupt rate
+ * @return: Rate actually programmed, after rounding the divisor
+ */
+uint32_t clock_pit_periodic(uint32_t hz) {
+    uint32_t divisor = hz ? (PIT_FREQUENCY_HZ + hz / 2) / hz : 0xFFFF;
+    if (divisor == 0) {
+        divisor = 1;
+    }
+    if (divisor > 0xFFFF) {
+        divisor = 0xFFFF;
+    }
+    outb(PIT_COMMAND, PIT_CH0_PERIODIC);
+    outb(PIT_CHANNEL0, divisor & 0xFF);
+    outb(PIT_CHANNEL0, (divisor >> 8) & 0xFF);
+    return PIT_FREQUENCY_HZ / divisor;
+}
+
+//Calibrated TSC rate in kHz (cycles per millisecond)
+uint32_t clock_tsc_khz(void) {
+    return clock_khz;
+}
+
+/**
+ * Convert a TSC cycle count to nanoseconds
+ * Split into whole milliseconds and a remainder so nothing overflows 64 bits.
+ * @param cycles: Cycle count, usually a difference of clock_cycles() readings
+ * @return: Nanoseconds
+ */
+uint64_t clock_cycles_to_ns(uint64_t cycles) {
+    uint64_t ms = udiv64(cycles, clock_khz);
+    uint32_t rest = (uint32_t)(cycles - ms * clock_khz);
+    return ms * 1000000 + udiv64((uint64_t)rest * 1000000, clock_khz);
+}
+
+//Nanoseconds since clock_init() at a raw TSC reading, e.g. a trace timestamp
+uint64_t clock_tsc_to_ns(uint64_t tsc) {
+    return clock_cycles_to_ns(tsc - clock_boot_cycles);
+}
+
+//Nanoseconds since clock_init()
+uint64_t clock_now_ns(void) {
+    return clock_tsc_to_ns(rdtsc());
+}
+
+/**
+ * Busy-wait for at least the given time
+ * @param ns: Nanoseconds to wait
+ */
+void clock_delay_ns(uint64_t ns) {
+    uint64_t start = rdtsc();
+    while (clock_cycles_to_ns(rdtsc() - start) < ns) {
+        cpu_relax();
+    }
+}
+
+void clock_delay_us(uint32_t us) {
+    clock_delay_ns((uint64_t)us * 1000);
+}
+
+//Print a duration as milliseconds with three decimals
+void clock_put_ms(uint64_t ns) {
+    uint64_t us = udiv64(ns, 1000);
+    uint64_t ms = udiv64(us, 1000);
+    kprintf("%llu.%03u ms", ms, (uint32_t)(us - ms * 1000));
+}
\ No newline at end of file
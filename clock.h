@@ -0,0 +1,28 @@
+/* clock.h - TSC-based monotonic clock calibrated against the PIT */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "types.h"
+#include "cpu.h"
+
+#define PIT_FREQUENCY_HZ      1193182
+#define CLOCK_CALIBRATE_MS    10        /* Length of one PIT calibration window */
+#define CLOCK_CALIBRATE_RUNS  3         /* Windows measured; the shortest wins */
+#define CLOCK_DEFAULT_KHZ     1000000   /* Assumed until clock_init() succeeds */
+
+//Function declarations
+uint32_t clock_init(void);
+uint32_t clock_pit_periodic(uint32_t hz);
+uint32_t clock_tsc_khz(void);
+uint64_t clock_cycles_to_ns(uint64_t cycles);
+uint64_t clock_tsc_to_ns(uint64_t tsc);
+uint64_t clock_now_ns(void);
+void clock_delay_ns(uint64_t ns);
+void clock_delay_us(uint32_t us);
+void clock_put_ms(uint64_t ns);
+
+/* Raw TSC read for interval timing; convert differences with clock_cycles_to_ns() */
+static inline uint64_t clock_cycles(void) {
+    return rdtsc();
+}
+#endif
\ No newline at end of file
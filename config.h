@@ -0,0 +1,39 @@
+/* config.h - Build-time kernel configuration
+ *
+ * Values normally come from the Makefile, e.g.
+ *     make POLICY=rr MAX_PROCS=1024 MAX_BLOCKS=1024
+ * and the defaults below apply when a file is built without them.
+ */
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/* Process table slots (including the null process) */
+#ifndef CONFIG_MAX_PROCS
+#define CONFIG_MAX_PROCS            256
+#endif
+
+/* Memory allocator block descriptors; every process holds a stack and a heap block */
+#ifndef CONFIG_MAX_MEMORY_BLOCKS
+#define CONFIG_MAX_MEMORY_BLOCKS    (2 * CONFIG_MAX_PROCS)
+#endif
+
+/*
+ * CONFIG_SCHED_POLICY: 0 = FCFS, 1 = RR, 2 = MLFQ (values of scheduling_algorithm_t).
+ * When defined, the policy is compiled into the scheduler hot path and
+ * scheduler_init() cannot switch to another one. Leave undefined to
+ * choose the policy at run time.
+ */
+
+#if CONFIG_MAX_PROCS < 2 || CONFIG_MAX_PROCS > 65536
+#error "CONFIG_MAX_PROCS must be between 2 and 65536"
+#endif
+
+#if CONFIG_MAX_MEMORY_BLOCKS < 1
+#error "CONFIG_MAX_MEMORY_BLOCKS must be at least 1"
+#endif
+
+#if defined(CONFIG_SCHED_POLICY) && (CONFIG_SCHED_POLICY < 0 || CONFIG_SCHED_POLICY > 2)
+#error "CONFIG_SCHED_POLICY must be 0 (FCFS), 1 (RR) or 2 (MLFQ)"
+#endif
+
+#endif
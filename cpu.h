@@ -0,0 +1,88 @@
+/* cpu.h - x86 CPU feature and model-specific register helpers */
+#ifndef CPU_H
+#define CPU_H
+
+#include "types.h"
+
+#define CPUID_FEAT_EDX_APIC  (1 << 9)
+#define MSR_IA32_APIC_BASE   0x1B
+#define EFLAGS_IF            (1 << 9)
+
+static inline void cpuid(uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+    __asm__ volatile ("cpuid"
+                      : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                      : "a"(leaf), "c"(0));
+}
+
+#ifdef KACCHI_HOSTED
+/* Hosted builds run in user mode: privileged instructions become no-ops */
+static inline uint64_t rdmsr(uint32_t msr) {
+    (void)msr;
+    return 0;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    (void)msr;
+    (void)value;
+}
+#else
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    __asm__ volatile ("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+#endif
+
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#ifdef KACCHI_HOSTED
+static inline uint32_t cpu_save_flags(void) {
+    return EFLAGS_IF;
+}
+
+static inline void cpu_irq_disable(void) {
+    __asm__ volatile ("" : : : "memory");
+}
+
+static inline void cpu_irq_enable(void) {
+    __asm__ volatile ("" : : : "memory");
+}
+
+static inline void cpu_wait_for_interrupt(void) {
+    __asm__ volatile ("" : : : "memory");
+}
+#else
+static inline uint32_t cpu_save_flags(void) {
+    uint32_t flags;
+    __asm__ volatile ("pushfl; popl %0" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void cpu_irq_disable(void) {
+    __asm__ volatile ("cli" : : : "memory");
+}
+
+static inline void cpu_irq_enable(void) {
+    __asm__ volatile ("sti" : : : "memory");
+}
+
+/* Enable interrupts and halt until one arrives; sti's one-instruction delay closes the wakeup race */
+static inline void cpu_wait_for_interrupt(void) {
+    __asm__ volatile ("sti; hlt" : : : "memory");
+}
+#endif
+
+/* Spin-wait hint for busy loops */
+static inline void cpu_relax(void) {
+    __asm__ volatile ("pause" : : : "memory");
+}
+
+#endif
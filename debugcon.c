@@ -0,0 +1,113 @@
+/* debugcon.c - Binary event channel over the QEMU debugcon port
+ *
+ * Text on the serial console costs ~260us per character at 38400 baud.
+ * Port 0xE9 has no baud rate: QEMU appends every byte written to it to the
+ * -debugcon file, so a 16-byte record costs a single rep outsb. The host
+ * turns the capture into CSV or a Chrome trace with tools/decode_trace.py.
+ */
+#include "debugcon.h"
+#include "cpu.h"
+#include "io.h"
+#include "serial.h"
+#include "smp.h"
+#include "spinlock.h"
+#include "kprintf.h"
+
+volatile uint32_t debugcon_active = 0;
+
+static spinlock_t debugcon_lock = SPINLOCK_INIT("debugcon");
+static uint32_t debugcon_present = 0;
+static uint32_t debugcon_tsc_hi = 0xFFFFFFFF;   /* High TSC word last announced by a SYNC */
+static uint32_t debugcon_records = 0;
+
+static inline void debugcon_write(const dbg_record_t *record) {
+    const uint8_t *bytes = (const uint8_t *)record;
+    uint32_t count = DEBUGCON_RECORD_SIZE;
+    __asm__ volatile ("cld; rep outsb"
+                      : "+S"(bytes), "+c"(count)
+                      : "d"((uint16_t)DEBUGCON_PORT)
+                      : "memory");
+}
+
+/**
+ * Probe for the debugcon device
+ * QEMU's debugcon reads back 0xE9; an unclaimed port floats to 0xFF.
+ * @return: 1 if the port is attached, 0 otherwise
+ */
+uint32_t debugcon_init(void) {
+    debugcon_present = inb(DEBUGCON_PORT) == DEBUGCON_PORT;
+    return debugcon_present;
+}
+
+/**
+ * Start or stop writing records
+ * @param enabled: Non-zero to start
+ * @return: 1 on success, 0 if the port is not attached
+ */
+uint32_t debugcon_set_enabled(uint32_t enabled) {
+    uint32_t flags;
+    if (enabled && !debugcon_present) {
+        serial_puts("[DEBUGCON] ERROR: Port 0xE9 not attached (run QEMU with -debugcon)\n");
+        return 0;
+    }
+    flags = spin_lock_irqsave(&debugcon_lock);
+    debugcon_tsc_hi = 0xFFFFFFFF;       /* Lead the next burst with a SYNC */
+    debugcon_active = enabled ? 1 : 0;
+    spin_unlock_irqrestore(&debugcon_lock, flags);
+    return 1;
+}
+
+/**
+ * Fill in a wire record
+ * @param record: Destination
+ * @param type: dbg_event_type_t
+ * @param cpu: CPU the event happened on
+ * @param arg: 16-bit argument
+ * @param tsc: Full time stamp; only the low word is stored
+ * @param a: First 32-bit argument
+ * @param b: Second 32-bit argument
+ */
+void debugcon_encode(dbg_record_t *record, uint32_t type, uint32_t cpu, uint32_t arg,
+                     uint64_t tsc, uint32_t a, uint32_t b) {
+    record->type = (uint8_t)type;
+    record->cpu = (uint8_t)cpu;
+    record->arg = (uint16_t)arg;
+    record->tsc_lo = (uint32_t)tsc;
+    record->a = a;
+    record->b = b;
+}
+
+/**
+ * Write one event; use debugcon_emit() at call sites
+ * Records from all CPUs share the port, so a lock keeps them whole. The TSC
+ * is read under the lock so the stream is in time order.
+ */
+void debugcon_event(uint32_t type, uint32_t arg, uint32_t a, uint32_t b) {
+    dbg_record_t record;
+    uint32_t cpu = smp_cpu_id();
+    uint32_t flags = spin_lock_irqsave(&debugcon_lock);
+    uint64_t tsc;
+    if (!debugcon_active) {
+        spin_unlock_irqrestore(&debugcon_lock, flags);
+        return;
+    }
+    tsc = rdtsc();
+    if ((uint32_t)(tsc >> 32) != debugcon_tsc_hi) {
+        debugcon_tsc_hi = (uint32_t)(tsc >> 32);
+        debugcon_encode(&record, DBG_EV_SYNC, cpu, 0, tsc, debugcon_tsc_hi, 0);
+        debugcon_write(&record);
+        debugcon_records++;
+    }
+    debugcon_encode(&record, type, cpu, arg, tsc, a, b);
+    debugcon_write(&record);
+    debugcon_records++;
+    spin_unlock_irqrestore(&debugcon_lock, flags);
+}
+
+//Print channel state
+void debugcon_print_status(void) {
+    kprintf("\n=== Binary Trace (port 0x%X) ===\n", DEBUGCON_PORT);
+    kprintf("Port:    %s\n", debugcon_present ? "attached" : "not attached");
+    kprintf("State:   %s\n", debugcon_active ? "recording" : "off");
+    kprintf("Records: %u (%u bytes)\n\n", debugcon_records, debugcon_records * DEBUGCON_RECORD_SIZE);
+}
\ No newline at end of file
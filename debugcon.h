@@ -0,0 +1,48 @@
+/* debugcon.h - Binary event channel over the QEMU debugcon port */
+#ifndef DEBUGCON_H
+#define DEBUGCON_H
+
+#include "types.h"
+
+#define DEBUGCON_PORT         0xE9      /* QEMU -debugcon / Bochs port e9 hack */
+#define DEBUGCON_RECORD_SIZE  16
+
+//Event types; tools/decode_trace.py mirrors these values
+typedef enum {
+    DBG_EV_SYNC = 0,                    /* a = upper 32 bits of the TSC from here on */
+    DBG_EV_SWITCH = 1,                  /* arg = trace_reason_t, a = from pid, b = to pid */
+    DBG_EV_ALLOC = 2,                   /* arg = pid, a = address, b = size */
+    DBG_EV_FREE = 3,                    /* arg = pid, a = address, b = size */
+    DBG_EV_IRQ_ENTER = 4,               /* arg = IRQ line, a = interrupted eip */
+    DBG_EV_IRQ_EXIT = 5,                /* arg = IRQ line */
+    DBG_EV_MARK = 6                     /* Free-form marker: arg, a and b chosen by the caller */
+} dbg_event_type_t;
+
+//One record on the wire, little-endian (16 bytes)
+typedef struct {
+    uint8_t type;
+    uint8_t cpu;
+    uint16_t arg;
+    uint32_t tsc_lo;                    /* Low TSC word; the high word comes from DBG_EV_SYNC */
+    uint32_t a;
+    uint32_t b;
+} __attribute__((packed)) dbg_record_t;
+
+//Non-zero while records are being written; checked inline so disabled hooks cost one load
+extern volatile uint32_t debugcon_active;
+
+//Function declarations
+uint32_t debugcon_init(void);
+uint32_t debugcon_set_enabled(uint32_t enabled);
+void debugcon_encode(dbg_record_t *record, uint32_t type, uint32_t cpu, uint32_t arg,
+                     uint64_t tsc, uint32_t a, uint32_t b);
+void debugcon_event(uint32_t type, uint32_t arg, uint32_t a, uint32_t b);
+void debugcon_print_status(void);
+
+/* Hook used at event sites; a no-op unless the channel is enabled */
+static inline void debugcon_emit(uint32_t type, uint32_t arg, uint32_t a, uint32_t b) {
+    if (debugcon_active) {
+        debugcon_event(type, arg, a, b);
+    }
+}
+#endif
\ No newline at end of file
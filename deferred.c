@@ -0,0 +1,280 @@
+/* deferred.c - Deferred work queues (bottom halves) and kernel worker processes
+ *
+ * Interrupt handlers acknowledge the hardware, stash what they read and
+ * queue a deferred_work_t; the work runs later with interrupts enabled.
+ * Each CPU has its own lock-free MPSC queue. Work queued from an interrupt
+ * normally runs as that interrupt exits, after the EOI, so other
+ * interrupts can nest over it. Each exit runs at most DEFERRED_IRQ_BUDGET
+ * items and hands the rest to the CPU's worker process, so a burst cannot
+ * hold up the interrupted code for long.
+ *
+ * Processes still do not run their own code. deferred_worker_run() is the
+ * worker's body: the null process calls it from its idle loop, and it
+ * blocks the worker again once the queue is empty.
+ */
+#include "deferred.h"
+#include "process.h"
+#include "scheduler.h"
+#include "smp.h"
+#include "clock.h"
+#include "cpu.h"
+#include "latency.h"
+#include "serial.h"
+#include "kprintf.h"
+#include "string.h"
+#include "math64.h"
+
+typedef struct {
+    mpsc_queue_t queue;
+    atomic_t depth;                   /* Queued and not yet popped */
+    volatile uint32_t running;        /* A drain is in progress; nested interrupt exits skip theirs */
+    uint32_t worker_pid;              /* 0 when there is no worker */
+    uint32_t worker_awake;            /* Woken for leftover work and not blocked again yet */
+    deferred_stats_t stats;
+} deferred_cpu_t;
+
+static deferred_cpu_t deferred_cpus[SMP_MAX_CPUS];
+static volatile uint32_t deferred_ready = 0;
+
+/* Claim the CPU's queue for draining; interrupts are off while the flag is tested */
+static uint32_t deferred_claim(deferred_cpu_t *cpu) {
+    uint32_t flags = cpu_save_flags();
+    uint32_t claimed = 0;
+    cpu_irq_disable();
+    if (flags & EFLAGS_IF) {
+        latency_irqs_off((uint32_t)(uintptr_t)deferred_claim);
+    }
+    if (!cpu->running) {
+        cpu->running = 1;
+        claimed = 1;
+    }
+    if (flags & EFLAGS_IF) {
+        latency_irqs_on((uint32_t)(uintptr_t)deferred_claim);
+        cpu_irq_enable();
+    }
+    return claimed;
+}
+
+/* Run up to budget items (0 = until empty); the caller has claimed the queue */
+static uint32_t deferred_drain(deferred_cpu_t *cpu, uint32_t budget, uint32_t *counter) {
+    uint32_t ran = 0;
+    while (budget == 0 || ran < budget) {
+        mpsc_node_t *node = mpsc_pop(&cpu->queue);
+        deferred_work_t *work;
+        uint64_t latency;
+        if (node == NULL) {
+            break;
+        }
+        work = container_of(node, deferred_work_t, node);
+        latency = clock_cycles() - work->queued_at;
+        atomic_dec(&cpu->depth);
+        cpu->stats.latency_total += latency;
+        if (latency > cpu->stats.latency_max) {
+            cpu->stats.latency_max = latency > 0xFFFFFFFFULL ? 0xFFFFFFFF : (uint32_t)latency;
+        }
+        /* Cleared first so the work may queue itself again */
+        atomic_set(&work->pending, 0);
+        work->func(work->arg);
+        ran++;
+    }
+    *counter += ran;
+    return ran;
+}
+
+/* Interrupts are disabled */
+static void deferred_wake_worker(deferred_cpu_t *cpu) {
+    if (cpu->worker_pid != 0 && !cpu->worker_awake) {
+        cpu->worker_awake = 1;
+        cpu->stats.worker_wakeups++;
+        scheduler_wake(cpu->worker_pid);
+    }
+}
+
+//Empty every queue and start one blocked worker process per online CPU (after scheduler_init and smp_init)
+void deferred_init(void) {
+    uint32_t i;
+    deferred_ready = 0;
+    memset(deferred_cpus, 0, sizeof(deferred_cpus));
+    for (i = 0; i < SMP_MAX_CPUS; i++) {
+        mpsc_init(&deferred_cpus[i].queue);
+    }
+    deferred_ready = 1;
+    for (i = 0; i < smp_cpu_count(); i++) {
+        uint32_t pid = process_create(DEFERRED_WORKER_PRIO, DEFERRED_WORKER_STACK, DEFERRED_WORKER_STACK);
+        if (pid == 0 || !scheduler_block(pid)) {
+            serial_puts("[DEFERRED] ERROR: Could not start worker process\n");
+            continue;
+        }
+        deferred_cpus[i].worker_pid = pid;
+    }
+    kprintf("[DEFERRED] %u worker process(es), %u items per interrupt exit\n",
+            smp_cpu_count(), DEFERRED_IRQ_BUDGET);
+}
+
+/**
+ * Prepare a work item that is not queued
+ * @param work: Item to set up
+ * @param func: Runs with interrupts enabled; it may only take locks that are always taken irqsave
+ * @param arg: Passed to func
+ */
+void deferred_work_init(deferred_work_t *work, deferred_func_t func, void *arg) {
+    work->node.next = NULL;
+    work->func = func;
+    work->arg = arg;
+    atomic_set(&work->pending, 0);
+    work->queued_at = 0;
+}
+
+/**
+ * Queue work on the calling CPU; safe from interrupt handlers
+ * Before deferred_init() the work runs immediately instead.
+ * @param work: Set-up work item
+ * @return: 1 if queued, 0 if it was already pending (it then runs once for both)
+ */
+uint32_t deferred_queue(deferred_work_t *work) {
+    deferred_cpu_t *cpu = &deferred_cpus[smp_cpu_id()];
+    uint32_t depth;
+    if (!atomic_cmpxchg(&work->pending, 0, 1)) {
+        __sync_fetch_and_add(&cpu->stats.already_pending, 1);
+        return 0;
+    }
+    if (!deferred_ready) {
+        atomic_set(&work->pending, 0);
+        work->func(work->arg);
+        return 1;
+    }
+    work->queued_at = clock_cycles();
+    depth = atomic_inc(&cpu->depth);
+    if (depth > cpu->stats.max_depth) {
+        cpu->stats.max_depth = depth;
+    }
+    __sync_fetch_and_add(&cpu->stats.queued, 1);
+    mpsc_push(&cpu->queue, &work->node);
+    return 1;
+}
+
+/*
+ * Called by interrupt_dispatch() after the EOI with interrupts disabled.
+ * Runs a budget of this CPU's work with interrupts enabled and wakes the
+ * worker if any is left. Exits of interrupts nested over a drain skip it.
+ */
+void deferred_irq_exit(void) {
+    deferred_cpu_t *cpu;
+    uint32_t flags;
+    if (!deferred_ready) {
+        return;
+    }
+    cpu = &deferred_cpus[smp_cpu_id()];
+    if (atomic_read(&cpu->depth) == 0 || cpu->running) {
+        return;
+    }
+    cpu->running = 1;
+    flags = cpu_save_flags();
+    cpu_irq_enable();
+    deferred_drain(cpu, DEFERRED_IRQ_BUDGET, &cpu->stats.run_irq_exit);
+    if (!(flags & EFLAGS_IF)) {
+        cpu_irq_disable();
+    }
+    cpu->running = 0;
+    if (atomic_read(&cpu->depth) != 0) {
+        deferred_wake_worker(cpu);
+    }
+}
+
+/**
+ * Worker body: run everything queued on the calling CPU, then block the worker
+ * @return: Items run; 0 if the queue was empty or is being drained already
+ */
+uint32_t deferred_worker_run(void) {
+    deferred_cpu_t *cpu;
+    uint32_t ran;
+    uint32_t flags;
+    if (!deferred_ready) {
+        return 0;
+    }
+    cpu = &deferred_cpus[smp_cpu_id()];
+    if (atomic_read(&cpu->depth) == 0 || !deferred_claim(cpu)) {
+        return 0;
+    }
+    ran = deferred_drain(cpu, 0, &cpu->stats.run_worker);
+    /* With interrupts off, so an interrupt exit cannot leave work between the check and the block */
+    flags = cpu_save_flags();
+    cpu_irq_disable();
+    if (flags & EFLAGS_IF) {
+        latency_irqs_off((uint32_t)(uintptr_t)deferred_worker_run);
+    }
+    cpu->running = 0;
+    if (cpu->worker_awake && atomic_read(&cpu->depth) == 0) {
+        cpu->worker_awake = 0;
+        scheduler_block(cpu->worker_pid);
+    }
+    if (flags & EFLAGS_IF) {
+        latency_irqs_on((uint32_t)(uintptr_t)deferred_worker_run);
+        cpu_irq_enable();
+    }
+    return ran;
+}
+
+//Worker process of a CPU, 0 if it has none
+uint32_t deferred_worker_pid(uint32_t cpu) {
+    return cpu < SMP_MAX_CPUS ? deferred_cpus[cpu].worker_pid : 0;
+}
+
+//The process table was reset and the workers with it; queued work still runs on interrupt exit
+void deferred_forget_workers(void) {
+    uint32_t i;
+    for (i = 0; i < SMP_MAX_CPUS; i++) {
+        deferred_cpus[i].worker_pid = 0;
+        deferred_cpus[i].worker_awake = 0;
+    }
+}
+
+/**
+ * Stop waking a worker process that was terminated
+ * @param pid: Process that exited
+ */
+void deferred_process_exit(uint32_t pid) {
+    uint32_t i;
+    if (pid == 0) {
+        return;
+    }
+    for (i = 0; i < SMP_MAX_CPUS; i++) {
+        if (deferred_cpus[i].worker_pid == pid) {
+            deferred_cpus[i].worker_pid = 0;
+            deferred_cpus[i].worker_awake = 0;
+        }
+    }
+}
+
+/**
+ * Copy one CPU's counters
+ * @param cpu: Logical CPU index
+ * @param stats: Filled in; all zero for an invalid CPU
+ */
+void deferred_get_stats(uint32_t cpu, deferred_stats_t *stats) {
+    if (cpu >= SMP_MAX_CPUS) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = deferred_cpus[cpu].stats;
+    stats->depth = atomic_read(&deferred_cpus[cpu].depth);
+}
+
+//Print per-CPU queue depth, where work ran and how long it waited
+void deferred_print_stats(void) {
+    uint32_t i;
+    serial_puts("\n=== Deferred Work ===\n");
+    serial_puts("CPU | Worker | Depth | Max depth | Queued     | Folded  | IRQ exit   | By worker  | Wakeups | Avg wait ns | Max wait ns\n");
+    for (i = 0; i < smp_cpu_count(); i++) {
+        deferred_stats_t stats;
+        uint32_t ran;
+        deferred_get_stats(i, &stats);
+        ran = stats.run_irq_exit + stats.run_worker;
+        kprintf("%3u | %6u | %5u | %9u | %10u | %7u | %10u | %10u | %7u | %11llu | %11llu\n",
+                i, deferred_cpus[i].worker_pid, stats.depth, stats.max_depth, stats.queued,
+                stats.already_pending, stats.run_irq_exit, stats.run_worker, stats.worker_wakeups,
+                ran ? clock_cycles_to_ns(udiv64(stats.latency_total, ran)) : 0ULL,
+                clock_cycles_to_ns(stats.latency_max));
+    }
+    serial_puts("\n");
+}
\ No newline at end of file
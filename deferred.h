@@ -0,0 +1,49 @@
+/* deferred.h - Deferred work queues (bottom halves) and kernel worker processes */
+#ifndef DEFERRED_H
+#define DEFERRED_H
+
+#include "types.h"
+#include "spinlock.h"
+
+#define DEFERRED_IRQ_BUDGET   16        /* Items run on interrupt exit before the rest goes to the worker */
+#define DEFERRED_WORKER_PRIO  0         /* Workers outrank every normal process */
+#define DEFERRED_WORKER_STACK 4096      /* Also the worker's heap size */
+
+typedef void (*deferred_func_t)(void *arg);
+
+//A unit of deferred work; queued at most once at a time, like a tasklet
+typedef struct {
+    mpsc_node_t node;                 /* Link in the per-CPU queue */
+    deferred_func_t func;
+    void *arg;
+    atomic_t pending;                 /* 1 from deferred_queue() until func starts */
+    uint64_t queued_at;               /* clock_cycles() when queued */
+} deferred_work_t;
+
+//Per-CPU counters
+typedef struct {
+    uint32_t queued;                  /* Items accepted by deferred_queue() */
+    uint32_t already_pending;         /* deferred_queue() calls folded into a queued item */
+    uint32_t run_irq_exit;            /* Items run on interrupt exit */
+    uint32_t run_worker;              /* Items run by the worker process */
+    uint32_t worker_wakeups;          /* Times the worker was woken for leftover work */
+    uint32_t depth;                   /* Items queued now */
+    uint32_t max_depth;
+    uint32_t latency_max;             /* Longest queue-to-start delay, in TSC cycles */
+    uint64_t latency_total;
+} deferred_stats_t;
+
+#define DEFERRED_WORK_INIT(work_func, work_arg) { { NULL }, (work_func), (work_arg), ATOMIC_INIT(0), 0 }
+
+//Function declarations
+void deferred_init(void);
+void deferred_work_init(deferred_work_t *work, deferred_func_t func, void *arg);
+uint32_t deferred_queue(deferred_work_t *work);
+void deferred_irq_exit(void);
+uint32_t deferred_worker_run(void);
+uint32_t deferred_worker_pid(uint32_t cpu);
+void deferred_forget_workers(void);
+void deferred_process_exit(uint32_t pid);
+void deferred_get_stats(uint32_t cpu, deferred_stats_t *stats);
+void deferred_print_stats(void);
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+/* gdt.c - Global descriptor table and per-CPU task state segments
+ *
+ * Replaces the boot loader's GDT with flat 4GB kernel and user segments
+ * plus one TSS per CPU. The TSS only supplies the ring 0 stack the CPU
+ * switches to when an interrupt or int 0x80 arrives from ring 3.
+ */
+#include "gdt.h"
+#include "smp.h"
+#include "string.h"
+#include "serial.h"
+
+#define GDT_ENTRIES         (GDT_TSS_BASE / 8 + SMP_MAX_CPUS)
+
+//Access bytes, with the accessed bit preset as the CPU would set it on first load
+#define GDT_ACCESS_KCODE    0x9B      /* Present, ring 0, code, readable */
+#define GDT_ACCESS_KDATA    0x93      /* Present, ring 0, data, writable */
+#define GDT_ACCESS_UCODE    0xFB      /* Same at ring 3 */
+#define GDT_ACCESS_UDATA    0xF3
+#define GDT_ACCESS_TSS      0x89      /* Present, ring 0, available 32-bit TSS */
+#define GDT_TSS_BUSY        0x02      /* Set by ltr in the access byte */
+#define GDT_FLAGS_FLAT      0xC       /* 4KB granularity, 32-bit */
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) gdt_pointer_t;
+
+static uint64_t gdt[GDT_ENTRIES] __attribute__((aligned(8)));
+static tss_t tss[SMP_MAX_CPUS];
+
+static uint64_t gdt_descriptor(uint32_t base, uint32_t limit, uint8_t access, uint8_t flags) {
+    uint64_t desc = (limit & 0xFFFF) | ((uint64_t)(base & 0xFFFFFF) << 16);
+    desc |= (uint64_t)access << 40;
+    desc |= (uint64_t)((limit >> 16) & 0xF) << 48;
+    desc |= (uint64_t)(flags & 0xF) << 52;
+    desc |= (uint64_t)(base >> 24) << 56;
+    return desc;
+}
+
+//Build the table and load it on the boot CPU
+void gdt_init(void) {
+    uint32_t cpu;
+    memset(gdt, 0, sizeof(gdt));
+    memset(tss, 0, sizeof(tss));
+    gdt[GDT_KERNEL_CODE / 8] = gdt_descriptor(0, 0xFFFFF, GDT_ACCESS_KCODE, GDT_FLAGS_FLAT);
+    gdt[GDT_KERNEL_DATA / 8] = gdt_descriptor(0, 0xFFFFF, GDT_ACCESS_KDATA, GDT_FLAGS_FLAT);
+    gdt[GDT_USER_CODE / 8] = gdt_descriptor(0, 0xFFFFF, GDT_ACCESS_UCODE, GDT_FLAGS_FLAT);
+    gdt[GDT_USER_DATA / 8] = gdt_descriptor(0, 0xFFFFF, GDT_ACCESS_UDATA, GDT_FLAGS_FLAT);
+    for (cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        tss[cpu].ss0 = GDT_KERNEL_DATA;
+        tss[cpu].iomap_base = sizeof(tss_t);
+        gdt[GDT_TSS_BASE / 8 + cpu] = gdt_descriptor((uint32_t)&tss[cpu], sizeof(tss_t) - 1, GDT_ACCESS_TSS, 0);
+    }
+    gdt_init_cpu(0);
+    serial_puts("[GDT] Kernel and user segments loaded\n");
+}
+
+/**
+ * Load the GDT and this CPU's TSS on the calling CPU
+ * @param cpu: Logical index of the calling CPU
+ */
+void gdt_init_cpu(uint32_t cpu) {
+    gdt_pointer_t pointer;
+    uint32_t index = GDT_TSS_BASE / 8 + cpu;
+    pointer.limit = sizeof(gdt) - 1;
+    pointer.base = (uint32_t)gdt;
+    __asm__ volatile ("lgdt %0\n\t"
+                      "ljmp %1, $1f\n"
+                      "1:\n\t"
+                      "mov %2, %%ax\n\t"
+                      "mov %%ax, %%ds\n\t"
+                      "mov %%ax, %%es\n\t"
+                      "mov %%ax, %%fs\n\t"
+                      "mov %%ax, %%gs\n\t"
+                      "mov %%ax, %%ss"
+                      : : "m"(pointer), "i"(GDT_KERNEL_CODE), "i"(GDT_KERNEL_DATA) : "eax", "memory");
+    //ltr faults on a busy TSS, so a reload has to clear the bit it set last time
+    gdt[index] &= ~((uint64_t)GDT_TSS_BUSY << 40);
+    __asm__ volatile ("ltr %w0" : : "r"(GDT_TSS_BASE + cpu * 8));
+}
+
+/**
+ * Set the stack the CPU switches to on entry from ring 3
+ * @param cpu: Logical CPU index
+ * @param esp0: Top of a kernel stack reserved for that CPU
+ */
+void gdt_set_kernel_stack(uint32_t cpu, uint32_t esp0) {
+    tss[cpu].esp0 = esp0;
+}
\ No newline at end of file
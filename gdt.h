@@ -0,0 +1,34 @@
+/* gdt.h - Global descriptor table and per-CPU task state segments */
+#ifndef GDT_H
+#define GDT_H
+
+#include "types.h"
+
+/*
+ * Selectors. SYSENTER/SYSEXIT derive every segment from the kernel code
+ * selector, so kernel code, kernel data, user code and user data must stay
+ * consecutive in this order.
+ */
+#define GDT_KERNEL_CODE     0x08
+#define GDT_KERNEL_DATA     0x10
+#define GDT_USER_CODE       0x1B      /* 0x18 | RPL 3 */
+#define GDT_USER_DATA       0x23      /* 0x20 | RPL 3 */
+#define GDT_TSS_BASE        0x28      /* One TSS descriptor per CPU from here */
+
+#define EFLAGS_RESERVED     (1 << 1)  /* Always set */
+
+//32-bit task state segment; only the ring 0 stack fields are used
+typedef struct {
+    uint32_t link;
+    uint32_t esp0;
+    uint32_t ss0;
+    uint32_t unused[22];              /* esp1 .. ldt */
+    uint16_t trap;
+    uint16_t iomap_base;              /* Past the limit: no I/O bitmap, ring 3 port access faults */
+} __attribute__((packed)) tss_t;
+
+//Function declarations
+void gdt_init(void);
+void gdt_init_cpu(uint32_t cpu);
+void gdt_set_kernel_stack(uint32_t cpu, uint32_t esp0);
+#endif
\ No newline at end of file
@@ -0,0 +1,283 @@
+/* fuzz_ops.c - Fuzz allocator/process/scheduler operation sequences (make host-fuzz)
+ *
+ * Each input byte string is decoded into operations. A shadow copy of every
+ * live allocation is checked after each one: blocks must stay inside the
+ * process heap and never overlap, processes must stay in a live state, the
+ * CPU must run a live process, and once everything is released the whole
+ * heap must be allocatable again. Violations abort, which libFuzzer (or the
+ * standalone driver below) reports as a crash.
+ *
+ * Build with libFuzzer: make host-fuzz HOST_CC=clang HOST_SAN=-fsanitize=fuzzer,address
+ * Standalone:           make host-fuzz && host-build/kacchi-fuzz [-runs=N] [-seed=S] [inputs...]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+#include "process.h"
+#include "scheduler.h"
+#include "serial.h"
+
+#define FUZZ_ORPHAN_PID   60000u     /* Allocation owners that are never real processes */
+#define FUZZ_MAX_PROCS    64
+
+//One live allocation as the harness believes it to be
+typedef struct {
+    uint32_t address;
+    uint32_t size;
+    uint32_t owner;
+} fuzz_block_t;
+
+static fuzz_block_t shadow[MAX_MEMORY_BLOCKS];
+static uint32_t shadow_count;
+static uint32_t live_pids[FUZZ_MAX_PROCS];
+static uint32_t live_count;
+static uint64_t fuzz_ops_run;
+
+static void fuzz_fail(const char *what, uint32_t a, uint32_t b) {
+    fprintf(stderr, "fuzz_ops: invariant violated: %s (0x%X, 0x%X)\n", what, a, b);
+    abort();
+}
+
+static void shadow_add(uint32_t address, uint32_t size, uint32_t owner) {
+    uint32_t i;
+    if (address < PROCESS_HEAP_START || size > PROCESS_HEAP_START + PROCESS_HEAP_SIZE - address) {
+        fuzz_fail("block outside the process heap", address, size);
+    }
+    for (i = 0; i < shadow_count; i++) {
+        if (address < shadow[i].address + shadow[i].size && shadow[i].address < address + size) {
+            fuzz_fail("overlapping blocks", address, shadow[i].address);
+        }
+    }
+    if (shadow_count == MAX_MEMORY_BLOCKS) {
+        fuzz_fail("more live blocks than descriptors", shadow_count, 0);
+    }
+    shadow[shadow_count].address = address;
+    shadow[shadow_count].size = size;
+    shadow[shadow_count].owner = owner;
+    shadow_count++;
+}
+
+static void shadow_remove_owner(uint32_t owner) {
+    uint32_t i = 0;
+    while (i < shadow_count) {
+        if (shadow[i].owner == owner) {
+            shadow[i] = shadow[--shadow_count];
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+static void fuzz_check_processes(void) {
+    uint32_t i;
+    uint32_t current = scheduler_current_process();
+    uint32_t current_live = current == 0;
+    for (i = 0; i < live_count; i++) {
+        process_state_t state = process_get_state(live_pids[i]);
+        if (state != READY && state != CURRENT && state != BLOCKED) {
+            fuzz_fail("live process lost its state", live_pids[i], state);
+        }
+        if (live_pids[i] == current) {
+            current_live = 1;
+            if (state != CURRENT) {
+                fuzz_fail("running process is not CURRENT", current, state);
+            }
+        }
+    }
+    if (!current_live) {
+        fuzz_fail("CPU runs a process that is not live", current, 0);
+    }
+}
+
+static void fuzz_reset(scheduling_algorithm_t algorithm) {
+    uint32_t muted = serial_set_muted(1);
+    memory_init();
+    process_init();
+    scheduler_init(algorithm, 1 + algorithm);
+    serial_set_muted(muted);
+    shadow_count = 0;
+    live_count = 0;
+}
+
+/* Release everything and check that no block leaked */
+static void fuzz_drain(void) {
+    uint32_t address;
+    while (live_count > 0) {
+        process_terminate(live_pids[--live_count]);
+    }
+    while (shadow_count > 0) {
+        memory_free(shadow[--shadow_count].address);
+    }
+    address = memory_allocate(PROCESS_HEAP_SIZE, FUZZ_ORPHAN_PID);
+    if (address != PROCESS_HEAP_START) {
+        fuzz_fail("heap not fully reusable after releasing everything", address, 0);
+    }
+    memory_free(address);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    size_t i = 1;
+    uint32_t muted;
+    if (size == 0) {
+        return 0;
+    }
+    fuzz_reset((scheduling_algorithm_t)(data[0] % 3));
+    muted = serial_set_muted(1);
+    while (i + 3 <= size) {
+        uint8_t op = data[i] % 9;
+        uint8_t a = data[i + 1];
+        uint8_t b = data[i + 2];
+        i += 3;
+        fuzz_ops_run++;
+        switch (op) {
+        case 0: {
+            /* Allocate for an orphan owner or for a live process */
+            uint32_t length = ((uint32_t)a << 8 | b) + 1;
+            uint32_t owner = (a & 1) && live_count ? live_pids[b % live_count] : FUZZ_ORPHAN_PID + b % 4;
+            uint32_t address = memory_allocate(length, owner);
+            if (address != 0) {
+                shadow_add(address, length, owner);
+            }
+            break;
+        }
+        case 1:
+            if (shadow_count > 0) {
+                uint32_t pick = a % shadow_count;
+                memory_free(shadow[pick].address);
+                shadow[pick] = shadow[--shadow_count];
+            }
+            break;
+        case 2:
+            /* Bogus or double free of an address nobody holds must change nothing */
+            {
+                uint32_t address = PROCESS_HEAP_START + ((uint32_t)a << 8 | b) * 16;
+                uint32_t held = 0;
+                uint32_t j;
+                for (j = 0; j < shadow_count; j++) {
+                    held |= shadow[j].address == address;
+                }
+                if (!held) {
+                    memory_free(address);
+                }
+            }
+            break;
+        case 3:
+            if (live_count < FUZZ_MAX_PROCS) {
+                uint32_t stack = 256u << (a % 4);
+                uint32_t heap = 256u << (b % 5);
+                uint32_t pid = process_create(a % 8, stack, heap);
+                if (pid != 0) {
+                    process_control_block_t *pcb = process_get_pcb(pid);
+                    live_pids[live_count++] = pid;
+                    shadow_add(pcb->stack_base, stack, pid);
+                    shadow_add(pcb->heap_base, heap, pid);
+                }
+            }
+            break;
+        case 4:
+            if (live_count > 0) {
+                uint32_t pick = a % live_count;
+                uint32_t pid = live_pids[pick];
+                live_pids[pick] = live_pids[--live_count];
+                process_terminate(pid);
+                shadow_remove_owner(pid);
+            }
+            break;
+        case 5:
+            memory_free_process(FUZZ_ORPHAN_PID + a % 4);
+            shadow_remove_owner(FUZZ_ORPHAN_PID + a % 4);
+            break;
+        case 6:
+            if (live_count > 0) {
+                uint32_t pid = live_pids[a % live_count];
+                if (b & 1) {
+                    scheduler_wake(pid);
+                }
+                else {
+                    scheduler_block(pid);
+                }
+            }
+            break;
+        case 7: {
+            uint32_t t;
+            for (t = 0; t <= a % 16; t++) {
+                scheduler_update_time();
+                if (scheduler_need_resched()) {
+                    scheduler_schedule();
+                }
+            }
+            break;
+        }
+        default:
+            if (b & 1) {
+                scheduler_yield();
+            }
+            else {
+                scheduler_schedule();
+            }
+            break;
+        }
+        fuzz_check_processes();
+    }
+    fuzz_drain();
+    serial_set_muted(muted);
+    return 0;
+}
+
+#ifndef KACCHI_LIBFUZZER
+#include <time.h>
+
+/* Standalone driver: replay the given inputs, or run random ones */
+int main(int argc, char **argv) {
+    uint32_t runs = 100000;
+    uint32_t seed = 1;
+    uint32_t files = 0;
+    uint32_t r;
+    uint8_t input[4096];
+    int i;
+    struct timespec begin, end;
+    double seconds;
+    serial_init();
+    for (i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = (uint32_t)strtoul(argv[i] + 6, NULL, 0);
+        }
+        else if (strncmp(argv[i], "-seed=", 6) == 0) {
+            seed = (uint32_t)strtoul(argv[i] + 6, NULL, 0);
+        }
+        else {
+            FILE *file = fopen(argv[i], "rb");
+            size_t length;
+            if (file == NULL) {
+                perror(argv[i]);
+                return 2;
+            }
+            length = fread(input, 1, sizeof(input), file);
+            fclose(file);
+            LLVMFuzzerTestOneInput(input, length);
+            files++;
+        }
+    }
+    if (files > 0) {
+        printf("fuzz_ops: %u inputs OK\n", files);
+        return 0;
+    }
+    srand(seed);
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (r = 0; r < runs; r++) {
+        size_t length = 1 + (size_t)rand() % sizeof(input);
+        size_t k;
+        for (k = 0; k < length; k++) {
+            input[k] = (uint8_t)rand();
+        }
+        LLVMFuzzerTestOneInput(input, length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (double)(end.tv_sec - begin.tv_sec) + (double)(end.tv_nsec - begin.tv_nsec) / 1e9;
+    printf("fuzz_ops: %u runs, %llu ops in %.2fs (%.0f ops/s), no invariant violations\n", runs,
+           (unsigned long long)fuzz_ops_run, seconds, seconds > 0 ? (double)fuzz_ops_run / seconds : 0.0);
+    return 0;
+}
+#endif
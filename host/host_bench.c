@@ -0,0 +1,11 @@
+/* host_bench.c - Native entry point for the microbenchmark suite (make host-bench) */
+#include "serial.h"
+#include "clock.h"
+#include "bench_suite.h"
+
+int main(void) {
+    serial_init();
+    clock_init();
+    run_all_benchmarks();
+    return 0;
+}
@@ -0,0 +1,133 @@
+/* host_shim.c - Linux stand-ins for the hardware-facing kernel interfaces
+ *
+ * The hosted build (make host-bench, host-replay, host-fuzz) links the real
+ * memory, process and scheduler code against this file instead of serial.c
+ * and smp.c. Console output goes to stdout, input comes from stdin, and the
+ * machine looks like a single CPU.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "serial.h"
+#include "smp.h"
+
+static uint32_t host_muted = 0;
+
+//Monotonic host time; clock.c calibrates the TSC against it
+uint64_t host_monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+void serial_init(void) {
+    if (getenv("KACCHI_QUIET") != NULL) {
+        host_muted = 1;
+    }
+}
+
+void serial_enable_irq(void) {
+}
+
+uint32_t serial_write(const char *buf, uint32_t len) {
+    if (!host_muted) {
+        fwrite(buf, 1, len, stdout);
+    }
+    return len;
+}
+
+uint32_t serial_tx_pending(void) {
+    return 0;
+}
+
+void serial_flush(void) {
+    fflush(stdout);
+}
+
+void serial_panic_mode(void) {
+    host_muted = 0;
+    fflush(stdout);
+}
+
+uint32_t serial_set_muted(uint32_t muted) {
+    uint32_t previous = host_muted;
+    host_muted = muted ? 1 : 0;
+    return previous;
+}
+
+void serial_putc(char c) {
+    serial_write(&c, 1);
+}
+
+void serial_puts(const char *str) {
+    if (!host_muted) {
+        fputs(str, stdout);
+    }
+}
+
+char serial_getc(void) {
+    int c = getchar();
+    if (c == EOF) {
+        exit(0);
+    }
+    return (char)c;
+}
+
+int serial_received(void) {
+    return 0;
+}
+
+void serial_rx_input(char c) {
+    (void)c;
+}
+
+uint32_t serial_read_line(char *buf, uint32_t size) {
+    uint32_t len = 0;
+    int c;
+    while ((c = getchar()) != EOF && c != '\n') {
+        if (c != '\r' && len + 1 < size) {
+            buf[len++] = (char)c;
+        }
+    }
+    if (c == EOF && len == 0) {
+        exit(0);
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+void serial_set_raw(uint32_t raw) {
+    (void)raw;
+}
+
+uint32_t serial_rx_overruns(void) {
+    return 0;
+}
+
+void serial_put_hex(uint32_t value) {
+    if (!host_muted) {
+        printf("%X", value);
+    }
+}
+
+void serial_put_dec(uint32_t value) {
+    if (!host_muted) {
+        printf("%u", value);
+    }
+}
+
+//One CPU, already online
+void smp_init(void) {
+}
+
+uint32_t smp_cpu_id(void) {
+    return 0;
+}
+
+uint32_t smp_cpu_count(void) {
+    return 1;
+}
+
+void smp_print_status(void) {
+    serial_puts("\n=== CPUs ===\nHosted build: 1 CPU\n\n");
+}
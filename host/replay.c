@@ -0,0 +1,236 @@
+/* replay.c - Replay allocator/process/scheduler operation traces natively (make host-replay)
+ *
+ * Trace format, one operation per line, '#' starts a comment:
+ *
+ *   alloc <size> <pid>       memory_allocate(); the result becomes allocation #n
+ *   free <n>                 memory_free() of allocation #n
+ *   create <prio> <stack> <heap>   process_create(); the result becomes process #n
+ *   terminate <n>            process_terminate() of process #n
+ *   block <n> / wake <n>     scheduler_block()/scheduler_wake() of process #n
+ *   tick [count]             scheduler_update_time(), then schedule if asked to
+ *   schedule                 scheduler_schedule()
+ *
+ * Allocations and processes are named by creation order, not by address or
+ * PID, so a trace stays valid when the allocator or PID policy changes.
+ *
+ *   kacchi-replay trace.txt [repeat]      replay and report ns/op
+ *   kacchi-replay --generate <ops> [seed] write a random trace to stdout
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+#include "process.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "clock.h"
+
+//Operation kinds
+typedef enum {
+    OP_ALLOC, OP_FREE, OP_CREATE, OP_TERMINATE, OP_BLOCK, OP_WAKE, OP_TICK, OP_SCHEDULE, OP_KINDS
+} replay_kind_t;
+
+static const char *replay_names[OP_KINDS] = {
+    "alloc", "free", "create", "terminate", "block", "wake", "tick", "schedule"
+};
+
+typedef struct {
+    uint8_t kind;
+    uint32_t arg[3];
+} replay_op_t;
+
+static replay_op_t *ops;
+static uint32_t op_count;
+static uint32_t *alloc_addrs;         /* Allocation #n -> address, by replay */
+static uint32_t *proc_pids;           /* Process #n -> PID */
+static uint32_t alloc_total;
+static uint32_t proc_total;
+
+static void replay_load(const char *path) {
+    FILE *file = fopen(path, "r");
+    char line[256];
+    uint32_t capacity = 1024;
+    if (file == NULL) {
+        perror(path);
+        exit(2);
+    }
+    ops = malloc(capacity * sizeof(*ops));
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char name[16];
+        replay_op_t op = { 0, { 0, 0, 0 } };
+        int fields;
+        uint32_t kind;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+        fields = sscanf(line, "%15s %u %u %u", name, &op.arg[0], &op.arg[1], &op.arg[2]);
+        if (fields < 1) {
+            continue;
+        }
+        for (kind = 0; kind < OP_KINDS && strcmp(name, replay_names[kind]) != 0; kind++) {
+        }
+        if (kind == OP_KINDS) {
+            fprintf(stderr, "%s: unknown operation '%s'\n", path, name);
+            exit(2);
+        }
+        op.kind = (uint8_t)kind;
+        if (kind == OP_TICK && fields < 2) {
+            op.arg[0] = 1;
+        }
+        if (kind == OP_ALLOC) {
+            alloc_total++;
+        }
+        if (kind == OP_CREATE) {
+            proc_total++;
+        }
+        if (op_count == capacity) {
+            capacity *= 2;
+            ops = realloc(ops, capacity * sizeof(*ops));
+        }
+        ops[op_count++] = op;
+    }
+    fclose(file);
+    alloc_addrs = calloc(alloc_total + 1, sizeof(*alloc_addrs));
+    proc_pids = calloc(proc_total + 1, sizeof(*proc_pids));
+}
+
+static void replay_reset(void) {
+    uint32_t muted = serial_set_muted(1);
+    memory_init();
+    process_init();
+    scheduler_init(RR, 5);
+    serial_set_muted(muted);
+}
+
+/* Run every operation once; returns scheduler ticks simulated */
+static uint64_t replay_run(void) {
+    uint32_t i, t;
+    uint32_t next_alloc = 0;
+    uint32_t next_proc = 0;
+    uint64_t ticks = 0;
+    for (i = 0; i < op_count; i++) {
+        replay_op_t *op = &ops[i];
+        switch (op->kind) {
+        case OP_ALLOC:
+            alloc_addrs[next_alloc++] = memory_allocate(op->arg[0], op->arg[1]);
+            break;
+        case OP_FREE:
+            if (op->arg[0] < next_alloc && alloc_addrs[op->arg[0]] != 0) {
+                memory_free(alloc_addrs[op->arg[0]]);
+                alloc_addrs[op->arg[0]] = 0;
+            }
+            break;
+        case OP_CREATE:
+            proc_pids[next_proc++] = process_create(op->arg[0], op->arg[1], op->arg[2]);
+            break;
+        case OP_TERMINATE:
+            if (op->arg[0] < next_proc && proc_pids[op->arg[0]] != 0) {
+                process_terminate(proc_pids[op->arg[0]]);
+                proc_pids[op->arg[0]] = 0;
+            }
+            break;
+        case OP_BLOCK:
+            if (op->arg[0] < next_proc && proc_pids[op->arg[0]] != 0) {
+                scheduler_block(proc_pids[op->arg[0]]);
+            }
+            break;
+        case OP_WAKE:
+            if (op->arg[0] < next_proc && proc_pids[op->arg[0]] != 0) {
+                scheduler_wake(proc_pids[op->arg[0]]);
+            }
+            break;
+        case OP_TICK:
+            for (t = 0; t < op->arg[0]; t++) {
+                scheduler_update_time();
+                if (scheduler_need_resched()) {
+                    scheduler_schedule();
+                }
+            }
+            ticks += op->arg[0];
+            break;
+        default:
+            scheduler_schedule();
+            break;
+        }
+    }
+    return ticks;
+}
+
+/* Random but well-formed trace: frees and terminations only name live objects */
+static void replay_generate(uint32_t count, uint32_t seed) {
+    uint32_t live_allocs[MAX_MEMORY_BLOCKS];
+    uint32_t live_procs[MAX_PROCESSES];
+    uint32_t allocs = 0, procs = 0, nallocs = 0, nprocs = 0;
+    uint32_t i;
+    srand(seed);
+    printf("# kacchi-replay --generate %u %u\n", count, seed);
+    for (i = 0; i < count; i++) {
+        uint32_t choice = (uint32_t)rand() % 100;
+        if (choice < 30 && nallocs < MAX_MEMORY_BLOCKS / 2) {
+            printf("alloc %u %u\n", 16u << (rand() % 9), 60000u + (uint32_t)rand() % 8);
+            live_allocs[nallocs++] = allocs++;
+        }
+        else if (choice < 55 && nallocs > 0) {
+            uint32_t pick = (uint32_t)rand() % nallocs;
+            printf("free %u\n", live_allocs[pick]);
+            live_allocs[pick] = live_allocs[--nallocs];
+        }
+        else if (choice < 65 && nprocs < MAX_PROCESSES / 4) {
+            printf("create %u 1024 2048\n", 1u + (uint32_t)rand() % 4);
+            live_procs[nprocs++] = procs++;
+        }
+        else if (choice < 72 && nprocs > 0) {
+            uint32_t pick = (uint32_t)rand() % nprocs;
+            printf("terminate %u\n", live_procs[pick]);
+            live_procs[pick] = live_procs[--nprocs];
+        }
+        else if (choice < 78 && nprocs > 0) {
+            printf("%s %u\n", rand() % 2 ? "block" : "wake", live_procs[(uint32_t)rand() % nprocs]);
+        }
+        else if (choice < 98) {
+            printf("tick %u\n", 1u + (uint32_t)rand() % 10);
+        }
+        else {
+            printf("schedule\n");
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t repeat = 1;
+    uint32_t r;
+    uint64_t cycles = 0;
+    uint64_t ticks = 0;
+    uint64_t ns;
+    if (argc >= 3 && strcmp(argv[1], "--generate") == 0) {
+        replay_generate((uint32_t)strtoul(argv[2], NULL, 0), argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 0) : 1);
+        return 0;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s trace.txt [repeat] | --generate <ops> [seed]\n", argv[0]);
+        return 2;
+    }
+    if (argc > 2) {
+        repeat = (uint32_t)strtoul(argv[2], NULL, 0);
+    }
+    serial_init();
+    clock_init();
+    replay_load(argv[1]);
+    for (r = 0; r < repeat; r++) {
+        uint64_t start;
+        uint32_t muted;
+        replay_reset();
+        muted = serial_set_muted(1);
+        start = clock_cycles();
+        ticks += replay_run();
+        cycles += clock_cycles() - start;
+        serial_set_muted(muted);
+    }
+    ns = clock_cycles_to_ns(cycles);
+    printf("REPLAY ops=%u repeat=%u ticks=%llu elapsed_ns=%llu ns_per_op=%.1f mops=%.2f\n",
+           op_count, repeat, (unsigned long long)ticks, (unsigned long long)ns,
+           op_count ? (double)ns / ((double)op_count * repeat) : 0.0,
+           ns ? (double)op_count * repeat * 1000.0 / (double)ns : 0.0);
+    return 0;
+}
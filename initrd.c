@@ -0,0 +1,468 @@
+/* initrd.c - Read-only tar filesystem on the Multiboot RAM disk, with a block cache
+ *
+ * QEMU's -initrd (or a GRUB module) hands the kernel a ustar archive in
+ * memory. Mounting walks the headers once and records every regular file;
+ * after that the image is only read. File data in a tar archive starts on
+ * a 512-byte record, so the image doubles as a block device of
+ * INITRD_BLOCK_SIZE blocks.
+ *
+ * There is no paging, so module memory is already reachable and "mapping"
+ * a file is handing out a pointer into the image: initrd_map() does that
+ * for block-aligned offsets and copies nothing. initrd_read() copies whole
+ * blocks straight from the image and sends partial blocks through a small
+ * LRU cache, so repeated small or unaligned reads (headers, records that
+ * straddle blocks) do not go back to the device.
+ */
+#include "initrd.h"
+#include "spinlock.h"
+#include "serial.h"
+#include "string.h"
+#include "kprintf.h"
+#include "clock.h"
+#include "math64.h"
+
+//ustar header, one INITRD_BLOCK_SIZE record; numbers are octal text
+typedef struct {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];                    /* "ustar\0" (POSIX) or "ustar " (GNU) */
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];                 /* Only set for names over 100 characters */
+    char pad[12];
+} tar_header_t;
+
+//Cache tag; kept apart from the data so a lookup scans a few cache lines
+typedef struct {
+    uint32_t block;                   /* Image block held */
+    uint32_t last_used;               /* initrd_clock at the last hit, 0 = empty */
+} initrd_cache_tag_t;
+
+static const uint8_t *initrd_image = NULL;
+static uint32_t initrd_size = 0;
+static uint32_t initrd_loader_end = 0;   /* End of the boot info, module list and module images */
+static initrd_file_t initrd_files[INITRD_MAX_FILES];
+static uint32_t initrd_count = 0;
+static initrd_cache_tag_t initrd_cache_tags[INITRD_CACHE_BLOCKS];
+static uint8_t initrd_cache_data[INITRD_CACHE_BLOCKS][INITRD_BLOCK_SIZE];
+static uint32_t initrd_cache_last = 0;   /* Entry of the last lookup; sequential small reads hit it again */
+static uint32_t initrd_clock = 0;
+static initrd_stats_t initrd_stats;
+/* Guards the cache and the counters; image reads need no lock */
+static spinlock_t initrd_lock = SPINLOCK_INIT("initrd");
+static uint8_t initrd_bench_buf[INITRD_BENCH_CHUNK];
+
+/* Parse a NUL- or space-terminated octal field */
+static uint32_t tar_octal(const char *field, uint32_t len) {
+    uint32_t value = 0;
+    uint32_t i = 0;
+    while (i < len && field[i] == ' ') {
+        i++;
+    }
+    while (i < len && field[i] >= '0' && field[i] <= '7') {
+        value = (value << 3) + (uint32_t)(field[i] - '0');
+        i++;
+    }
+    return value;
+}
+
+/* "ustar" magic; POSIX ends it with a NUL, GNU tar with a space */
+static uint32_t tar_is_ustar(const tar_header_t *header) {
+    static const char ustar[5] = { 'u', 's', 't', 'a', 'r' };
+    uint32_t i;
+    for (i = 0; i < sizeof(ustar); i++) {
+        if (header->magic[i] != ustar[i]) {
+            return 0;
+        }
+    }
+    return header->magic[5] == '\0' || header->magic[5] == ' ';
+}
+
+/* Header checksum: byte sum with the checksum field read as spaces */
+static uint32_t tar_checksum_ok(const tar_header_t *header) {
+    const uint8_t *bytes = (const uint8_t *)header;
+    uint32_t sum = 0;
+    uint32_t i;
+    for (i = 0; i < sizeof(*header); i++) {
+        if (i >= 148 && i < 148 + sizeof(header->checksum)) {
+            sum += ' ';
+        }
+        else {
+            sum += bytes[i];
+        }
+    }
+    return sum == tar_octal(header->checksum, sizeof(header->checksum));
+}
+
+static void initrd_add_file(const tar_header_t *header, uint32_t offset, uint32_t size) {
+    const char *name = header->name;
+    const char *end = header->name + sizeof(header->name);
+    initrd_file_t *file;
+    uint32_t len;
+    if (header->prefix[0] != '\0') {
+        serial_puts("[INITRD] WARNING: Skipping file with a name over 100 characters\n");
+        return;
+    }
+    while (name[0] == '.' && name[1] == '/') {
+        name += 2;
+    }
+    for (len = 0; name + len < end && name[len] != '\0'; len++);
+    if (len == 0) {
+        return;
+    }
+    if (initrd_count >= INITRD_MAX_FILES) {
+        serial_puts("[INITRD] WARNING: File table full, skipping the rest\n");
+        return;
+    }
+    file = &initrd_files[initrd_count++];
+    memcpy(file->name, name, len);
+    file->name[len] = '\0';
+    file->offset = offset;
+    file->size = size;
+}
+
+/* Block holding image offset block * INITRD_BLOCK_SIZE; caller holds initrd_lock */
+static const uint8_t* initrd_cache_block(uint32_t block) {
+    initrd_cache_tag_t *tag = &initrd_cache_tags[initrd_cache_last];
+    uint32_t victim = 0;
+    uint32_t start = block * INITRD_BLOCK_SIZE;
+    uint32_t length;
+    uint32_t i;
+    initrd_clock++;
+    if (tag->last_used != 0 && tag->block == block) {
+        tag->last_used = initrd_clock;
+        initrd_stats.cache_hits++;
+        return initrd_cache_data[initrd_cache_last];
+    }
+    for (i = 0; i < INITRD_CACHE_BLOCKS; i++) {
+        tag = &initrd_cache_tags[i];
+        if (tag->last_used != 0 && tag->block == block) {
+            tag->last_used = initrd_clock;
+            initrd_cache_last = i;
+            initrd_stats.cache_hits++;
+            return initrd_cache_data[i];
+        }
+        if (tag->last_used < initrd_cache_tags[victim].last_used) {
+            victim = i;
+        }
+    }
+    initrd_stats.cache_misses++;
+    if (initrd_cache_tags[victim].last_used != 0) {
+        initrd_stats.cache_evictions++;
+    }
+    length = initrd_size - start < INITRD_BLOCK_SIZE ? initrd_size - start : INITRD_BLOCK_SIZE;
+    memcpy(initrd_cache_data[victim], initrd_image + start, length);
+    memset(initrd_cache_data[victim] + length, 0, INITRD_BLOCK_SIZE - length);
+    initrd_cache_tags[victim].block = block;
+    initrd_cache_tags[victim].last_used = initrd_clock;
+    initrd_cache_last = victim;
+    return initrd_cache_data[victim];
+}
+
+/* Caller holds initrd_lock */
+static void initrd_count_read(uint32_t bytes, uint32_t direct) {
+    initrd_stats.reads++;
+    initrd_stats.bytes_read += bytes;
+    initrd_stats.direct_blocks += direct;
+}
+
+/**
+ * Mount the first Multiboot module as the root filesystem
+ * Also notes how far the loader's data reaches, for initrd_loader_top().
+ * @param magic: EAX at entry; must be MULTIBOOT_BOOTLOADER_MAGIC
+ * @param mbi: EBX at entry; read before anything can reuse low memory
+ * @return: 1 if a module was mounted, 0 otherwise
+ */
+uint32_t initrd_init(uint32_t magic, const multiboot_info_t *mbi) {
+    const multiboot_module_t *module;
+    uint32_t i;
+    if (magic != MULTIBOOT_BOOTLOADER_MAGIC || mbi == NULL) {
+        serial_puts("[INITRD] Not booted by a Multiboot loader, no initrd\n");
+        return 0;
+    }
+    initrd_loader_end = (uint32_t)(uintptr_t)mbi + sizeof(*mbi);
+    if (!(mbi->flags & MULTIBOOT_INFO_MODS) || mbi->mods_count == 0) {
+        serial_puts("[INITRD] No initrd module\n");
+        return 0;
+    }
+    module = (const multiboot_module_t *)(uintptr_t)mbi->mods_addr;
+    /* Every module stays where the loader put it, not just the one mounted */
+    if (mbi->mods_addr + mbi->mods_count * sizeof(*module) > initrd_loader_end) {
+        initrd_loader_end = mbi->mods_addr + mbi->mods_count * sizeof(*module);
+    }
+    for (i = 0; i < mbi->mods_count; i++) {
+        if (module[i].mod_end > initrd_loader_end) {
+            initrd_loader_end = module[i].mod_end;
+        }
+    }
+    if (module->mod_end <= module->mod_start) {
+        serial_puts("[INITRD] ERROR: Empty initrd module\n");
+        return 0;
+    }
+    return initrd_mount((const void *)(uintptr_t)module->mod_start, module->mod_end - module->mod_start);
+}
+
+/**
+ * Index a tar archive in memory; whatever was mounted before is dropped
+ * Regular files are listed, directories and links are skipped.
+ * @param base: The archive; it must stay in place while mounted
+ * @param size: Bytes in the archive
+ * @return: 1 on success, 0 if the image is not a valid ustar archive
+ */
+uint32_t initrd_mount(const void *base, uint32_t size) {
+    const uint8_t *image = (const uint8_t *)base;
+    uint32_t pos = 0;
+    initrd_unmount();
+    while (pos + INITRD_BLOCK_SIZE <= size) {
+        const tar_header_t *header = (const tar_header_t *)(image + pos);
+        uint32_t data = pos + INITRD_BLOCK_SIZE;
+        uint32_t file_size;
+        if (header->name[0] == '\0') {
+            break;                    /* Zero record: end of archive */
+        }
+        if (!tar_is_ustar(header) || !tar_checksum_ok(header)) {
+            serial_puts("[INITRD] ERROR: Bad tar header\n");
+            initrd_unmount();
+            return 0;
+        }
+        file_size = tar_octal(header->size, sizeof(header->size));
+        if (file_size > size - data) {
+            serial_puts("[INITRD] ERROR: Truncated tar archive\n");
+            initrd_unmount();
+            return 0;
+        }
+        if (header->typeflag == '0' || header->typeflag == '\0') {
+            initrd_add_file(header, data, file_size);
+        }
+        pos = data + ((file_size + INITRD_BLOCK_SIZE - 1) & ~(INITRD_BLOCK_SIZE - 1));
+    }
+    initrd_image = image;
+    initrd_size = size;
+    kprintf("[INITRD] Mounted %u file(s) from a %u KB image\n", initrd_count, size / 1024);
+    return 1;
+}
+
+//End of the memory the boot loader handed over (boot info, module list, module images); 0 if none
+uint32_t initrd_loader_top(void) {
+    return initrd_loader_end;
+}
+
+//Forget the mounted image, its files and every cached block
+void initrd_unmount(void) {
+    uint32_t flags = spin_lock_irqsave(&initrd_lock);
+    initrd_image = NULL;
+    initrd_size = 0;
+    initrd_count = 0;
+    initrd_clock = 0;
+    initrd_cache_last = 0;
+    memset(initrd_cache_tags, 0, sizeof(initrd_cache_tags));
+    memset(&initrd_stats, 0, sizeof(initrd_stats));
+    spin_unlock_irqrestore(&initrd_lock, flags);
+}
+
+//Regular files on the mounted image
+uint32_t initrd_file_count(void) {
+    return initrd_count;
+}
+
+//File by index, in archive order; NULL past the end
+const initrd_file_t* initrd_file(uint32_t index) {
+    return index < initrd_count ? &initrd_files[index] : NULL;
+}
+
+/**
+ * Look up a file by path
+ * @param name: Path inside the archive; a leading '/' is ignored
+ * @return: The file, or NULL if there is none
+ */
+const initrd_file_t* initrd_open(const char *name) {
+    uint32_t i;
+    while (*name == '/') {
+        name++;
+    }
+    for (i = 0; i < initrd_count; i++) {
+        if (strcmp(initrd_files[i].name, name) == 0) {
+            return &initrd_files[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Zero-copy access to part of a file
+ * @param file: Open file
+ * @param offset: Start in the file; must be a multiple of INITRD_BLOCK_SIZE
+ * @param length: Bytes wanted; must lie inside the file
+ * @return: Read-only pointer into the image, or NULL if unaligned or out of range
+ */
+const void* initrd_map(const initrd_file_t *file, uint32_t offset, uint32_t length) {
+    uint32_t flags;
+    if (initrd_image == NULL || (offset & (INITRD_BLOCK_SIZE - 1)) != 0 ||
+        offset > file->size || length > file->size - offset) {
+        return NULL;
+    }
+    flags = spin_lock_irqsave(&initrd_lock);
+    initrd_stats.maps++;
+    initrd_stats.bytes_mapped += length;
+    spin_unlock_irqrestore(&initrd_lock, flags);
+    return initrd_image + file->offset + offset;
+}
+
+/**
+ * Copy part of a file
+ * Whole blocks are copied straight from the image; partial ones go through the cache.
+ * @param file: Open file
+ * @param offset: Start in the file
+ * @param buf: Destination
+ * @param length: Bytes wanted
+ * @return: Bytes copied; short at the end of the file
+ */
+uint32_t initrd_read(const initrd_file_t *file, uint32_t offset, void *buf, uint32_t length) {
+    uint8_t *dest = (uint8_t *)buf;
+    uint32_t direct = 0;
+    uint32_t done = 0;
+    uint32_t counted = 0;
+    uint32_t flags;
+    if (initrd_image == NULL || offset >= file->size) {
+        return 0;
+    }
+    if (length > file->size - offset) {
+        length = file->size - offset;
+    }
+    while (done < length) {
+        uint32_t pos = file->offset + offset + done;
+        uint32_t within = pos & (INITRD_BLOCK_SIZE - 1);
+        uint32_t chunk = length - done;
+        if (within == 0 && chunk >= INITRD_BLOCK_SIZE) {
+            chunk &= ~(INITRD_BLOCK_SIZE - 1);
+            memcpy(dest + done, initrd_image + pos, chunk);
+            direct += chunk / INITRD_BLOCK_SIZE;
+            done += chunk;
+            continue;
+        }
+        if (chunk > INITRD_BLOCK_SIZE - within) {
+            chunk = INITRD_BLOCK_SIZE - within;
+        }
+        flags = spin_lock_irqsave(&initrd_lock);
+        memcpy(dest + done, initrd_cache_block(pos / INITRD_BLOCK_SIZE) + within, chunk);
+        done += chunk;
+        if (done == length) {
+            /* Count the read under this hold so a small read takes the lock once */
+            initrd_count_read(done, direct);
+            counted = 1;
+        }
+        spin_unlock_irqrestore(&initrd_lock, flags);
+    }
+    if (!counted) {
+        flags = spin_lock_irqsave(&initrd_lock);
+        initrd_count_read(done, direct);
+        spin_unlock_irqrestore(&initrd_lock, flags);
+    }
+    return done;
+}
+
+//Copy the read path counters
+void initrd_get_stats(initrd_stats_t *stats) {
+    uint32_t flags = spin_lock_irqsave(&initrd_lock);
+    *stats = initrd_stats;
+    spin_unlock_irqrestore(&initrd_lock, flags);
+}
+
+//Zero the counters; cached blocks are kept
+void initrd_reset_stats(void) {
+    uint32_t flags = spin_lock_irqsave(&initrd_lock);
+    memset(&initrd_stats, 0, sizeof(initrd_stats));
+    spin_unlock_irqrestore(&initrd_lock, flags);
+}
+
+//List the mounted files and the read path counters
+void initrd_print_files(void) {
+    initrd_stats_t stats;
+    uint32_t i;
+    if (initrd_image == NULL) {
+        serial_puts("No initrd mounted (boot with -initrd <archive.tar>)\n");
+        return;
+    }
+    serial_puts("\n=== initrd ===\n");
+    serial_puts("Size       | Name\n");
+    for (i = 0; i < initrd_count; i++) {
+        kprintf("%10u | %s\n", initrd_files[i].size, initrd_files[i].name);
+    }
+    initrd_get_stats(&stats);
+    kprintf("Mapped: %u calls, %llu bytes | Read: %u calls, %llu bytes, %u direct blocks\n",
+            stats.maps, stats.bytes_mapped, stats.reads, stats.bytes_read, stats.direct_blocks);
+    kprintf("Block cache: %u hits, %u misses, %u evictions (%u x %u bytes)\n\n",
+            stats.cache_hits, stats.cache_misses, stats.cache_evictions,
+            INITRD_CACHE_BLOCKS, INITRD_BLOCK_SIZE);
+}
+
+/* Sum a buffer so every benchmark mode touches the same bytes */
+static uint32_t initrd_sum(const uint8_t *data, uint32_t length) {
+    uint32_t sum = 0;
+    uint32_t i;
+    for (i = 0; i < length; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+/* One benchmark mode over the whole file; 0 = map, 1 = aligned read, 2 = small records */
+static uint32_t initrd_bench_pass(const initrd_file_t *file, uint32_t mode) {
+    uint32_t sum = 0;
+    uint32_t offset = 0;
+    while (offset < file->size) {
+        uint32_t chunk = mode == 2 ? INITRD_BENCH_RECORD : INITRD_BENCH_CHUNK;
+        if (chunk > file->size - offset) {
+            chunk = file->size - offset;
+        }
+        if (mode == 0) {
+            sum += initrd_sum((const uint8_t *)initrd_map(file, offset, chunk), chunk);
+        }
+        else {
+            sum += initrd_sum(initrd_bench_buf, initrd_read(file, offset, initrd_bench_buf, chunk));
+        }
+        offset += chunk;
+    }
+    return sum;
+}
+
+/**
+ * Measure read throughput of a file through each access path
+ * Each mode sums every byte, so the differences are the copying and caching.
+ * @param file: Open, non-empty file
+ */
+void initrd_bench(const initrd_file_t *file) {
+    static const char *modes[3] = { "map (zero-copy)", "read 4 KB aligned", "read 100 B records" };
+    uint32_t passes = INITRD_BENCH_BYTES / file->size + 1;
+    uint32_t expected = 0;
+    uint32_t mode;
+    kprintf("fsbench %s: %u bytes x %u passes\n", file->name, file->size, passes);
+    for (mode = 0; mode < 3; mode++) {
+        uint64_t start = clock_cycles();
+        uint64_t bytes = (uint64_t)file->size * passes;
+        uint32_t sum = 0;
+        uint32_t us;
+        uint32_t i;
+        for (i = 0; i < passes; i++) {
+            sum = initrd_bench_pass(file, mode);
+        }
+        us = (uint32_t)udiv64(clock_cycles_to_ns(clock_cycles() - start), 1000);
+        if (mode == 0) {
+            expected = sum;
+        }
+        else if (sum != expected) {
+            serial_puts("[INITRD] ERROR: Read data differs from the mapped image\n");
+        }
+        kprintf("  %-20s %8llu MB/s\n", modes[mode], us ? udiv64(bytes, us) : 0ULL);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+/* initrd.h - Read-only tar filesystem on the Multiboot RAM disk, with a block cache */
+#ifndef INITRD_H
+#define INITRD_H
+
+#include "types.h"
+#include "multiboot.h"
+
+#define INITRD_BLOCK_SIZE   512       /* tar record size; file data starts on these boundaries */
+#define INITRD_MAX_FILES    64
+#define INITRD_NAME_LEN     100       /* tar name field; a name that fills it has no NUL */
+#define INITRD_CACHE_BLOCKS 64        /* LRU cache for reads that do not start on a block */
+#define INITRD_BENCH_CHUNK  4096      /* fsbench map/read size */
+#define INITRD_BENCH_RECORD 100       /* fsbench small-record size, deliberately not block sized */
+#define INITRD_BENCH_BYTES  (8 * 1024 * 1024)   /* fsbench repeats the file until this much is read */
+
+//A regular file found at mount time
+typedef struct {
+    char name[INITRD_NAME_LEN + 1];
+    uint32_t offset;                  /* Data offset in the image, a multiple of INITRD_BLOCK_SIZE */
+    uint32_t size;
+} initrd_file_t;
+
+//Read path counters
+typedef struct {
+    uint32_t maps;                    /* Zero-copy initrd_map() calls */
+    uint32_t reads;                   /* initrd_read() calls */
+    uint64_t bytes_mapped;
+    uint64_t bytes_read;
+    uint32_t direct_blocks;           /* Whole blocks copied straight from the image */
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t cache_evictions;
+} initrd_stats_t;
+
+//Function declarations
+uint32_t initrd_init(uint32_t magic, const multiboot_info_t *mbi);
+uint32_t initrd_loader_top(void);
+uint32_t initrd_mount(const void *base, uint32_t size);
+void initrd_unmount(void);
+uint32_t initrd_file_count(void);
+const initrd_file_t* initrd_file(uint32_t index);
+const initrd_file_t* initrd_open(const char *name);
+const void* initrd_map(const initrd_file_t *file, uint32_t offset, uint32_t length);
+uint32_t initrd_read(const initrd_file_t *file, uint32_t offset, void *buf, uint32_t length);
+void initrd_get_stats(initrd_stats_t *stats);
+void initrd_reset_stats(void);
+void initrd_print_files(void);
+void initrd_bench(const initrd_file_t *file);
+#endif
\ No newline at end of file
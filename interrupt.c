@@ -0,0 +1,229 @@
+/* interrupt.c - IDT, exception and legacy PIC IRQ handling */
+#include "interrupt.h"
+#include "io.h"
+#include "serial.h"
+#include "debugcon.h"
+#include "cpu.h"
+#include "clock.h"
+#include "latency.h"
+#include "deferred.h"
+
+//8259 PIC ports and commands
+#define PIC1_COMMAND    0x20
+#define PIC1_DATA       0x21
+#define PIC2_COMMAND    0xA0
+#define PIC2_DATA       0xA1
+#define PIC_EOI         0x20
+#define PIC_READ_ISR    0x0B
+#define ICW1_INIT       0x11      /* Edge triggered, cascade, ICW4 follows */
+#define ICW4_8086       0x01
+
+//One IDT descriptor
+typedef struct {
+    uint16_t offset_low;
+    uint16_t selector;
+    uint8_t zero;
+    uint8_t attributes;
+    uint16_t offset_high;
+} __attribute__((packed)) idt_entry_t;
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) idt_pointer_t;
+
+static idt_entry_t idt[IDT_ENTRIES];
+static irq_handler_t irq_handlers[IRQ_COUNT];
+static uint32_t irq_counts[IRQ_COUNT];
+static uint32_t spurious_irqs;
+static uint16_t irq_mask_bits = 0xFFFF;   /* All lines masked until registered */
+
+extern const uint32_t isr_stub_table[IDT_STUB_COUNT];
+
+static const char *exception_names[32] = {
+    "divide error", "debug", "NMI", "breakpoint", "overflow", "bound range",
+    "invalid opcode", "device not available", "double fault", "coprocessor overrun",
+    "invalid TSS", "segment not present", "stack fault", "general protection",
+    "page fault", "reserved", "x87 error", "alignment check", "machine check",
+    "SIMD error", "virtualization", "control protection", "reserved", "reserved",
+    "reserved", "reserved", "reserved", "reserved", "hypervisor injection",
+    "VMM communication", "security", "reserved"
+};
+
+/* Port 0x80 write: gives the old PIC time to settle between init words */
+static void io_wait(void) {
+    outb(0x80, 0);
+}
+
+static void pic_write_mask(void) {
+    outb(PIC1_DATA, (uint8_t)irq_mask_bits);
+    outb(PIC2_DATA, (uint8_t)(irq_mask_bits >> 8));
+}
+
+/* Remap the PICs off the CPU exception vectors, all lines masked */
+static void pic_init(void) {
+    outb(PIC1_COMMAND, ICW1_INIT);
+    io_wait();
+    outb(PIC2_COMMAND, ICW1_INIT);
+    io_wait();
+    outb(PIC1_DATA, IRQ_BASE_VECTOR);
+    io_wait();
+    outb(PIC2_DATA, IRQ_BASE_VECTOR + 8);
+    io_wait();
+    outb(PIC1_DATA, 0x04);        /* Slave on IRQ 2 */
+    io_wait();
+    outb(PIC2_DATA, 0x02);        /* Slave cascade identity */
+    io_wait();
+    outb(PIC1_DATA, ICW4_8086);
+    io_wait();
+    outb(PIC2_DATA, ICW4_8086);
+    io_wait();
+    irq_mask_bits = 0xFFFF & ~(1 << 2);   /* Keep the cascade line open */
+    pic_write_mask();
+}
+
+/* In-service bit for an IRQ; clear for spurious IRQ 7/15 */
+static uint32_t pic_in_service(uint32_t irq) {
+    uint16_t port = irq < 8 ? PIC1_COMMAND : PIC2_COMMAND;
+    outb(port, PIC_READ_ISR);
+    return (inb(port) >> (irq & 7)) & 1;
+}
+
+static void pic_eoi(uint32_t irq) {
+    if (irq >= 8) {
+        outb(PIC2_COMMAND, PIC_EOI);
+    }
+    outb(PIC1_COMMAND, PIC_EOI);
+}
+
+/**
+ * Point an IDT vector at a handler
+ * @param vector: Interrupt vector (0-255)
+ * @param handler: Entry point address
+ * @param attributes: Gate type and privilege, e.g. IDT_GATE_INTERRUPT
+ */
+void idt_set_gate(uint32_t vector, uint32_t handler, uint8_t attributes) {
+    uint16_t cs;
+    __asm__ volatile ("mov %%cs, %0" : "=r"(cs));
+    idt[vector].offset_low = (uint16_t)(handler & 0xFFFF);
+    idt[vector].selector = cs;
+    idt[vector].zero = 0;
+    idt[vector].attributes = attributes;
+    idt[vector].offset_high = (uint16_t)(handler >> 16);
+}
+
+//Install exception and IRQ stubs, remap the PIC and load the IDT (interrupts stay disabled)
+void interrupt_init(void) {
+    idt_pointer_t pointer;
+    uint32_t i;
+    for (i = 0; i < IDT_STUB_COUNT; i++) {
+        idt_set_gate(i, isr_stub_table[i], IDT_GATE_INTERRUPT);
+    }
+    pic_init();
+    pointer.limit = sizeof(idt) - 1;
+    pointer.base = (uint32_t)idt;
+    __asm__ volatile ("lidt %0" : : "m"(pointer));
+    serial_puts("[IRQ] IDT loaded, PIC remapped to vector ");
+    serial_put_dec(IRQ_BASE_VECTOR);
+    serial_puts("\n");
+}
+
+/**
+ * Install a handler for a legacy IRQ line and unmask it
+ * Handlers run with interrupts disabled; the EOI is sent after they return.
+ * @param irq: IRQ line (0-15)
+ * @param handler: Handler function
+ */
+void irq_register(uint32_t irq, irq_handler_t handler) {
+    if (irq >= IRQ_COUNT) {
+        serial_puts("[IRQ] ERROR: Invalid IRQ line\n");
+        return;
+    }
+    irq_handlers[irq] = handler;
+    irq_unmask(irq);
+}
+
+void irq_mask(uint32_t irq) {
+    irq_mask_bits |= (uint16_t)(1 << irq);
+    pic_write_mask();
+}
+
+void irq_unmask(uint32_t irq) {
+    irq_mask_bits &= (uint16_t)~(1 << irq);
+    pic_write_mask();
+}
+
+//Interrupts taken on an IRQ line since boot
+uint32_t irq_count(uint32_t irq) {
+    return irq < IRQ_COUNT ? irq_counts[irq] : 0;
+}
+
+//Print per-line interrupt counts
+void interrupt_print_stats(void) {
+    uint32_t i;
+    serial_puts("\n=== Interrupts ===\n");
+    serial_puts("IRQ | Count\n");
+    serial_puts("-----------------\n");
+    for (i = 0; i < IRQ_COUNT; i++) {
+        if (irq_handlers[i] == NULL && irq_counts[i] == 0) {
+            continue;
+        }
+        serial_put_dec(i);
+        serial_puts("   | ");
+        serial_put_dec(irq_counts[i]);
+        serial_puts("\n");
+    }
+    serial_puts("Spurious: ");
+    serial_put_dec(spurious_irqs);
+    serial_puts("\n-----------------\n\n");
+}
+
+/* CPU exceptions are fatal: report and halt */
+static void interrupt_exception(interrupt_frame_t *frame) {
+    serial_panic_mode();
+    serial_puts("\n[IRQ] EXCEPTION: ");
+    serial_puts(exception_names[frame->vector]);
+    serial_puts(" (vector ");
+    serial_put_dec(frame->vector);
+    serial_puts(", error 0x");
+    serial_put_hex(frame->error_code);
+    serial_puts(") at eip 0x");
+    serial_put_hex(frame->eip);
+    serial_puts("\n[IRQ] System halted\n");
+    for (;;) {
+        __asm__ volatile ("cli; hlt");
+    }
+}
+
+//Common C entry point for every stub in isr.S
+void interrupt_dispatch(interrupt_frame_t *frame) {
+    uint64_t entered = clock_cycles();
+    uint32_t irq;
+    if (frame->vector < IRQ_BASE_VECTOR) {
+        interrupt_exception(frame);
+        return;
+    }
+    irq = frame->vector - IRQ_BASE_VECTOR;
+    if ((irq == 7 || irq == 15) && !pic_in_service(irq)) {
+        /* Spurious: nothing to acknowledge except the master for a slave line */
+        spurious_irqs++;
+        if (irq == 15) {
+            outb(PIC1_COMMAND, PIC_EOI);
+        }
+        return;
+    }
+    irq_counts[irq]++;
+    debugcon_emit(DBG_EV_IRQ_ENTER, irq, frame->eip, 0);
+    if (irq_handlers[irq] != NULL) {
+        irq_handlers[irq](frame);
+    }
+    pic_eoi(irq);
+    debugcon_emit(DBG_EV_IRQ_EXIT, irq, 0, 0);
+    /* The gate cleared IF on entry; charge the handler run to the handler */
+    if (frame->eflags & EFLAGS_IF) {
+        uint32_t handler = (uint32_t)(uintptr_t)irq_handlers[irq];
+        latency_record(handler, handler, clock_cycles() - entered);
+    }
+    /* Bottom halves run with interrupts back on, outside the section just charged */
+    deferred_irq_exit();
+}
\ No newline at end of file
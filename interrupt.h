@@ -0,0 +1,48 @@
+/* interrupt.h - IDT, exception and legacy PIC IRQ handling */
+#ifndef INTERRUPT_H
+#define INTERRUPT_H
+
+#include "types.h"
+
+#define IDT_ENTRIES         256
+#define IRQ_BASE_VECTOR     32        /* PIC IRQ 0 after remapping */
+#define IRQ_COUNT           16
+#define IDT_STUB_COUNT      48        /* Exceptions + PIC IRQs with stubs in isr.S */
+
+//Gate attributes
+#define IDT_GATE_INTERRUPT  0x8E      /* Present, ring 0, 32-bit interrupt gate (IF cleared) */
+#define IDT_GATE_USER_INTERRUPT 0xEE  /* Same, but ring 3 may raise it with int */
+
+//Legacy IRQ lines
+#define IRQ_TIMER           0
+#define IRQ_COM1            4
+
+//Register state saved on interrupt entry (matches isr.S)
+typedef struct {
+    uint32_t edi;
+    uint32_t esi;
+    uint32_t ebp;
+    uint32_t esp_ignored;     /* pusha's copy of esp */
+    uint32_t ebx;
+    uint32_t edx;
+    uint32_t ecx;
+    uint32_t eax;
+    uint32_t vector;
+    uint32_t error_code;      /* 0 for vectors without one */
+    uint32_t eip;             /* Pushed by the CPU */
+    uint32_t cs;
+    uint32_t eflags;
+} interrupt_frame_t;
+
+typedef void (*irq_handler_t)(interrupt_frame_t *frame);
+
+//Function declarations
+void interrupt_init(void);
+void idt_set_gate(uint32_t vector, uint32_t handler, uint8_t attributes);
+void irq_register(uint32_t irq, irq_handler_t handler);
+void irq_mask(uint32_t irq);
+void irq_unmask(uint32_t irq);
+uint32_t irq_count(uint32_t irq);
+void interrupt_print_stats(void);
+void interrupt_dispatch(interrupt_frame_t *frame);
+#endif
\ No newline at end of file
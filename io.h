@@ -4,6 +4,18 @@
 
 #include "types.h"
 
+#ifdef KACCHI_HOSTED
+/* Hosted builds have no ports: writes vanish and reads float high like an empty bus */
+static inline void outb(uint16_t port, uint8_t val) {
+    (void)port;
+    (void)val;
+}
+
+static inline uint8_t inb(uint16_t port) {
+    (void)port;
+    return 0xFF;
+}
+#else
 static inline void outb(uint16_t port, uint8_t val) {
     __asm__ volatile ("outb %0, %1" : : "a"(val), "Nd"(port));
 }
@@ -13,5 +25,6 @@ static inline uint8_t inb(uint16_t port) {
     __asm__ volatile ("inb %1, %0" : "=a"(ret) : "Nd"(port));
     return ret;
 }
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,514 @@
+/* ipc.c - Synchronous rendezvous message passing
+ *
+ * L4-style IPC: a message moves only when sender and receiver meet. A sender
+ * that finds its partner already blocked in ipc_receive() writes the message
+ * straight into the receiver's saved registers and hands it the CPU with
+ * scheduler_handoff() - no run-queue pick, and the receiver finishes the
+ * sender's time slice. Otherwise the side that arrives first blocks: senders
+ * queue FIFO on the receiver with the message parked in their own registers,
+ * receivers wait for a sender. ipc_call() is a send that then waits for the
+ * reply, and ipc_reply_wait() lets a server answer one client and wait for
+ * the next in a single operation, which is what keeps a client/server round
+ * trip down to two direct switches.
+ *
+ * Processes do not execute code yet, so "registers" are the PCB context: a
+ * delivered message lands in EAX (sender PID) and EBX/ECX/EDX/ESI, and a
+ * process whose operation returned IPC_PENDING collects it with ipc_take().
+ */
+#include "ipc.h"
+#include "process.h"
+#include "scheduler.h"
+#include "spinlock.h"
+#include "serial.h"
+#include "string.h"
+#include "kprintf.h"
+
+//What a process is blocked on
+typedef enum {
+    IPC_IDLE = 0,
+    IPC_RECEIVING = 1,                /* In ipc_receive(); partner is the accepted source */
+    IPC_SENDING = 2,                  /* Queued on partner with a send */
+    IPC_CALLING = 3,                  /* Queued on partner with a call */
+    IPC_AWAIT_REPLY = 4               /* Call delivered; waiting for partner's reply */
+} ipc_wait_t;
+
+//Per-process endpoint, indexed by process table slot
+typedef struct {
+    volatile ipc_wait_t wait;         /* Stored last when a wait ends; ipc_take() reads it unlocked */
+    uint32_t partner;
+    ipc_status_t result;              /* For ipc_take(); IPC_PENDING = nothing to collect */
+    uint32_t queue_head;              /* Senders queued on us, as slot + 1 (0 = none) */
+    uint32_t queue_tail;
+    uint32_t queue_next;              /* Next sender on the queue we are on */
+} ipc_endpoint_t;
+
+static const char *ipc_wait_names[] = {
+    "idle", "receiving", "sending to", "calling", "awaiting reply from"
+};
+static ipc_endpoint_t endpoints[MAX_PROCESSES];
+static ipc_stats_t ipc_stats;
+/* Taken before the scheduler lock, never inside it */
+static spinlock_t ipc_lock = SPINLOCK_INIT("ipc");
+
+static uint32_t ipc_slot(process_control_block_t *pcb) {
+    return (uint32_t)(pcb - process_slot(0));
+}
+
+static ipc_endpoint_t *ipc_endpoint(process_control_block_t *pcb) {
+    return &endpoints[ipc_slot(pcb)];
+}
+
+/* Live, non-null process or NULL */
+static process_control_block_t *ipc_pcb(uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    if (pid == 0 || pcb == NULL || pcb->state == TERMINATED) {
+        return NULL;
+    }
+    return pcb;
+}
+
+/* Message into saved registers; EAX names the partner */
+static void ipc_store(cpu_context_t *context, uint32_t partner, const ipc_msg_t *msg) {
+    context->eax = partner;
+    context->ebx = msg->words[0];
+    context->ecx = msg->words[1];
+    context->edx = msg->words[2];
+    context->esi = msg->words[3];
+}
+
+static void ipc_load(const cpu_context_t *context, ipc_msg_t *msg) {
+    msg->words[0] = context->ebx;
+    msg->words[1] = context->ecx;
+    msg->words[2] = context->edx;
+    msg->words[3] = context->esi;
+}
+
+static void ipc_enqueue(ipc_endpoint_t *dest, uint32_t slot) {
+    endpoints[slot].queue_next = 0;
+    if (dest->queue_tail != 0) {
+        endpoints[dest->queue_tail - 1].queue_next = slot + 1;
+    }
+    else {
+        dest->queue_head = slot + 1;
+    }
+    dest->queue_tail = slot + 1;
+}
+
+static void ipc_dequeue(ipc_endpoint_t *dest, uint32_t slot) {
+    uint32_t prev = 0;
+    uint32_t link = dest->queue_head;
+    while (link != 0 && link != slot + 1) {
+        prev = link;
+        link = endpoints[link - 1].queue_next;
+    }
+    if (link == 0) {
+        return;
+    }
+    if (prev != 0) {
+        endpoints[prev - 1].queue_next = endpoints[slot].queue_next;
+    }
+    else {
+        dest->queue_head = endpoints[slot].queue_next;
+    }
+    if (dest->queue_tail == slot + 1) {
+        dest->queue_tail = prev;
+    }
+    endpoints[slot].queue_next = 0;
+}
+
+/* Unlink the first queued sender that source accepts; caller holds ipc_lock */
+static process_control_block_t *ipc_next_sender(ipc_endpoint_t *ep, uint32_t source) {
+    uint32_t link = ep->queue_head;
+    while (link != 0) {
+        process_control_block_t *sender = process_slot(link - 1);
+        if (source == IPC_ANY || sender->process_id == source) {
+            ipc_dequeue(ep, link - 1);
+            return sender;
+        }
+        link = endpoints[link - 1].queue_next;
+    }
+    return NULL;
+}
+
+/* Whether a process is blocked in a receive that accepts from_pid */
+static uint32_t ipc_accepts(ipc_endpoint_t *ep, uint32_t from_pid) {
+    return ep->wait == IPC_RECEIVING && (ep->partner == IPC_ANY || ep->partner == from_pid);
+}
+
+/* End a blocked partner's wait with a message; caller holds ipc_lock */
+static void ipc_deliver(process_control_block_t *to, uint32_t from_pid, const ipc_msg_t *msg) {
+    ipc_endpoint_t *ep = ipc_endpoint(to);
+    ipc_store(&to->context, from_pid, msg);
+    ep->partner = from_pid;
+    ep->result = IPC_OK;
+    __asm__ volatile ("" : : : "memory");
+    ep->wait = IPC_IDLE;
+}
+
+/* End a partner's wait without a message and let it run; caller holds ipc_lock */
+static void ipc_abort(process_control_block_t *pcb) {
+    ipc_endpoint_t *ep = ipc_endpoint(pcb);
+    ep->result = IPC_ERROR;
+    __asm__ volatile ("" : : : "memory");
+    ep->wait = IPC_IDLE;
+    ipc_stats.aborted++;
+    scheduler_wake(pcb->process_id);
+}
+
+/*
+ * Take a queued sender's message into the receiver; caller holds ipc_lock
+ * A plain sender is released, a caller moves on to waiting for the reply.
+ */
+static void ipc_accept(process_control_block_t *sender, uint32_t *from_pid, ipc_msg_t *msg) {
+    ipc_endpoint_t *ep = ipc_endpoint(sender);
+    ipc_load(&sender->context, msg);
+    if (from_pid != NULL) {
+        *from_pid = sender->process_id;
+    }
+    ipc_stats.receives++;
+    if (ep->wait == IPC_CALLING) {
+        ep->wait = IPC_AWAIT_REPLY;
+        return;
+    }
+    ep->result = IPC_OK;
+    ep->partner = 0;
+    __asm__ volatile ("" : : : "memory");
+    ep->wait = IPC_IDLE;
+    scheduler_wake(sender->process_id);
+}
+
+/* Send or call; the message is delivered now or parked in the sender's registers */
+static ipc_status_t ipc_transfer(uint32_t from_pid, uint32_t to_pid, const ipc_msg_t *msg, uint32_t call) {
+    process_control_block_t *from = ipc_pcb(from_pid);
+    process_control_block_t *to = ipc_pcb(to_pid);
+    ipc_endpoint_t *src;
+    ipc_status_t status = IPC_PENDING;
+    const char *error = NULL;
+    uint32_t flags;
+    if (from == NULL || to == NULL || from == to) {
+        serial_puts("[IPC] ERROR: Invalid sender or destination\n");
+        return IPC_ERROR;
+    }
+    flags = spin_lock_irqsave(&ipc_lock);
+    src = ipc_endpoint(from);
+    if (src->wait != IPC_IDLE) {
+        error = "[IPC] ERROR: Sender is already waiting\n";
+    }
+    else if ((call || !ipc_accepts(ipc_endpoint(to), from_pid)) &&
+             from->sched_class != SCHED_CLASS_NORMAL) {
+        error = "[IPC] ERROR: EDF processes cannot block\n";
+    }
+    else {
+        if (call) {
+            ipc_stats.calls++;
+        }
+        else {
+            ipc_stats.sends++;
+        }
+        src->result = IPC_PENDING;
+        src->partner = to_pid;
+        if (ipc_accepts(ipc_endpoint(to), from_pid)) {
+            /* Fast path: receiver is waiting, switch straight to it */
+            ipc_deliver(to, from_pid, msg);
+            if (call) {
+                src->wait = IPC_AWAIT_REPLY;
+            }
+            else {
+                status = IPC_OK;
+            }
+            ipc_stats.handoffs += scheduler_handoff(from_pid, to_pid, call);
+        }
+        else {
+            ipc_store(&from->context, to_pid, msg);
+            src->wait = call ? IPC_CALLING : IPC_SENDING;
+            ipc_enqueue(ipc_endpoint(to), ipc_slot(from));
+            ipc_stats.blocked++;
+            if (!scheduler_block(from_pid)) {
+                ipc_dequeue(ipc_endpoint(to), ipc_slot(from));
+                src->partner = 0;
+                src->result = IPC_ERROR;
+                src->wait = IPC_IDLE;
+                ipc_stats.blocked--;
+                status = IPC_ERROR;
+            }
+        }
+    }
+    spin_unlock_irqrestore(&ipc_lock, flags);
+    if (error != NULL) {
+        serial_puts(error);
+        return IPC_ERROR;
+    }
+    return status;
+}
+
+//Reset every endpoint; the process table has been emptied
+void ipc_init(void) {
+    uint32_t flags = spin_lock_irqsave(&ipc_lock);
+    memset(endpoints, 0, sizeof(endpoints));
+    memset(&ipc_stats, 0, sizeof(ipc_stats));
+    spin_unlock_irqrestore(&ipc_lock, flags);
+}
+
+/**
+ * Send a message, blocking until the destination receives it
+ * @param from_pid: Sender
+ * @param to_pid: Destination
+ * @param msg: Message
+ * @return: IPC_OK if delivered at once, IPC_PENDING if the sender blocked
+ *          (ipc_take() then reports the outcome), IPC_ERROR otherwise
+ */
+ipc_status_t ipc_send(uint32_t from_pid, uint32_t to_pid, const ipc_msg_t *msg) {
+    return ipc_transfer(from_pid, to_pid, msg, 0);
+}
+
+/**
+ * Send a message and wait for the destination's ipc_reply()
+ * The caller always blocks; collect the reply with ipc_take().
+ * @param from_pid: Client
+ * @param to_pid: Server
+ * @param msg: Request
+ * @return: IPC_PENDING, or IPC_ERROR
+ */
+ipc_status_t ipc_call(uint32_t from_pid, uint32_t to_pid, const ipc_msg_t *msg) {
+    return ipc_transfer(from_pid, to_pid, msg, 1);
+}
+
+/* Receive half of ipc_receive()/ipc_reply_wait(); caller holds ipc_lock */
+static ipc_status_t ipc_receive_locked(process_control_block_t *pcb, uint32_t source,
+                                       uint32_t *from_pid, ipc_msg_t *msg) {
+    ipc_endpoint_t *ep = ipc_endpoint(pcb);
+    process_control_block_t *sender = ipc_next_sender(ep, source);
+    ep->result = IPC_PENDING;
+    if (sender != NULL) {
+        ipc_accept(sender, from_pid, msg);
+        return IPC_OK;
+    }
+    ep->wait = IPC_RECEIVING;
+    ep->partner = source;
+    ipc_stats.blocked++;
+    return IPC_PENDING;
+}
+
+/**
+ * Receive a message, blocking until one arrives
+ * @param pid: Receiver
+ * @param source: Sender to accept, or IPC_ANY
+ * @param from_pid: Receives the sender's PID (may be NULL)
+ * @param msg: Receives the message
+ * @return: IPC_OK if a queued sender was taken, IPC_PENDING if the receiver
+ *          blocked (collect with ipc_take()), IPC_ERROR otherwise
+ */
+ipc_status_t ipc_receive(uint32_t pid, uint32_t source, uint32_t *from_pid, ipc_msg_t *msg) {
+    process_control_block_t *pcb = ipc_pcb(pid);
+    ipc_status_t status;
+    uint32_t flags;
+    if (pcb == NULL || source == pid || (source != IPC_ANY && ipc_pcb(source) == NULL)) {
+        serial_puts("[IPC] ERROR: Invalid receiver or source\n");
+        return IPC_ERROR;
+    }
+    flags = spin_lock_irqsave(&ipc_lock);
+    if (ipc_endpoint(pcb)->wait != IPC_IDLE) {
+        spin_unlock_irqrestore(&ipc_lock, flags);
+        serial_puts("[IPC] ERROR: Receiver is already waiting\n");
+        return IPC_ERROR;
+    }
+    status = ipc_receive_locked(pcb, source, from_pid, msg);
+    if (status == IPC_PENDING) {
+        if (!scheduler_block(pid)) {
+            ipc_endpoint(pcb)->wait = IPC_IDLE;
+            ipc_stats.blocked--;
+            status = IPC_ERROR;
+        }
+    }
+    spin_unlock_irqrestore(&ipc_lock, flags);
+    return status;
+}
+
+/* Check that to_pid is waiting for pid's reply; caller holds ipc_lock */
+static process_control_block_t *ipc_reply_target(uint32_t pid, uint32_t to_pid) {
+    process_control_block_t *client = ipc_pcb(to_pid);
+    ipc_endpoint_t *ep;
+    if (client == NULL) {
+        return NULL;
+    }
+    ep = ipc_endpoint(client);
+    return ep->wait == IPC_AWAIT_REPLY && ep->partner == pid ? client : NULL;
+}
+
+/**
+ * Answer a call; the client gets the CPU straight away
+ * @param pid: Server
+ * @param to_pid: Client blocked in ipc_call() to this server
+ * @param msg: Reply
+ * @return: IPC_OK, or IPC_ERROR if to_pid is not waiting for our reply
+ */
+ipc_status_t ipc_reply(uint32_t pid, uint32_t to_pid, const ipc_msg_t *msg) {
+    process_control_block_t *client;
+    uint32_t flags = spin_lock_irqsave(&ipc_lock);
+    client = ipc_reply_target(pid, to_pid);
+    if (client == NULL) {
+        spin_unlock_irqrestore(&ipc_lock, flags);
+        serial_puts("[IPC] ERROR: No call to reply to\n");
+        return IPC_ERROR;
+    }
+    ipc_deliver(client, pid, msg);
+    ipc_stats.replies++;
+    ipc_stats.handoffs += scheduler_handoff(pid, to_pid, 0);
+    spin_unlock_irqrestore(&ipc_lock, flags);
+    return IPC_OK;
+}
+
+/**
+ * Reply to one client and wait for the next message in one step
+ * If a sender is already queued its message is taken at once and the server
+ * keeps running; otherwise the server blocks and the CPU goes to the client.
+ * @param pid: Server
+ * @param to_pid: Client blocked in ipc_call() to this server
+ * @param reply: Reply
+ * @param source: Sender to accept next, or IPC_ANY
+ * @param from_pid: Receives the next sender's PID (may be NULL)
+ * @param msg: Receives the next message
+ * @return: IPC_OK if a message was taken, IPC_PENDING if the server blocked,
+ *          IPC_ERROR if nothing was done
+ */
+ipc_status_t ipc_reply_wait(uint32_t pid, uint32_t to_pid, const ipc_msg_t *reply,
+                            uint32_t source, uint32_t *from_pid, ipc_msg_t *msg) {
+    process_control_block_t *pcb = ipc_pcb(pid);
+    process_control_block_t *client;
+    ipc_status_t status;
+    uint32_t flags;
+    if (pcb == NULL || pcb->sched_class != SCHED_CLASS_NORMAL || source == pid ||
+        (source != IPC_ANY && ipc_pcb(source) == NULL)) {
+        serial_puts("[IPC] ERROR: Invalid server or source\n");
+        return IPC_ERROR;
+    }
+    flags = spin_lock_irqsave(&ipc_lock);
+    client = ipc_reply_target(pid, to_pid);
+    if (client == NULL || ipc_endpoint(pcb)->wait != IPC_IDLE) {
+        spin_unlock_irqrestore(&ipc_lock, flags);
+        serial_puts("[IPC] ERROR: No call to reply to\n");
+        return IPC_ERROR;
+    }
+    ipc_deliver(client, pid, reply);
+    ipc_stats.replies++;
+    status = ipc_receive_locked(pcb, source, from_pid, msg);
+    if (status == IPC_OK) {
+        scheduler_wake(to_pid);
+    }
+    else {
+        ipc_stats.handoffs += scheduler_handoff(pid, to_pid, 1);
+    }
+    spin_unlock_irqrestore(&ipc_lock, flags);
+    return status;
+}
+
+/**
+ * Collect the result of an operation that returned IPC_PENDING
+ * @param pid: Process that blocked; only it may collect its own result
+ * @param from_pid: Receives the partner's PID (may be NULL)
+ * @param msg: Receives the message or reply; untouched for a finished send
+ * @return: IPC_OK once complete, IPC_PENDING while still blocked,
+ *          IPC_ERROR if the partner exited or there is nothing to collect
+ */
+ipc_status_t ipc_take(uint32_t pid, uint32_t *from_pid, ipc_msg_t *msg) {
+    process_control_block_t *pcb = ipc_pcb(pid);
+    ipc_endpoint_t *ep;
+    ipc_status_t status;
+    if (pcb == NULL) {
+        return IPC_ERROR;
+    }
+    /*
+     * No lock: once the wait is over nobody but the owner touches the
+     * result, partner or registers until it starts another operation, and
+     * whoever ended the wait stored them before wait itself
+     */
+    ep = ipc_endpoint(pcb);
+    if (ep->wait != IPC_IDLE) {
+        return IPC_PENDING;
+    }
+    __asm__ volatile ("" : : : "memory");
+    status = ep->result == IPC_OK ? IPC_OK : IPC_ERROR;
+    /* A finished plain send has no partner: nothing came back */
+    if (status == IPC_OK && ep->partner != 0) {
+        ipc_load(&pcb->context, msg);
+    }
+    if (status == IPC_OK && from_pid != NULL) {
+        *from_pid = ep->partner;
+    }
+    ep->result = IPC_PENDING;
+    return status;
+}
+
+/**
+ * Drop a terminated process from IPC
+ * It leaves any queue it was on; processes queued on it, waiting for its
+ * reply or receiving only from it are released with IPC_ERROR.
+ * @param pid: Process that exited
+ */
+void ipc_process_exit(uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    ipc_endpoint_t *ep;
+    uint32_t i;
+    uint32_t flags;
+    if (pcb == NULL || pid == 0) {
+        return;
+    }
+    flags = spin_lock_irqsave(&ipc_lock);
+    ep = ipc_endpoint(pcb);
+    if (ep->wait == IPC_SENDING || ep->wait == IPC_CALLING) {
+        process_control_block_t *dest = process_get_pcb(ep->partner);
+        if (dest != NULL) {
+            ipc_dequeue(ipc_endpoint(dest), ipc_slot(pcb));
+        }
+    }
+    while (ep->queue_head != 0) {
+        process_control_block_t *sender = process_slot(ep->queue_head - 1);
+        ipc_dequeue(ep, ep->queue_head - 1);
+        ipc_abort(sender);
+    }
+    for (i = 1; i < process_slot_count(); i++) {
+        process_control_block_t *other = process_slot(i);
+        ipc_endpoint_t *oep = &endpoints[i];
+        if (other != pcb && other->state != TERMINATED && oep->partner == pid &&
+            (oep->wait == IPC_AWAIT_REPLY || oep->wait == IPC_RECEIVING)) {
+            ipc_abort(other);
+        }
+    }
+    memset(ep, 0, sizeof(*ep));
+    spin_unlock_irqrestore(&ipc_lock, flags);
+}
+
+//Copy out the counters
+void ipc_get_stats(ipc_stats_t *stats) {
+    uint32_t flags = spin_lock_irqsave(&ipc_lock);
+    *stats = ipc_stats;
+    spin_unlock_irqrestore(&ipc_lock, flags);
+}
+
+//Print the counters and every process blocked in IPC
+void ipc_print_stats(void) {
+    ipc_stats_t stats;
+    uint32_t i;
+    ipc_get_stats(&stats);
+    serial_puts("\n=== IPC ===\n");
+    kprintf("Sends:    %u\n", stats.sends);
+    kprintf("Calls:    %u\n", stats.calls);
+    kprintf("Replies:  %u\n", stats.replies);
+    kprintf("Queued receives: %u\n", stats.receives);
+    kprintf("Direct handoffs: %u\n", stats.handoffs);
+    kprintf("Blocked:  %u\n", stats.blocked);
+    kprintf("Aborted:  %u\n", stats.aborted);
+    for (i = 1; i < process_slot_count(); i++) {
+        ipc_endpoint_t *ep = &endpoints[i];
+        if (process_slot(i)->state == TERMINATED || ep->wait == IPC_IDLE) {
+            continue;
+        }
+        if (ep->partner == IPC_ANY) {
+            kprintf("  PID %u %s any\n", process_slot(i)->process_id, ipc_wait_names[ep->wait]);
+        }
+        else {
+            kprintf("  PID %u %s PID %u\n", process_slot(i)->process_id, ipc_wait_names[ep->wait], ep->partner);
+        }
+    }
+    serial_puts("\n");
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+/* ipc.h - Synchronous rendezvous message passing between processes */
+#ifndef IPC_H
+#define IPC_H
+
+#include "types.h"
+
+#define IPC_MSG_WORDS   4             /* Message words, carried in EBX/ECX/EDX/ESI */
+#define IPC_ANY         0             /* Receive source: accept any sender */
+
+//A short message; it travels in the saved registers, never through a kernel buffer
+typedef struct {
+    uint32_t words[IPC_MSG_WORDS];
+} ipc_msg_t;
+
+//Outcome of an IPC operation
+typedef enum {
+    IPC_OK = 0,                       /* Completed now */
+    IPC_PENDING = 1,                  /* Caller blocked; ipc_take() collects the result */
+    IPC_ERROR = 2                     /* Invalid request, or the partner exited */
+} ipc_status_t;
+
+//Counters since the last ipc_init()
+typedef struct {
+    uint32_t sends;
+    uint32_t calls;
+    uint32_t replies;
+    uint32_t receives;                /* Messages taken from a sender queue */
+    uint32_t handoffs;                /* Deliveries that switched straight to the partner */
+    uint32_t blocked;                 /* Operations that had to wait for a partner */
+    uint32_t aborted;                 /* Waits ended by the partner exiting */
+} ipc_stats_t;
+
+//Function declarations
+void ipc_init(void);
+ipc_status_t ipc_send(uint32_t from_pid, uint32_t to_pid, const ipc_msg_t *msg);
+ipc_status_t ipc_call(uint32_t from_pid, uint32_t to_pid, const ipc_msg_t *msg);
+ipc_status_t ipc_receive(uint32_t pid, uint32_t source, uint32_t *from_pid, ipc_msg_t *msg);
+ipc_status_t ipc_reply(uint32_t pid, uint32_t to_pid, const ipc_msg_t *msg);
+ipc_status_t ipc_reply_wait(uint32_t pid, uint32_t to_pid, const ipc_msg_t *reply,
+                            uint32_t source, uint32_t *from_pid, ipc_msg_t *msg);
+ipc_status_t ipc_take(uint32_t pid, uint32_t *from_pid, ipc_msg_t *msg);
+void ipc_process_exit(uint32_t pid);
+void ipc_get_stats(ipc_stats_t *stats);
+void ipc_print_stats(void);
+#endif
\ No newline at end of file
@@ -5,18 +5,94 @@
 #include "memory.h"
 #include "process.h"
 #include "scheduler.h"
+#include "smp.h"
+#include "spinlock.h"
+#include "trace.h"
+#include "workload.h"
+#include "interrupt.h"
+#include "debugcon.h"
+#include "clock.h"
+#include "profile.h"
+#include "latency.h"
+#include "ipc.h"
+#include "sync.h"
+#include "shm.h"
+#include "ring.h"
+#include "gdt.h"
+#include "syscall.h"
+#include "deferred.h"
+#include "initrd.h"
+#include "cpu.h"
 
 #define MAX_INPUT 128
+#define TOP_REFRESH_MS    1000 /* Real time between top refreshes */
+#define TOP_POLL_MS       10   /* Key check interval while top waits */
 
-void kmain(void) {
+/* If the line starts with the given command word, return its arguments, else NULL */
+static const char* match_command(const char *line, const char *name) {
+    while (*line == ' ') {
+        line++;
+    }
+    while (*name && *line == *name) {
+        line++;
+        name++;
+    }
+    if (*name || (*line != '\0' && *line != ' ')) {
+        return NULL;
+    }
+    return line;
+}
+
+/* Parse an optional decimal argument; leaves value untouched if absent */
+static const char* parse_uint(const char *args, uint32_t *value) {
+    while (*args == ' ') {
+        args++;
+    }
+    if (*args >= '0' && *args <= '9') {
+        *value = 0;
+        while (*args >= '0' && *args <= '9') {
+            *value = *value * 10 + (uint32_t)(*args - '0');
+            args++;
+        }
+    }
+    return args;
+}
+
+/* Runs in ring 3: greet through the requested entry path and report our PID */
+static uint32_t user_hello(uint32_t use_sysenter) {
+    static const char sysenter_text[] = "Hello from ring 3 via SYSENTER\n";
+    static const char int80_text[] = "Hello from ring 3 via int 0x80\n";
+    if (use_sysenter) {
+        syscall_sysenter(SYS_WRITE, (uint32_t)sysenter_text, sizeof(sysenter_text) - 1, 0);
+        return syscall_sysenter(SYS_GETPID, 0, 0, 0);
+    }
+    syscall_int80(SYS_WRITE, (uint32_t)int80_text, sizeof(int80_text) - 1, 0);
+    return syscall_int80(SYS_GETPID, 0, 0, 0);
+}
+
+void kmain(uint32_t magic, const multiboot_info_t *mbi) {
     char input[MAX_INPUT];
     int pos = 0;
+    const char *args;
     
     /* Initialize hardware */
     serial_init();
+    clock_init();          /* Before anything takes timestamps */
+    if (debugcon_init()) {
+        debugcon_set_enabled(1);   /* -debugcon given: record from boot on */
+    }
+    initrd_init(magic, mbi);   /* Before smp_init: the AP trampoline sits next to the boot info */
     memory_init();
+    memory_reserve_below(initrd_loader_top());   /* The heap must not land on the initrd image */
     process_init();
     scheduler_init(RR, 5); /* Round Robin, 5ms quantum */
+    gdt_init();            /* Before smp_init: APs load it too */
+    smp_init();
+    interrupt_init();
+    syscall_init();
+    deferred_init();       /* Before any interrupt handler queues work */
+    serial_enable_irq();   /* Console output drains from the TX interrupt from here on */
+    cpu_irq_enable();
     
     /* Print welcome message */
     serial_puts("\n");
@@ -47,15 +123,8 @@ void kmain(void) {
         scheduler_update_time();
         scheduler_schedule();
 
-        /* Find which PCB is marked CURRENT */
-        uint32_t current_pid = 0;
-        for (uint32_t pid = 0; pid < 20; pid++) {
-            process_control_block_t *pcb = process_get_pcb(pid);
-            if (pcb != 0 && pcb->state == CURRENT) {
-                current_pid = pid;
-                break;
-            }
-        }
+        /* Process running on the boot CPU */
+        uint32_t current_pid = scheduler_current_process();
 
         serial_puts("[tick ");
         serial_put_dec(tick);
@@ -69,30 +138,11 @@ void kmain(void) {
     
     /* Main loop - the "null process" with command interface */
     while (1) {
+        /* Run the worker's share of deferred work that interrupt exits left behind */
+        deferred_worker_run();
         serial_puts("kacchiOS> ");
-        pos = 0;
-        
-        /* Read input line */
-        while (1) {
-            char c = serial_getc();
-            
-            /* Handle Enter key */
-            if (c == '\r' || c == '\n') {
-                input[pos] = '\0';
-                serial_puts("\n");
-                break;
-            }
-            /* Handle Backspace */
-            else if ((c == '\b' || c == 0x7F) && pos > 0) {
-                pos--;
-                serial_puts("\b \b");  /* Erase character on screen */
-            }
-            /* Handle normal characters */
-            else if (c >= 32 && c < 127 && pos < MAX_INPUT - 1) {
-                input[pos++] = c;
-                serial_putc(c);  /* Echo character */
-            }
-        }
+        /* Read an edited line; the driver echoes and handles backspace */
+        pos = (int)serial_read_line(input, MAX_INPUT);
         
         /* Process commands */
         if (pos > 0) {
@@ -101,8 +151,9 @@ void kmain(void) {
                 process_print_table();
             }
             else if (strcmp(input, "mem") == 0) {
-                /* Show memory status */
+                /* Show memory status and shared regions */
                 memory_print_status();
+                shm_print_status();
             }
             else if (strcmp(input, "sched") == 0) {
                 /* Show scheduler status and trigger a few ticks */
@@ -112,14 +163,7 @@ void kmain(void) {
                     scheduler_update_time();
                     scheduler_schedule();
                     
-                    uint32_t current_pid = 0;
-                    for (uint32_t pid = 0; pid < 20; pid++) {
-                        process_control_block_t *pcb = process_get_pcb(pid);
-                        if (pcb != 0 && pcb->state == CURRENT) {
-                            current_pid = pid;
-                            break;
-                        }
-                    }
+                    uint32_t current_pid = scheduler_current_process();
                     
                     serial_puts("[tick ");
                     serial_put_dec(i);
@@ -128,18 +172,204 @@ void kmain(void) {
                     serial_puts("\n");
                 }
             }
+            else if (strcmp(input, "cpus") == 0) {
+                /* Show online CPUs */
+                smp_print_status();
+            }
+            else if (strcmp(input, "locks") == 0) {
+                /* Show lock contention statistics, spinning and sleeping */
+                spinlock_print_stats();
+                sync_print_stats();
+            }
+            else if (strcmp(input, "irqs") == 0) {
+                /* Show interrupt counts and deferred work queues */
+                interrupt_print_stats();
+                serial_puts("Serial RX overruns: ");
+                serial_put_dec(serial_rx_overruns());
+                serial_puts("\n");
+                deferred_print_stats();
+            }
+            else if (strcmp(input, "trace") == 0) {
+                /* Dump the context-switch trace as CSV */
+                trace_dump();
+            }
+            else if ((args = match_command(input, "bintrace")) != NULL) {
+                /* Binary event channel on port 0xE9 */
+                if (match_command(args, "on") != NULL) {
+                    debugcon_set_enabled(1);
+                }
+                else if (match_command(args, "off") != NULL) {
+                    debugcon_set_enabled(0);
+                }
+                debugcon_print_status();
+            }
+            else if ((args = match_command(input, "profile")) != NULL) {
+                /* Timer-driven EIP sampling */
+                const char *rest;
+                if ((rest = match_command(args, "start")) != NULL) {
+                    uint32_t hz = PROFILE_DEFAULT_HZ;
+                    parse_uint(rest, &hz);
+                    if (profile_start(hz)) {
+                        serial_puts("Profiling started\n");
+                    }
+                }
+                else if (match_command(args, "stop") != NULL) {
+                    profile_stop();
+                    serial_put_dec(profile_samples());
+                    serial_puts(" samples\n");
+                }
+                else if (match_command(args, "dump") != NULL) {
+                    profile_dump();
+                }
+                else {
+                    serial_puts("Usage: profile start [hz] | stop | dump\n");
+                }
+            }
+            else if ((args = match_command(input, "latency")) != NULL) {
+                /* Interrupts-off sections: histogram and worst offenders */
+                if (match_command(args, "reset") != NULL) {
+                    latency_reset();
+                }
+                else if (match_command(args, "on") != NULL) {
+                    latency_set_enabled(1);
+                }
+                else if (match_command(args, "off") != NULL) {
+                    latency_set_enabled(0);
+                }
+                latency_print();
+            }
+            else if (strcmp(input, "ipc") == 0) {
+                /* Message counters, who is blocked on whom, and ring traffic */
+                ipc_print_stats();
+                ring_print_stats();
+            }
+            else if (strcmp(input, "syscalls") == 0) {
+                /* Drop to ring 3 on a scratch process through each entry path */
+                uint32_t pid = process_create(2, 4096, 4096);
+                if (pid != 0) {
+                    if (syscall_sysenter_available()) {
+                        syscall_run_user(pid, user_hello, 1);
+                    }
+                    serial_puts("Ring 3 code ran as PID ");
+                    serial_put_dec(syscall_run_user(pid, user_hello, 0));
+                    serial_puts("\n");
+                    process_terminate(pid);
+                }
+                syscall_print_stats();
+            }
+            else if (strcmp(input, "ls") == 0) {
+                /* Files on the initrd and block cache counters */
+                initrd_print_files();
+            }
+            else if ((args = match_command(input, "cat")) != NULL) {
+                /* Print a file from the initrd */
+                char chunk[MAX_INPUT];
+                uint32_t offset = 0;
+                uint32_t got;
+                const initrd_file_t *file;
+                while (*args == ' ') {
+                    args++;
+                }
+                if ((file = initrd_open(args)) == NULL) {
+                    serial_puts("No such file\n");
+                }
+                else {
+                    while ((got = initrd_read(file, offset, chunk, sizeof(chunk))) != 0) {
+                        for (uint32_t i = 0; i < got; i++) {
+                            serial_putc(chunk[i]);
+                        }
+                        offset += got;
+                    }
+                }
+            }
+            else if ((args = match_command(input, "fsbench")) != NULL) {
+                /* Read throughput of an initrd file: mapped, aligned reads, small records */
+                const initrd_file_t *file;
+                while (*args == ' ') {
+                    args++;
+                }
+                if ((file = initrd_open(args)) == NULL || file->size == 0) {
+                    serial_puts("Usage: fsbench <non-empty file> (see ls)\n");
+                }
+                else {
+                    initrd_bench(file);
+                }
+            }
+            else if (strcmp(input, "top") == 0) {
+                /* Live view sorted by CPU usage; any key exits */
+                serial_set_raw(1);
+                while (!serial_received()) {
+                    serial_puts("\033[2J\033[H=== top (press any key to exit) ===\n");
+                    scheduler_print_loadavg();
+                    process_print_top();
+                    for (uint32_t waited = 0; waited < TOP_REFRESH_MS && !serial_received(); waited += TOP_POLL_MS) {
+                        clock_delay_us(TOP_POLL_MS * 1000);
+                    }
+                }
+                serial_getc();
+                serial_set_raw(0);
+            }
+            else if ((args = match_command(input, "workload")) != NULL) {
+                /* Synthetic job mix against the active algorithm */
+                workload_config_t config = { 1000, 8, 8, 16, 1 };
+                workload_result_t result;
+                args = parse_uint(args, &config.ticks);
+                args = parse_uint(args, &config.cpu_bound);
+                args = parse_uint(args, &config.io_bound);
+                args = parse_uint(args, &config.bursty);
+                workload_run(&config, &result);
+                workload_print_result(&result);
+            }
+            else if ((args = match_command(input, "policy")) != NULL) {
+                /* Switch scheduling algorithm at run time */
+                uint32_t quantum = scheduler_get_quantum();
+                const char *rest;
+                if ((rest = match_command(args, "fcfs")) != NULL) {
+                    scheduler_set_algorithm(FCFS, quantum);
+                }
+                else if ((rest = match_command(args, "rr")) != NULL) {
+                    parse_uint(rest, &quantum);
+                    scheduler_set_algorithm(RR, quantum);
+                }
+                else if ((rest = match_command(args, "mlfq")) != NULL) {
+                    parse_uint(rest, &quantum);
+                    scheduler_set_algorithm(MLFQ, quantum);
+                }
+                else {
+                    serial_puts("Usage: policy fcfs | rr [quantum] | mlfq [quantum]\n");
+                }
+                scheduler_print_status();
+            }
             else if (strcmp(input, "help") == 0) {
                 /* Show available commands */
                 serial_puts("\n=== kacchiOS Commands ===\n");
                 serial_puts("ps      - Show process table\n");
-                serial_puts("mem     - Show memory status\n");
+                serial_puts("mem     - Show memory status and shared regions\n");
                 serial_puts("sched   - Show scheduler status & run ticks\n");
-                serial_puts("create  - Create a new process\n");
+                serial_puts("create [prio] - Create a new process (default priority 2)\n");
+                serial_puts("cpus    - Show online CPUs\n");
+                serial_puts("locks   - Show spinlock and mutex/semaphore contention statistics\n");
+                serial_puts("irqs    - Show interrupt counts and deferred work queues\n");
+                serial_puts("trace   - Dump context-switch trace (CSV)\n");
+                serial_puts("bintrace [on|off] - Binary event trace on port 0xE9\n");
+                serial_puts("profile start [hz] | stop | dump - Sampling profiler\n");
+                serial_puts("latency [reset|on|off] - Longest interrupts-off sections\n");
+                serial_puts("ipc     - Show IPC counters, blocked processes and rings\n");
+                serial_puts("syscalls - Run ring 3 code through SYSENTER and int 0x80, show counts\n");
+                serial_puts("ls      - List initrd files and block cache counters\n");
+                serial_puts("cat <file> - Print an initrd file\n");
+                serial_puts("fsbench <file> - Initrd read throughput: mapped, aligned, small records\n");
+                serial_puts("top     - Live per-process CPU usage\n");
+                serial_puts("workload [ticks] [cpu] [io] [bursty] - Run a job mix, report metrics\n");
+                serial_puts("policy fcfs | rr [q] | mlfq [q] - Switch scheduling algorithm\n");
                 serial_puts("help    - Show this help message\n\n");
             }
-            else if (strcmp(input, "create") == 0) {
+            else if ((args = match_command(input, "create")) != NULL) {
                 /* Create a new process */
-                uint32_t new_pid = process_create(2, 4096, 8192);
+                uint32_t priority = 2;
+                uint32_t new_pid;
+                parse_uint(args, &priority);
+                new_pid = process_create(priority, 4096, 8192);
                 serial_puts("Created new process with PID: ");
                 serial_put_dec(new_pid);
                 serial_puts("\n");
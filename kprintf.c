@@ -0,0 +1,296 @@
+/* kprintf.c - Formatted output for kacchiOS
+ *
+ * Everything is formatted into a buffer first, so kprintf() hands a whole
+ * line to the serial driver in one serial_write() instead of one port
+ * access per character.
+ */
+#include "kprintf.h"
+#include "math64.h"
+#include "serial.h"
+
+/* "00".."99": decimal conversion emits two digits per step */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char hex_lower[] = "0123456789abcdef";
+static const char hex_upper[] = "0123456789ABCDEF";
+
+/**
+ * Convert to decimal, two digits per step
+ * Division by the constant 100 compiles to a multiply, so there is no divl.
+ * @param buf: Destination, at least 10 bytes; not NUL terminated
+ * @param value: Value to convert
+ * @return: Number of digits written
+ */
+uint32_t kfmt_dec(char *buf, uint32_t value) {
+    char tmp[10];
+    char *p = tmp + sizeof(tmp);
+    uint32_t len;
+    while (value >= 100) {
+        uint32_t pair = (value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        *--p = digit_pairs[value * 2 + 1];
+        *--p = digit_pairs[value * 2];
+    }
+    else {
+        *--p = (char)('0' + value);
+    }
+    len = (uint32_t)(tmp + sizeof(tmp) - p);
+    for (uint32_t i = 0; i < len; i++) {
+        buf[i] = p[i];
+    }
+    return len;
+}
+
+/**
+ * Convert to hexadecimal without leading zeros
+ * @param buf: Destination, at least 8 bytes; not NUL terminated
+ * @param value: Value to convert
+ * @param upper: Non-zero for A-F
+ * @return: Number of digits written
+ */
+uint32_t kfmt_hex(char *buf, uint32_t value, uint32_t upper) {
+    const char *digits = upper ? hex_upper : hex_lower;
+    uint32_t len = 1;
+    uint32_t i;
+    while (len < 8 && (value >> (len * 4)) != 0) {
+        len++;
+    }
+    for (i = 0; i < len; i++) {
+        buf[i] = digits[(value >> ((len - 1 - i) * 4)) & 0x0F];
+    }
+    return len;
+}
+
+/* 64-bit decimal: peel off 9-digit chunks with one udiv64 each */
+static uint32_t kfmt_dec64(char *buf, uint64_t value) {
+    uint32_t chunks[3];
+    uint32_t count = 0;
+    uint32_t len;
+    uint32_t i;
+    while (value >= 1000000000ULL && count < 2) {
+        uint64_t quotient = udiv64(value, 1000000000);
+        chunks[count++] = (uint32_t)(value - quotient * 1000000000ULL);
+        value = quotient;
+    }
+    len = kfmt_dec(buf, (uint32_t)value);
+    while (count > 0) {
+        char tmp[10];
+        uint32_t digits = kfmt_dec(tmp, chunks[--count]);
+        for (i = 0; i < 9 - digits; i++) {
+            buf[len++] = '0';
+        }
+        for (i = 0; i < digits; i++) {
+            buf[len++] = tmp[i];
+        }
+    }
+    return len;
+}
+
+static uint32_t kfmt_hex64(char *buf, uint64_t value, uint32_t upper) {
+    uint32_t high = (uint32_t)(value >> 32);
+    uint32_t len;
+    uint32_t i;
+    if (high == 0) {
+        return kfmt_hex(buf, (uint32_t)value, upper);
+    }
+    len = kfmt_hex(buf, high, upper);
+    for (i = 0; i < 8; i++) {
+        buf[len++] = (upper ? hex_upper : hex_lower)[((uint32_t)value >> ((7 - i) * 4)) & 0x0F];
+    }
+    return len;
+}
+
+/* Output cursor that counts everything but only stores what fits */
+typedef struct {
+    char *buf;
+    uint32_t size;
+    uint32_t pos;
+} kfmt_out_t;
+
+static void kfmt_putc(kfmt_out_t *out, char c) {
+    if (out->pos + 1 < out->size) {
+        out->buf[out->pos] = c;
+    }
+    out->pos++;
+}
+
+/* Emit a converted field with padding */
+static void kfmt_field(kfmt_out_t *out, const char *prefix, const char *text, uint32_t len,
+                       uint32_t width, uint32_t left, uint32_t zero) {
+    uint32_t prefix_len = 0;
+    uint32_t pad;
+    uint32_t i;
+    while (prefix != NULL && prefix[prefix_len]) {
+        prefix_len++;
+    }
+    pad = width > len + prefix_len ? width - len - prefix_len : 0;
+    if (!left && !zero) {
+        for (i = 0; i < pad; i++) {
+            kfmt_putc(out, ' ');
+        }
+    }
+    for (i = 0; i < prefix_len; i++) {
+        kfmt_putc(out, prefix[i]);
+    }
+    if (!left && zero) {
+        for (i = 0; i < pad; i++) {
+            kfmt_putc(out, '0');
+        }
+    }
+    for (i = 0; i < len; i++) {
+        kfmt_putc(out, text[i]);
+    }
+    if (left) {
+        for (i = 0; i < pad; i++) {
+            kfmt_putc(out, ' ');
+        }
+    }
+}
+
+/**
+ * Format into a buffer
+ * @param buf: Destination; always NUL terminated when size > 0
+ * @param size: Size of buf
+ * @param fmt: Format string
+ * @param args: Arguments
+ * @return: Length the full output would have, like C99 vsnprintf
+ */
+int kvsnprintf(char *buf, uint32_t size, const char *fmt, va_list args) {
+    kfmt_out_t out = { buf, size, 0 };
+    char digits[24];
+    while (*fmt) {
+        uint32_t left = 0;
+        uint32_t zero = 0;
+        uint32_t width = 0;
+        uint32_t longs = 0;
+        uint32_t len;
+        if (*fmt != '%') {
+            kfmt_putc(&out, *fmt++);
+            continue;
+        }
+        fmt++;
+        for (;; fmt++) {
+            if (*fmt == '-') {
+                left = 1;
+            }
+            else if (*fmt == '0') {
+                zero = 1;
+            }
+            else {
+                break;
+            }
+        }
+        if (*fmt == '*') {
+            int w = va_arg(args, int);
+            if (w < 0) {
+                left = 1;
+                w = -w;
+            }
+            width = (uint32_t)w;
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9') {
+            width = width * 10 + (uint32_t)(*fmt++ - '0');
+        }
+        while (*fmt == 'l') {
+            longs++;
+            fmt++;
+        }
+        switch (*fmt) {
+        case 'd':
+        case 'i': {
+            int64_t value = longs >= 2 ? va_arg(args, int64_t) : va_arg(args, int32_t);
+            uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+            len = kfmt_dec64(digits, magnitude);
+            kfmt_field(&out, value < 0 ? "-" : NULL, digits, len, width, left, zero);
+            break;
+        }
+        case 'u':
+            len = longs >= 2 ? kfmt_dec64(digits, va_arg(args, uint64_t))
+                             : kfmt_dec(digits, va_arg(args, uint32_t));
+            kfmt_field(&out, NULL, digits, len, width, left, zero);
+            break;
+        case 'x':
+        case 'X':
+            len = longs >= 2 ? kfmt_hex64(digits, va_arg(args, uint64_t), *fmt == 'X')
+                             : kfmt_hex(digits, va_arg(args, uint32_t), *fmt == 'X');
+            kfmt_field(&out, NULL, digits, len, width, left, zero);
+            break;
+        case 'p':
+            len = kfmt_hex(digits, (uint32_t)(uintptr_t)va_arg(args, void *), 0);
+            kfmt_field(&out, "0x", digits, len, width, left, zero);
+            break;
+        case 's': {
+            const char *str = va_arg(args, const char *);
+            if (str == NULL) {
+                str = "(null)";
+            }
+            for (len = 0; str[len]; len++);
+            kfmt_field(&out, NULL, str, len, width, left, 0);
+            break;
+        }
+        case 'c':
+            digits[0] = (char)va_arg(args, int);
+            kfmt_field(&out, NULL, digits, 1, width, left, 0);
+            break;
+        case '%':
+            kfmt_putc(&out, '%');
+            break;
+        default:
+            /* Unknown conversion: print it verbatim */
+            kfmt_putc(&out, '%');
+            if (*fmt == '\0') {
+                continue;
+            }
+            kfmt_putc(&out, *fmt);
+            break;
+        }
+        fmt++;
+    }
+    if (size > 0) {
+        buf[out.pos < size ? out.pos : size - 1] = '\0';
+    }
+    return (int)out.pos;
+}
+
+int ksnprintf(char *buf, uint32_t size, const char *fmt, ...) {
+    va_list args;
+    int len;
+    va_start(args, fmt);
+    len = kvsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+/**
+ * Format and print to the console in one write
+ * Output longer than KPRINTF_BUFFER_SIZE - 1 is truncated.
+ * @return: Number of characters printed
+ */
+int kprintf(const char *fmt, ...) {
+    char buf[KPRINTF_BUFFER_SIZE];
+    va_list args;
+    int len;
+    va_start(args, fmt);
+    len = kvsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (len > KPRINTF_BUFFER_SIZE - 1) {
+        len = KPRINTF_BUFFER_SIZE - 1;
+    }
+    serial_puts(buf);
+    return len;
+}
\ No newline at end of file
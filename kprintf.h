@@ -0,0 +1,34 @@
+/* kprintf.h - Formatted output for kacchiOS */
+#ifndef KPRINTF_H
+#define KPRINTF_H
+
+#include "types.h"
+
+#define KPRINTF_BUFFER_SIZE  256     /* Longest line kprintf emits in one write */
+
+//Variable arguments (no <stdarg.h> in a -nostdinc build)
+#ifndef va_start
+typedef __builtin_va_list va_list;
+#define va_start(ap, last)  __builtin_va_start(ap, last)
+#define va_arg(ap, type)    __builtin_va_arg(ap, type)
+#define va_end(ap)          __builtin_va_end(ap)
+#endif
+
+/* printf checking; skipped in hosted builds, where uint64_t is 'unsigned long' and not %ll */
+#ifdef KACCHI_HOSTED
+#define KPRINTF_FORMAT(fmt_index, first_arg)
+#else
+#define KPRINTF_FORMAT(fmt_index, first_arg) __attribute__((format(printf, fmt_index, first_arg)))
+#endif
+
+/*
+ * Supported conversions: %d %i %u %x %X %p %s %c %%
+ * Flags '-' (left align) and '0' (zero pad), a field width (digits or '*'),
+ * and 'l' / 'll' length modifiers ('ll' is 64-bit).
+ */
+int kvsnprintf(char *buf, uint32_t size, const char *fmt, va_list args);
+int ksnprintf(char *buf, uint32_t size, const char *fmt, ...) KPRINTF_FORMAT(3, 4);
+int kprintf(const char *fmt, ...) KPRINTF_FORMAT(1, 2);
+uint32_t kfmt_dec(char *buf, uint32_t value);
+uint32_t kfmt_hex(char *buf, uint32_t value, uint32_t upper);
+#endif
\ No newline at end of file
@@ -0,0 +1,238 @@
+/* latency.c - Interrupts-off section tracer
+ *
+ * Every place that turns interrupts off and back on reports both edges:
+ * spin_lock_irqsave()/spin_unlock_irqrestore() pass their caller's address,
+ * interrupt_dispatch() reports each handler run (interrupt gates enter with
+ * IF clear), and the console's sleep path reports its short cli window.
+ * Only the outermost pair counts - nested irqsave sections see IF already
+ * clear and stay silent. Sections land in a log2 histogram, a per-site
+ * table keyed by the disable call site, and a short list of the longest
+ * ones seen. Sites are raw EIPs; `addr2line -f -e kernel.elf` names them.
+ */
+#include "latency.h"
+#include "spinlock.h"
+#include "smp.h"
+#include "clock.h"
+#include "math64.h"
+#include "serial.h"
+#include "string.h"
+#include "kprintf.h"
+
+//Open section on one CPU
+typedef struct {
+    uint64_t off_at;
+    uint32_t off_site;
+    uint32_t open;
+} latency_cpu_t;
+
+//Aggregate for one disable site
+typedef struct {
+    uint32_t site;
+    uint32_t count;
+    uint32_t max;
+    uint64_t total;
+} latency_site_t;
+
+static latency_cpu_t latency_cpus[SMP_MAX_CPUS];
+static latency_site_t latency_sites[LATENCY_MAX_SITES];
+static latency_section_t latency_longest[LATENCY_WORST];
+static uint32_t latency_histogram[LATENCY_BUCKETS];
+static uint32_t latency_count = 0;
+static uint32_t latency_site_count = 0;
+static uint32_t latency_untracked = 0;     /* Sections whose site found no free slot */
+static volatile uint32_t latency_enabled = 1;
+/* Interrupts are already off wherever this is taken, so a plain lock will do */
+static spinlock_t latency_lock = SPINLOCK_INIT("latency");
+
+/* Histogram bucket for a section length: 0 below 1us, else 1 + log2(us) */
+static uint32_t latency_bucket(uint32_t cycles) {
+    uint32_t cycles_per_us = clock_tsc_khz() / 1000;
+    uint32_t us = cycles / (cycles_per_us ? cycles_per_us : 1);
+    uint32_t bucket = 0;
+    while (us != 0 && bucket < LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Account one finished section; callers have interrupts disabled
+ * @param off_site: Code address that disabled interrupts
+ * @param on_site: Code address that re-enabled them
+ * @param cycles: TSC cycles spent with interrupts off
+ */
+void latency_record(uint32_t off_site, uint32_t on_site, uint64_t cycles) {
+    uint32_t length = (cycles >> 32) ? 0xFFFFFFFF : (uint32_t)cycles;
+    uint32_t i;
+    if (!latency_enabled) {
+        return;
+    }
+    spin_lock(&latency_lock);
+    latency_count++;
+    latency_histogram[latency_bucket(length)]++;
+    for (i = 0; i < latency_site_count && latency_sites[i].site != off_site; i++) {
+    }
+    if (i == latency_site_count && latency_site_count < LATENCY_MAX_SITES) {
+        latency_sites[latency_site_count++].site = off_site;
+    }
+    if (i < latency_site_count) {
+        latency_sites[i].count++;
+        latency_sites[i].total += length;
+        if (length > latency_sites[i].max) {
+            latency_sites[i].max = length;
+        }
+    }
+    else {
+        latency_untracked++;
+    }
+    /* Insertion into the short descending list of longest sections */
+    if (length > latency_longest[LATENCY_WORST - 1].cycles) {
+        i = LATENCY_WORST - 1;
+        while (i > 0 && latency_longest[i - 1].cycles < length) {
+            latency_longest[i] = latency_longest[i - 1];
+            i--;
+        }
+        latency_longest[i].off_site = off_site;
+        latency_longest[i].on_site = on_site;
+        latency_longest[i].cycles = length;
+        latency_longest[i].cpu = smp_cpu_id();
+    }
+    spin_unlock(&latency_lock);
+}
+
+/**
+ * Mark the start of a section; call right after disabling interrupts
+ * @param site: Code address doing the disable
+ */
+void latency_irqs_off(uint32_t site) {
+    latency_cpu_t *cpu;
+    if (!latency_enabled) {
+        return;
+    }
+    cpu = &latency_cpus[smp_cpu_id()];
+    cpu->off_site = site;
+    cpu->open = 1;
+    cpu->off_at = clock_cycles();
+}
+
+/**
+ * Close this CPU's section; call right before enabling interrupts
+ * @param site: Code address doing the enable
+ */
+void latency_irqs_on(uint32_t site) {
+    uint64_t now = clock_cycles();
+    latency_cpu_t *cpu = &latency_cpus[smp_cpu_id()];
+    if (!cpu->open) {
+        return;
+    }
+    cpu->open = 0;
+    latency_record(cpu->off_site, site, now - cpu->off_at);
+}
+
+/**
+ * Turn tracing on or off
+ * @param enabled: Nonzero to trace
+ * @return: Previous setting
+ */
+uint32_t latency_set_enabled(uint32_t enabled) {
+    uint32_t previous = latency_enabled;
+    latency_enabled = enabled ? 1 : 0;
+    return previous;
+}
+
+//Forget everything recorded so far
+void latency_reset(void) {
+    uint32_t flags = spin_lock_irqsave(&latency_lock);
+    memset(latency_sites, 0, sizeof(latency_sites));
+    memset(latency_longest, 0, sizeof(latency_longest));
+    memset(latency_histogram, 0, sizeof(latency_histogram));
+    latency_count = 0;
+    latency_site_count = 0;
+    latency_untracked = 0;
+    /* Our own irqsave section started before the reset; drop it too */
+    latency_cpus[smp_cpu_id()].open = 0;
+    spin_unlock_irqrestore(&latency_lock, flags);
+}
+
+//Sections recorded since boot or the last reset
+uint32_t latency_sections(void) {
+    return latency_count;
+}
+
+//Longest section in TSC cycles
+uint32_t latency_max_cycles(void) {
+    return latency_longest[0].cycles;
+}
+
+//Sections that fell in one histogram bucket
+uint32_t latency_bucket_count(uint32_t bucket) {
+    return bucket < LATENCY_BUCKETS ? latency_histogram[bucket] : 0;
+}
+
+/**
+ * Copy out one of the longest sections
+ * @param rank: 0 for the longest
+ * @param section: Receives the section
+ * @return: 1 if that rank is filled, 0 otherwise
+ */
+uint32_t latency_worst(uint32_t rank, latency_section_t *section) {
+    if (rank >= LATENCY_WORST || latency_longest[rank].cycles == 0) {
+        return 0;
+    }
+    *section = latency_longest[rank];
+    return 1;
+}
+
+//Print the histogram, the longest sections and the per-site table
+void latency_print(void) {
+    uint32_t i;
+    uint32_t peak = 1;
+    latency_section_t section;
+    serial_puts("\n=== Interrupts-Off Latency ===\n");
+    kprintf("Tracing:  %s\n", latency_enabled ? "on" : "off");
+    kprintf("Sections: %u\n", latency_count);
+    kprintf("Max:      %u ns\n", (uint32_t)clock_cycles_to_ns(latency_longest[0].cycles));
+    for (i = 0; i < LATENCY_BUCKETS; i++) {
+        if (latency_histogram[i] > peak) {
+            peak = latency_histogram[i];
+        }
+    }
+    serial_puts("\nLength (us)   | Count\n");
+    for (i = 0; i < LATENCY_BUCKETS; i++) {
+        char bar[41];
+        uint32_t width = (uint32_t)udiv64((uint64_t)latency_histogram[i] * 40, peak);
+        if (latency_histogram[i] == 0) {
+            continue;
+        }
+        if (width == 0) {
+            width = 1;
+        }
+        memset(bar, '#', width);
+        bar[width] = '\0';
+        if (i == LATENCY_BUCKETS - 1) {
+            kprintf("%6u+%6s | %8u %s\n", 1U << (i - 1), "", latency_histogram[i], bar);
+        }
+        else {
+            kprintf("%6u-%-6u | %8u %s\n", i ? 1U << (i - 1) : 0, 1U << i, latency_histogram[i], bar);
+        }
+    }
+    serial_puts("\nLongest sections:\n");
+    serial_puts("  ns       | CPU | Off at   | On at\n");
+    for (i = 0; latency_worst(i, &section); i++) {
+        kprintf("  %-8u | %3u | %08X | %08X\n", (uint32_t)clock_cycles_to_ns(section.cycles),
+                section.cpu, section.off_site, section.on_site);
+    }
+    serial_puts("\nBy disable site:\n");
+    serial_puts("  Site     | Count    | Avg ns   | Max ns\n");
+    for (i = 0; i < latency_site_count; i++) {
+        latency_site_t *site = &latency_sites[i];
+        kprintf("  %08X | %8u | %8u | %u\n", site->site, site->count,
+                (uint32_t)clock_cycles_to_ns(udiv64(site->total, site->count)),
+                (uint32_t)clock_cycles_to_ns(site->max));
+    }
+    if (latency_untracked != 0) {
+        kprintf("  (%u sections from untracked sites)\n", latency_untracked);
+    }
+    serial_puts("\n");
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+/* latency.h - Interrupts-off section tracer */
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "types.h"
+
+#define LATENCY_BUCKETS     16        /* <1us, then powers of two up to >=16ms */
+#define LATENCY_WORST       8         /* Longest sections kept with both call sites */
+#define LATENCY_MAX_SITES   32        /* Distinct disable sites tracked */
+
+//Call site of the function this appears in, as recorded by the tracer
+#define LATENCY_CALLER() ((uint32_t)(uintptr_t)__builtin_return_address(0))
+
+//One of the longest sections seen
+typedef struct {
+    uint32_t off_site;                /* Where interrupts were disabled */
+    uint32_t on_site;                 /* Where they were enabled again */
+    uint32_t cycles;
+    uint32_t cpu;
+} latency_section_t;
+
+//Function declarations
+void latency_irqs_off(uint32_t site);
+void latency_irqs_on(uint32_t site);
+void latency_record(uint32_t off_site, uint32_t on_site, uint64_t cycles);
+uint32_t latency_set_enabled(uint32_t enabled);
+void latency_reset(void);
+uint32_t latency_sections(void);
+uint32_t latency_max_cycles(void);
+uint32_t latency_bucket_count(uint32_t bucket);
+uint32_t latency_worst(uint32_t rank, latency_section_t *section);
+void latency_print(void);
+#endif
\ No newline at end of file
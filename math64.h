@@ -0,0 +1,24 @@
+/* math64.h - 64-bit arithmetic helpers (no libgcc in a freestanding build) */
+#ifndef MATH64_H
+#define MATH64_H
+
+#include "types.h"
+
+/**
+ * Divide a 64-bit value by a 32-bit divisor
+ * Two chained divl instructions, so no __udivdi3 is needed.
+ * @param dividend: Value to divide
+ * @param divisor: Non-zero divisor
+ * @return: 64-bit quotient
+ */
+static inline uint64_t udiv64(uint64_t dividend, uint32_t divisor) {
+    uint32_t hi = (uint32_t)(dividend >> 32);
+    uint32_t lo = (uint32_t)dividend;
+    uint32_t q_hi = hi / divisor;
+    uint32_t rem = hi % divisor;
+    uint32_t q_lo;
+    __asm__ ("divl %2" : "=a"(q_lo), "+d"(rem) : "rm"(divisor), "0"(lo));
+    return ((uint64_t)q_hi << 32) | q_lo;
+}
+
+#endif
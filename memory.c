@@ -1,9 +1,13 @@
 #include "memory.h"
 #include "serial.h"
 #include "string.h"
+#include "spinlock.h"
+#include "kprintf.h"
+#include "debugcon.h"
 
 static memory_allocator_t allocator;
 static uint32_t heap_pointer;
+static spinlock_t memory_lock = SPINLOCK_INIT("memory");
 
 static void memory_compact_tail(void) {
     while (allocator.block_count > 0) {
@@ -40,12 +44,33 @@ void memory_init(void) {
 }
 
 /**
- * Allocate memory for a process
- * @param size: Size of memory to allocate
- * @param process_id: ID of the process requesting memory
- * @return: Address of allocated memory, or 0 on failure
+ * Move the empty process heap above memory that is already in use
+ * The boot loader drops modules past the kernel, where the heap would start.
+ * @param end: First byte the heap may use
+ * @return: 1 if the heap now starts at or above end, 0 if it is not empty
  */
-uint32_t memory_allocate(uint32_t size, uint32_t process_id) {
+uint32_t memory_reserve_below(uint32_t end) {
+    uint32_t start = (end + 0xFFF) & ~0xFFFU;
+    uint32_t moved = 0;
+    uint32_t flags = spin_lock_irqsave(&memory_lock);
+    if (start <= allocator.heap_start) {
+        moved = 1;
+    }
+    else if (allocator.block_count == 0) {
+        allocator.heap_start = start;
+        allocator.heap_end = start + PROCESS_HEAP_SIZE;
+        heap_pointer = start;
+        moved = 1;
+    }
+    spin_unlock_irqrestore(&memory_lock, flags);
+    if (!moved) {
+        serial_puts("[MEMORY] ERROR: Cannot move a heap that is in use\n");
+    }
+    return moved;
+}
+
+/* Caller holds memory_lock */
+static uint32_t memory_allocate_locked(uint32_t size, uint32_t process_id) {
     uint32_t i;
     if (size == 0) {
         serial_puts("[MEMORY] ERROR: Zero-size allocation requested\n");
@@ -80,23 +105,44 @@ uint32_t memory_allocate(uint32_t size, uint32_t process_id) {
     return allocated_addr;
 }
 
+/**
+ * Allocate memory for a process
+ * @param size: Size of memory to allocate
+ * @param process_id: ID of the process requesting memory
+ * @return: Address of allocated memory, or 0 on failure
+ */
+uint32_t memory_allocate(uint32_t size, uint32_t process_id) {
+    uint32_t flags = spin_lock_irqsave(&memory_lock);
+    uint32_t address = memory_allocate_locked(size, process_id);
+    spin_unlock_irqrestore(&memory_lock, flags);
+    if (address != 0) {
+        debugcon_emit(DBG_EV_ALLOC, process_id, address, size);
+    }
+    return address;
+}
+
 /**
  * Free memory at a specific address
  * @param address: Address of memory to free
  */
 void memory_free(uint32_t address) {
+    uint32_t flags = spin_lock_irqsave(&memory_lock);
     memory_block_t *block = memory_find_block(address);
 
     if (block == NULL) {
+        spin_unlock_irqrestore(&memory_lock, flags);
         serial_puts("[MEMORY] WARNING: Attempted to free unallocated address\n");
         return;
     }
     if (block->state == FREE) {
+        spin_unlock_irqrestore(&memory_lock, flags);
         serial_puts("[MEMORY] WARNING: Attempted double free detected\n");
         return;
     }
     block->state = FREE;
+    debugcon_emit(DBG_EV_FREE, block->process_id, address, block->size);
     memory_compact_tail();
+    spin_unlock_irqrestore(&memory_lock, flags);
 }
 
 /**
@@ -107,19 +153,24 @@ void memory_free_process(uint32_t process_id) {
     uint32_t i;
     uint32_t freed_count = 0;
     uint32_t freed_bytes = 0;
+    uint32_t flags = spin_lock_irqsave(&memory_lock);
     for (i = 0; i < allocator.block_count; i++) {
         if (allocator.blocks[i].process_id == process_id && 
             allocator.blocks[i].state == ALLOCATED) {
             allocator.blocks[i].state = FREE;
+            debugcon_emit(DBG_EV_FREE, process_id, allocator.blocks[i].address, allocator.blocks[i].size);
             freed_count++;
             freed_bytes += allocator.blocks[i].size;
         }
     }
+    if (freed_count > 0) {
+        memory_compact_tail();
+    }
+    spin_unlock_irqrestore(&memory_lock, flags);
     if (freed_count == 0) {
         serial_puts("[MEMORY] WARNING: No allocated blocks found for process\n");
         return;
     }
-    memory_compact_tail();
     serial_puts("[MEMORY] Freed ");
     serial_put_dec(freed_bytes);
     serial_puts(" bytes across ");
@@ -134,10 +185,11 @@ void memory_print_status(void) {
     uint32_t i;
     uint32_t total_allocated = 0;
     uint32_t total_free = 0;
+    uint32_t flags = spin_lock_irqsave(&memory_lock);
     uint32_t unallocated_tail = allocator.heap_end - heap_pointer;
     serial_puts("\n=== Memory Status ===\n");
-    serial_puts("Block Address | Size      | State    | Process ID\n");
-    serial_puts("----------------------------------------------\n");
+    serial_puts("Block Address | Size          | State     | Process ID\n");
+    serial_puts("------------------------------------------------------\n");
     for (i = 0; i < allocator.block_count; i++) {
         memory_block_t *block = &allocator.blocks[i];
         if (block->state == ALLOCATED) {
@@ -146,17 +198,16 @@ void memory_print_status(void) {
         else {
             total_free += block->size;
         }
-        serial_puts("0x");
-        serial_put_hex(block->address);
-        serial_puts(" | ");
-        serial_put_dec(block->size);
-        serial_puts(" bytes | ");
-        serial_puts(block->state == ALLOCATED ? "ALLOCATED" : "FREE     ");
-        serial_puts(" | ");
-        serial_put_dec(block->process_id);
-        serial_puts("\n");
-    }
-    serial_puts("----------------------------------------------\n");
+        if (block->process_id == MEMORY_OWNER_SHARED) {
+            kprintf("0x%08X    | %7u bytes | %-9s | shared\n", block->address, block->size,
+                    block->state == ALLOCATED ? "ALLOCATED" : "FREE");
+        }
+        else {
+            kprintf("0x%08X    | %7u bytes | %-9s | %u\n", block->address, block->size,
+                    block->state == ALLOCATED ? "ALLOCATED" : "FREE", block->process_id);
+        }
+    }
+    serial_puts("------------------------------------------------------\n");
     serial_puts("Total Allocated: ");
     serial_put_dec(total_allocated);
     serial_puts(" bytes\n");
@@ -169,4 +220,5 @@ void memory_print_status(void) {
     serial_puts("Heap Pointer: 0x");
     serial_put_hex(heap_pointer);
     serial_puts("\n\n");
+    spin_unlock_irqrestore(&memory_lock, flags);
 }
@@ -2,12 +2,14 @@
 #define MEMORY_H
 
 #include "types.h"
+#include "config.h"
 
 #define KERNEL_HEAP_START   0x10000
 #define KERNEL_HEAP_SIZE    0x100000  
-#define PROCESS_HEAP_START  0x110000
+#define PROCESS_HEAP_START  0x200000      /* Above the kernel image; link.ld checks */
 #define PROCESS_HEAP_SIZE   0x400000      
-#define MAX_MEMORY_BLOCKS   256
+#define MAX_MEMORY_BLOCKS   CONFIG_MAX_MEMORY_BLOCKS
+#define MEMORY_OWNER_SHARED 0xFFFFFFFF    /* Owner of shm.c regions; never a process ID */
 
 typedef enum {
     FREE,
@@ -29,6 +31,7 @@ typedef struct {
 } memory_allocator_t;
 
 void memory_init(void);
+uint32_t memory_reserve_below(uint32_t end);
 uint32_t memory_allocate(uint32_t size, uint32_t process_id);
 void memory_free(uint32_t address);
 void memory_free_process(uint32_t process_id);
@@ -0,0 +1,34 @@
+/* multiboot.h - Multiboot (version 1) boot information passed in EAX/EBX */
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+#include "types.h"
+
+#define MULTIBOOT_HEADER_MAGIC      0x1BADB002
+#define MULTIBOOT_BOOTLOADER_MAGIC  0x2BADB002    /* In EAX when the loader jumps to start */
+#define MULTIBOOT_PAGE_ALIGN        (1 << 0)      /* Header flag: load modules on page boundaries */
+
+//multiboot_info_t.flags bits
+#define MULTIBOOT_INFO_MEMORY       (1 << 0)
+#define MULTIBOOT_INFO_CMDLINE      (1 << 2)
+#define MULTIBOOT_INFO_MODS         (1 << 3)
+
+//Boot information; only the fields up to the module list are used
+typedef struct {
+    uint32_t flags;
+    uint32_t mem_lower;               /* KB below 1MB */
+    uint32_t mem_upper;               /* KB above 1MB */
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;               /* Array of multiboot_module_t */
+} __attribute__((packed)) multiboot_info_t;
+
+//One boot module (QEMU -initrd, GRUB module)
+typedef struct {
+    uint32_t mod_start;
+    uint32_t mod_end;                 /* One past the last byte */
+    uint32_t string;                  /* Module command line, NUL terminated */
+    uint32_t reserved;
+} __attribute__((packed)) multiboot_module_t;
+#endif
\ No newline at end of file
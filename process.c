@@ -1,9 +1,27 @@
 #include "process.h"
 #include "memory.h"
+#include "scheduler.h"
+#include "ipc.h"
+#include "sync.h"
+#include "shm.h"
+#include "ring.h"
+#include "deferred.h"
 #include "serial.h"
 #include "string.h"
-static process_table_t process_table;
+#include "spinlock.h"
+#include "cpu.h"
+#include "kprintf.h"
+#include "clock.h"
+#include "math64.h"
+process_table_t process_table;
+/* Serializes writers; lookups are lock-free because slots never move */
+static spinlock_t process_lock = SPINLOCK_INIT("process");
 static uint32_t global_time = 0;
+/* CPU cycles per table slot at the previous process_print_top() refresh */
+static uint64_t top_prev_cycles[MAX_PROCESSES];
+static uint32_t top_order[MAX_PROCESSES];
+static uint64_t top_delta[MAX_PROCESSES];
+static uint64_t top_prev_tsc = 0;
 void process_init(void) {
     process_table.process_count = 0;
     process_table.next_process_id = 1;
@@ -11,15 +29,44 @@ void process_init(void) {
     process_table.processes[0].process_id = 0;
     process_table.processes[0].state = CURRENT;
     process_table.processes[0].priority = 0;
+    process_table.processes[0].base_priority = 0;
     process_table.processes[0].stack_base = 0x20000;
     process_table.processes[0].stack_size = 0x1000;
     process_table.processes[0].heap_base = 0x21000;
     process_table.processes[0].heap_size = 0x2000;
     process_table.processes[0].creation_time = 0;
     process_table.processes[0].wait_time = 0;
+    process_table.processes[0].sched_class = SCHED_CLASS_NORMAL;
+    process_table.processes[0].cpu = 0;
+    process_table.processes[0].cpu_cycles = 0;
+    process_table.processes[0].run_start = rdtsc();
+    process_table.processes[0].switches_in = 0;
+    process_table.processes[0].voluntary_switches = 0;
+    process_table.processes[0].involuntary_switches = 0;
     process_table.process_count = 1;
+    // IPC endpoints, lock waits, shm attachments and rings are per slot, so they go with the table
+    ipc_init();
+    sync_init();
+    shm_init();
+    ring_init();
+    // Deferred-work workers were table entries too
+    deferred_forget_workers();
     serial_puts("[PROCESS] Process manager initialized\n");
 }
+/* Fixed-width state column for the process listings */
+static const char* process_state_label(process_state_t state) {
+    if (state == CURRENT) {
+        return "CURRENT ";
+    }
+    if (state == READY) {
+        return "READY   ";
+    }
+    if (state == BLOCKED) {
+        return "BLOCKED ";
+    }
+    return "TERM.   ";
+}
+
 /**
  * Create a new process
  * @param priority: Process priority (0-255, lower number = higher priority)
@@ -28,34 +75,64 @@ void process_init(void) {
  * @return: Process ID, or 0 on failure
  */
 uint32_t process_create(uint32_t priority, uint32_t stack_size, uint32_t heap_size) {
-    if (process_table.process_count >= 256) {
+    uint32_t flags = spin_lock_irqsave(&process_lock);
+    uint32_t slot = process_table.process_count;
+    if (slot >= MAX_PROCESSES) {
+        // Table full: recycle the first terminated slot
+        for (slot = 1; slot < MAX_PROCESSES; slot++) {
+            if (process_table.processes[slot].state == TERMINATED) {
+                break;
+            }
+        }
+    }
+    if (slot >= MAX_PROCESSES) {
+        spin_unlock_irqrestore(&process_lock, flags);
         serial_puts("[PROCESS] ERROR: Process table full\n");
         return 0;
     }
     uint32_t pid = process_table.next_process_id++;
-    process_control_block_t *pcb = &process_table.processes[process_table.process_count];
+    process_control_block_t *pcb = &process_table.processes[slot];
     // Allocate stack and heap
     uint32_t stack_base = memory_allocate(stack_size, pid);
     uint32_t heap_base = memory_allocate(heap_size, pid);
     if (stack_base == 0 || heap_base == 0) {
+        spin_unlock_irqrestore(&process_lock, flags);
         serial_puts("[PROCESS] ERROR: Failed to allocate memory for process\n");
         return 0;
     }
     // Initialize PCB
     pcb->process_id = pid;
-    pcb->state = READY;
     pcb->priority = priority;
+    pcb->base_priority = priority;
     pcb->stack_base = stack_base;
     pcb->stack_size = stack_size;
     pcb->heap_base = heap_base;
     pcb->heap_size = heap_size;
     pcb->creation_time = global_time;
     pcb->wait_time = 0;
+    pcb->sched_class = SCHED_CLASS_NORMAL;
+    memset(&pcb->edf, 0, sizeof(pcb->edf));
+    pcb->mlfq_level = 0;
+    pcb->ready_since = 0;
+    pcb->cpu_cycles = 0;
+    pcb->run_start = 0;
+    pcb->switches_in = 0;
+    pcb->voluntary_switches = 0;
+    pcb->involuntary_switches = 0;
     // Initialize CPU context
     pcb->context.esp = stack_base + stack_size;
     pcb->context.ebp = pcb->context.esp;
     pcb->context.eip = 0;
-    process_table.process_count++;
+    top_prev_cycles[slot] = 0;
+    // Publish the slot only once it is fully initialized
+    __sync_synchronize();
+    pcb->state = READY;
+    if (slot == process_table.process_count) {
+        process_table.process_count++;
+    }
+    spin_unlock_irqrestore(&process_lock, flags);
+    // Home the process on the least loaded CPU
+    scheduler_enqueue_process(pid);
     return pid;
 }
 
@@ -68,8 +145,16 @@ void process_terminate(uint32_t process_id) {
     for (i = 0; i < process_table.process_count; i++) {
         if (process_table.processes[i].process_id == process_id) {
             process_table.processes[i].state = TERMINATED;
-            // Free memory allocated to this process
+            // Remove from its run queue and drop any real-time reservation
+            scheduler_remove_process(process_id);
+            // Free memory allocated to this process; shared regions only lose a reference
             memory_free_process(process_id);
+            shm_process_exit(process_id);
+            // Release anyone waiting on it in IPC, pass on the mutexes it held and close its rings
+            ipc_process_exit(process_id);
+            sync_process_exit(process_id);
+            ring_process_exit(process_id);
+            deferred_process_exit(process_id);
             serial_puts("[PROCESS] Process ");
             serial_put_dec(process_id);
             serial_puts(" terminated\n");
@@ -124,30 +209,69 @@ process_control_block_t* process_get_pcb(uint32_t process_id) {
 void process_print_table(void) {
     uint32_t i;
     serial_puts("\n=== Process Table ===\n");
-    serial_puts("PID | State    | Priority | Stack Base | Heap Base | Wait Time\n");
-    serial_puts("-----------------------------------------------------------\n");
+    serial_puts("PID   | State    | Priority | Stack Base | Heap Base  | Wait Time\n");
+    serial_puts("---------------------------------------------------------------\n");
     for (i = 0; i < process_table.process_count; i++) {
         process_control_block_t *pcb = &process_table.processes[i];
-        serial_put_dec(pcb->process_id);
-        serial_puts("   | ");
-        if (pcb->state == CURRENT) {
-            serial_puts("CURRENT ");
-        } 
-        else if (pcb->state == READY) {
-            serial_puts("READY   ");
-        } 
-        else {
-            serial_puts("TERM.   ");
-        }
-        serial_puts("| ");
-        serial_put_dec(pcb->priority);
-        serial_puts("       | 0x");
-        serial_put_hex(pcb->stack_base);
-        serial_puts(" | 0x");
-        serial_put_hex(pcb->heap_base);
-        serial_puts(" | ");
-        serial_put_dec(pcb->wait_time);
-        serial_puts("\n");
-    }
-    serial_puts("-----------------------------------------------------------\n\n");
+        kprintf("%-5u | %s | %8u | 0x%08X | 0x%08X | %9u\n", pcb->process_id,
+                process_state_label(pcb->state), pcb->priority, pcb->stack_base,
+                pcb->heap_base, scheduler_wait_time(pcb));
+    }
+    serial_puts("---------------------------------------------------------------\n\n");
 }
+
+
+/* CPU cycles consumed so far, including the slice in progress */
+static uint64_t process_cycles(process_control_block_t *pcb, uint64_t now) {
+    if (pcb->state == CURRENT) {
+        return pcb->cpu_cycles + (now - pcb->run_start);
+    }
+    return pcb->cpu_cycles;
+}
+
+//Print live processes sorted by CPU usage since the previous call
+void process_print_top(void) {
+    uint32_t *order = top_order;
+    uint64_t *delta = top_delta;
+    uint32_t count = 0;
+    uint32_t i, j;
+    uint64_t now = rdtsc();
+    uint64_t interval = now - top_prev_tsc;
+    uint32_t shift = 0;
+    for (i = 0; i < process_table.process_count; i++) {
+        process_control_block_t *pcb = &process_table.processes[i];
+        uint64_t cycles;
+        if (pcb->state == TERMINATED) {
+            continue;
+        }
+        cycles = process_cycles(pcb, now);
+        delta[i] = cycles >= top_prev_cycles[i] ? cycles - top_prev_cycles[i] : cycles;
+        top_prev_cycles[i] = cycles;
+        /* Insertion sort, busiest first */
+        for (j = count; j > 0 && delta[order[j - 1]] < delta[i]; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+        count++;
+    }
+    top_prev_tsc = now;
+    /* Scale down until per-mille math fits in 32 bits */
+    while ((interval >> shift) > 0x3FFFFF) {
+        shift++;
+    }
+    interval = (interval >> shift) ? (interval >> shift) : 1;
+    serial_puts("PID   | State    |  %CPU |  CPU ms | Switches |   Vol | Invol\n");
+    serial_puts("-------------------------------------------------------------\n");
+    for (i = 0; i < count; i++) {
+        process_control_block_t *pcb = &process_table.processes[order[i]];
+        uint32_t permille = (uint32_t)(delta[order[i]] >> shift) * 1000 / (uint32_t)interval;
+        if (permille > 1000) {
+            permille = 1000;
+        }
+        kprintf("%-5u | %s | %3u.%u | %7u | %8u | %5u | %5u\n", pcb->process_id,
+                process_state_label(pcb->state), permille / 10, permille % 10,
+                (uint32_t)udiv64(clock_cycles_to_ns(process_cycles(pcb, now)), 1000000), pcb->switches_in,
+                pcb->voluntary_switches, pcb->involuntary_switches);
+    }
+    serial_puts("-------------------------------------------------------------\n");
+}
\ No newline at end of file
@@ -2,11 +2,15 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 #include "types.h"
+#include "config.h"
+#include "timer.h"
+#define MAX_PROCESSES CONFIG_MAX_PROCS
 //Process states
 typedef enum {
     TERMINATED = 0,
     READY = 1,
-    CURRENT = 2
+    CURRENT = 2,
+    BLOCKED = 3              /* Waiting for scheduler_wake() */
 } process_state_t;
 //CPU context for context switching
 typedef struct {
@@ -21,11 +25,28 @@ typedef struct {
     uint32_t eip;
     uint32_t eflags;
 } cpu_context_t;
+//Scheduling classes (EDF takes precedence over the normal FCFS/RR class)
+typedef enum {
+    SCHED_CLASS_NORMAL = 0,
+    SCHED_CLASS_EDF = 1
+} sched_class_t;
+//Earliest-deadline-first parameters, all in scheduler ticks
+typedef struct {
+    uint32_t runtime;          /* Budget per period */
+    uint32_t period;           /* Release interval */
+    uint32_t deadline;         /* Relative deadline (runtime <= deadline <= period) */
+    uint32_t abs_deadline;     /* Absolute deadline of the current job */
+    uint32_t next_release;     /* Time the next job is released */
+    uint32_t remaining;        /* Budget left in the current job, 0 = no active job */
+    uint32_t deadline_misses;
+    uint32_t heap_index;       /* Position in the scheduler's deadline heap */
+} edf_params_t;
 //Process Control Block (PCB)
 typedef struct {
     uint32_t process_id;
     process_state_t state;
     uint32_t priority;
+    uint32_t base_priority;  /* Priority without inheritance; aging promotes both */
     uint32_t stack_base;
     uint32_t stack_size;
     uint32_t heap_base;
@@ -33,13 +54,37 @@ typedef struct {
     cpu_context_t context;
     uint32_t creation_time;
     uint32_t wait_time;      
+    sched_class_t sched_class;
+    edf_params_t edf;
+    uint32_t cpu;            /* CPU whose run queue holds this process */
+    uint32_t mlfq_level;     /* MLFQ queue level, 0 = highest priority */
+    uint32_t ready_since;    /* Time it last became READY (RR/MLFQ FIFO order) */
+    uint32_t wait_since;     /* Time wait_time was last brought up to date */
+    timer_event_t aging_timer;       /* Pending while READY: next aging promotion */
+    timer_event_t sleep_timer;       /* Pending while in scheduler_sleep() */
+    uint64_t cpu_cycles;     /* TSC cycles spent CURRENT */
+    uint64_t run_start;      /* TSC when last switched in */
+    uint32_t switches_in;
+    uint32_t voluntary_switches;     /* Gave up the CPU itself */
+    uint32_t involuntary_switches;   /* Preempted */
 } process_control_block_t;
 //Process table
 typedef struct {
-    process_control_block_t processes[256];
+    process_control_block_t processes[MAX_PROCESSES];
     uint32_t process_count;
     uint32_t next_process_id;
 } process_table_t;
+//Shared with the scheduler for inlined scans; slots are never moved, and only
+//reused (TERMINATED -> READY) once the table has filled up
+extern process_table_t process_table;
+//Number of used table slots; slot 0 is the null process
+static inline uint32_t process_slot_count(void) {
+    return process_table.process_count;
+}
+//PCB in a table slot (slot order is creation order)
+static inline process_control_block_t* process_slot(uint32_t slot) {
+    return &process_table.processes[slot];
+}
 //Function declarations 
 void process_init(void);
 uint32_t process_create(uint32_t priority, uint32_t stack_size, uint32_t heap_size);
@@ -48,4 +93,5 @@ void process_set_state(uint32_t process_id, process_state_t state);
 process_state_t process_get_state(uint32_t process_id);
 process_control_block_t* process_get_pcb(uint32_t process_id);
 void process_print_table(void);
+void process_print_top(void);
 #endif
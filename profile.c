@@ -0,0 +1,159 @@
+/* profile.c - Timer-driven statistical sampling profiler
+ *
+ * PIT channel 0 interrupts the boot CPU at a fixed rate and the handler
+ * charges one sample to the interrupted EIP in a hash histogram. It also
+ * walks the frame-pointer chain into a ring of recent call stacks; that
+ * needs a `make PROFILE_FP=1` build, and without one the walk usually stops
+ * at the first frame. `profile dump` prints both as text that
+ * tools/symbolize_profile.py turns into a flat profile or folded stacks.
+ */
+#include "profile.h"
+#include "interrupt.h"
+#include "clock.h"
+#include "serial.h"
+#include "string.h"
+#include "kprintf.h"
+
+//One histogram entry
+typedef struct {
+    uint32_t eip;
+    uint32_t count;
+} profile_bucket_t;
+
+//One sampled call stack, innermost first
+typedef struct {
+    uint32_t depth;
+    uint32_t pc[PROFILE_STACK_DEPTH];
+} profile_stack_t;
+
+extern char __bss_start[];          /* link.ld: end of .text/.rodata/.data */
+
+static profile_bucket_t profile_buckets[PROFILE_BUCKETS];
+static profile_stack_t profile_stacks[PROFILE_STACK_SAMPLES];
+static uint32_t profile_stack_next = 0;
+static uint32_t profile_total = 0;
+static uint32_t profile_dropped = 0;      /* Samples whose EIP found no free bucket */
+static uint32_t profile_hz = 0;           /* Rate of the last start; kept after a stop for the dump */
+
+/* Whether a value can be a return address into the kernel image */
+static uint32_t profile_is_text(uint32_t pc) {
+    return pc >= 0x100000 && pc < (uint32_t)__bss_start;
+}
+
+/**
+ * Charge one sample; called from the timer interrupt
+ * @param eip: Interrupted instruction
+ * @param ebp: Interrupted frame pointer, 0 to skip the stack walk
+ * @param esp: Interrupted stack pointer; bounds the frame-pointer walk
+ */
+void profile_record(uint32_t eip, uint32_t ebp, uint32_t esp) {
+    uint32_t index = (eip * 2654435761U) >> (32 - PROFILE_BUCKET_BITS);
+    uint32_t probe;
+    profile_stack_t *stack = &profile_stacks[profile_stack_next++ & (PROFILE_STACK_SAMPLES - 1)];
+    profile_total++;
+    for (probe = 0; probe < PROFILE_BUCKETS; probe++) {
+        profile_bucket_t *bucket = &profile_buckets[(index + probe) & (PROFILE_BUCKETS - 1)];
+        if (bucket->count == 0) {
+            bucket->eip = eip;
+        }
+        if (bucket->eip == eip) {
+            bucket->count++;
+            break;
+        }
+    }
+    if (probe == PROFILE_BUCKETS) {
+        profile_dropped++;
+    }
+    stack->pc[0] = eip;
+    stack->depth = 1;
+    /* Each frame is [saved ebp][return address]; stop at anything implausible */
+    while (stack->depth < PROFILE_STACK_DEPTH && ebp != 0 && ebp >= esp &&
+           ebp - esp < PROFILE_STACK_WINDOW && (ebp & 3) == 0) {
+        uint32_t *frame = (uint32_t *)ebp;
+        if (!profile_is_text(frame[1])) {
+            break;
+        }
+        stack->pc[stack->depth++] = frame[1];
+        if (frame[0] <= ebp) {
+            break;
+        }
+        ebp = frame[0];
+    }
+}
+
+static void profile_tick(interrupt_frame_t *frame) {
+    /* No privilege change, so the interrupted esp is just past the CPU-pushed words */
+    profile_record(frame->eip, frame->ebp, (uint32_t)(&frame->eflags + 1));
+}
+
+//Forget all samples
+void profile_reset(void) {
+    memset(profile_buckets, 0, sizeof(profile_buckets));
+    memset(profile_stacks, 0, sizeof(profile_stacks));
+    profile_stack_next = 0;
+    profile_total = 0;
+    profile_dropped = 0;
+}
+
+/**
+ * Start sampling from a clean histogram
+ * @param hz: Sample rate, PROFILE_MIN_HZ .. PROFILE_MAX_HZ
+ * @return: 1 on success, 0 if the rate is out of range
+ */
+uint32_t profile_start(uint32_t hz) {
+    if (hz < PROFILE_MIN_HZ || hz > PROFILE_MAX_HZ) {
+        serial_puts("[PROFILE] ERROR: Sample rate out of range\n");
+        return 0;
+    }
+    irq_mask(IRQ_TIMER);
+    profile_reset();
+    profile_hz = clock_pit_periodic(hz);
+    irq_register(IRQ_TIMER, profile_tick);
+    return 1;
+}
+
+//Stop sampling; the histogram is kept for profile_dump()
+void profile_stop(void) {
+    irq_mask(IRQ_TIMER);
+}
+
+//Samples taken since the last start or reset
+uint32_t profile_samples(void) {
+    return profile_total;
+}
+
+//Samples charged to one EIP
+uint32_t profile_count(uint32_t eip) {
+    uint32_t i;
+    for (i = 0; i < PROFILE_BUCKETS; i++) {
+        if (profile_buckets[i].count != 0 && profile_buckets[i].eip == eip) {
+            return profile_buckets[i].count;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Print the histogram and recent stacks for tools/symbolize_profile.py
+ * "P <eip> <count>" lines are the flat profile, "S <pc> <pc>..." lines are
+ * call stacks innermost first, bracketed by PROFILE_BEGIN/PROFILE_END.
+ */
+void profile_dump(void) {
+    uint32_t i, j;
+    uint32_t stacks = profile_stack_next < PROFILE_STACK_SAMPLES ? profile_stack_next : PROFILE_STACK_SAMPLES;
+    kprintf("PROFILE_BEGIN hz=%u samples=%u dropped=%u\n", profile_hz, profile_total, profile_dropped);
+    for (i = 0; i < PROFILE_BUCKETS; i++) {
+        if (profile_buckets[i].count != 0) {
+            kprintf("P %08X %u\n", profile_buckets[i].eip, profile_buckets[i].count);
+        }
+    }
+    for (i = 0; i < stacks; i++) {
+        profile_stack_t *stack = &profile_stacks[i];
+        serial_puts("S");
+        for (j = 0; j < stack->depth; j++) {
+            kprintf(" %08X", stack->pc[j]);
+        }
+        serial_puts("\n");
+    }
+    serial_puts("PROFILE_END\n");
+}
\ No newline at end of file
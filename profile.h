@@ -0,0 +1,24 @@
+/* profile.h - Timer-driven statistical sampling profiler */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "types.h"
+
+#define PROFILE_DEFAULT_HZ     1000
+#define PROFILE_MIN_HZ         19        /* Slowest rate the 16-bit PIT divisor allows */
+#define PROFILE_MAX_HZ         10000
+#define PROFILE_BUCKET_BITS    11
+#define PROFILE_BUCKETS        (1 << PROFILE_BUCKET_BITS)   /* Distinct sampled EIPs */
+#define PROFILE_STACK_SAMPLES  512       /* Recent call stacks kept for folded output; power of two */
+#define PROFILE_STACK_DEPTH    8         /* Return addresses walked per sample */
+#define PROFILE_STACK_WINDOW   0x4000    /* Frame pointers must lie this close above the sample's esp */
+
+//Function declarations
+uint32_t profile_start(uint32_t hz);
+void profile_stop(void);
+void profile_reset(void);
+void profile_record(uint32_t eip, uint32_t ebp, uint32_t esp);
+uint32_t profile_samples(void);
+uint32_t profile_count(uint32_t eip);
+void profile_dump(void);
+#endif
\ No newline at end of file
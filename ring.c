@@ -0,0 +1,265 @@
+/* ring.c - Lock-free single-producer/single-consumer ring channels
+ *
+ * The producer only writes head and the consumer only writes tail, each on
+ * its own cache line, so the two sides never contend for a line except to
+ * refresh their cached copy of the other index - and they only do that
+ * when the cached copy says the ring is full (producer) or empty
+ * (consumer). A batch costs one index store however many entries it
+ * carries. x86 keeps stores in order and loads in order, so publishing
+ * needs only compiler barriers; the one full fence pairs with ring_wait()
+ * so a consumer never sleeps through a publish.
+ */
+#include "ring.h"
+#include "process.h"
+#include "scheduler.h"
+#include "spinlock.h"
+#include "serial.h"
+#include "string.h"
+#include "kprintf.h"
+
+static ring_t rings[RING_MAX_CHANNELS];
+/* Entry storage, one row per ring; kernel memory, so both ends can reach it */
+static uint32_t ring_storage[RING_MAX_CHANNELS][RING_MAX_ENTRIES] __attribute__((aligned(RING_CACHE_LINE)));
+/* Slow paths only: create, close, block and wake. Taken before the scheduler lock */
+static spinlock_t ring_lock = SPINLOCK_INIT("ring");
+
+static uint32_t ring_live_pid(uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    return pid != 0 && pcb != NULL && pcb->state != TERMINATED;
+}
+
+//Forget every ring; the allocator and process table have been reset
+void ring_init(void) {
+    uint32_t flags = spin_lock_irqsave(&ring_lock);
+    memset(rings, 0, sizeof(rings));
+    spin_unlock_irqrestore(&ring_lock, flags);
+}
+
+/**
+ * Create a ring between two processes
+ * @param name: Shown by ring_print_stats(), at most RING_NAME_LEN - 1 characters
+ * @param capacity: Entries, at most RING_MAX_ENTRIES; rounded up to a power of two
+ * @param producer_pid: The only process that may call ring_publish()
+ * @param consumer_pid: The only process that may call ring_consume() and ring_wait()
+ * @return: The ring, or NULL on invalid arguments or when every ring is in use
+ */
+ring_t* ring_create(const char *name, uint32_t capacity, uint32_t producer_pid, uint32_t consumer_pid) {
+    ring_t *ring = NULL;
+    uint32_t size = 2;
+    uint32_t i;
+    uint32_t flags;
+    if (!ring_live_pid(producer_pid) || !ring_live_pid(consumer_pid) ||
+        capacity == 0 || capacity > RING_MAX_ENTRIES || strlen(name) >= RING_NAME_LEN) {
+        serial_puts("[RING] ERROR: Invalid ring parameters\n");
+        return NULL;
+    }
+    while (size < capacity) {
+        size <<= 1;
+    }
+    flags = spin_lock_irqsave(&ring_lock);
+    for (i = 0; i < RING_MAX_CHANNELS && ring == NULL; i++) {
+        if (rings[i].slots == NULL) {
+            ring = &rings[i];
+            strcpy(ring->name, name);
+            ring->slots = ring_storage[i];
+            ring->mask = size - 1;
+            ring->producer = producer_pid;
+            ring->consumer = consumer_pid;
+        }
+    }
+    spin_unlock_irqrestore(&ring_lock, flags);
+    if (ring == NULL) {
+        serial_puts("[RING] ERROR: Ring table full\n");
+    }
+    return ring;
+}
+
+/**
+ * Append entries; producer only. Wakes the consumer if it is blocked in ring_wait()
+ * @param ring: Ring
+ * @param entries: Entries to copy in
+ * @param count: Number of entries
+ * @return: Entries published; fewer than count if the ring filled, 0 once the consumer closed
+ */
+uint32_t ring_publish(ring_t *ring, const uint32_t *entries, uint32_t count) {
+    uint32_t head = ring->head;
+    uint32_t space = ring->mask + 1 - (head - ring->tail_cache);
+    uint32_t i;
+    if (ring->consumer == 0) {
+        return 0;
+    }
+    if (space < count) {
+        ring->tail_cache = ring->tail;
+        space = ring->mask + 1 - (head - ring->tail_cache);
+        if (space < count) {
+            count = space;
+            ring->full++;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+    for (i = 0; i < count; i++) {
+        ring->slots[(head + i) & ring->mask] = entries[i];
+    }
+    __asm__ volatile ("" : : : "memory");
+    ring->head = head + count;
+    ring->published += count;
+    ring->publishes++;
+    //Pairs with the fence in ring_wait(): either it sees the new head or we see waiting
+    __sync_synchronize();
+    if (ring->waiting) {
+        uint32_t flags = spin_lock_irqsave(&ring_lock);
+        if (ring->waiting) {
+            ring->waiting = 0;
+            ring->wakeups++;
+            scheduler_wake(ring->consumer);
+        }
+        spin_unlock_irqrestore(&ring_lock, flags);
+    }
+    return count;
+}
+
+/**
+ * Take entries in publish order; consumer only
+ * @param ring: Ring
+ * @param entries: Receives the entries
+ * @param max: Room in entries
+ * @return: Entries taken, 0 if the ring is empty
+ */
+uint32_t ring_consume(ring_t *ring, uint32_t *entries, uint32_t max) {
+    uint32_t tail = ring->tail;
+    uint32_t ready = ring->head_cache - tail;
+    uint32_t i;
+    if (ready < max) {
+        ring->head_cache = ring->head;
+        ready = ring->head_cache - tail;
+    }
+    if (ready > max) {
+        ready = max;
+    }
+    if (ready == 0) {
+        return 0;
+    }
+    __asm__ volatile ("" : : : "memory");
+    for (i = 0; i < ready; i++) {
+        entries[i] = ring->slots[(tail + i) & ring->mask];
+    }
+    __asm__ volatile ("" : : : "memory");
+    ring->tail = tail + ready;
+    ring->consumed += ready;
+    ring->consumes++;
+    return ready;
+}
+
+//Entries published but not yet consumed
+uint32_t ring_count(const ring_t *ring) {
+    return ring->head - ring->tail;
+}
+
+/**
+ * Block the consumer until entries are ready; consumer only
+ * @param ring: Ring
+ * @return: RING_OK if entries are ready now, RING_BLOCKED if the consumer was
+ *          blocked (the next publish wakes it), RING_ERROR if the ring is
+ *          empty and its producer has closed
+ */
+ring_status_t ring_wait(ring_t *ring) {
+    ring_status_t status = RING_BLOCKED;
+    uint32_t flags = spin_lock_irqsave(&ring_lock);
+    if (ring->consumer == 0) {
+        spin_unlock_irqrestore(&ring_lock, flags);
+        return RING_ERROR;
+    }
+    ring->waiting = 1;
+    __sync_synchronize();
+    if (ring->head != ring->tail) {
+        status = RING_OK;
+    }
+    else if (ring->producer == 0 || !scheduler_block(ring->consumer)) {
+        status = RING_ERROR;
+    }
+    else {
+        ring->waits++;
+    }
+    if (status != RING_BLOCKED) {
+        ring->waiting = 0;
+    }
+    spin_unlock_irqrestore(&ring_lock, flags);
+    return status;
+}
+
+/* Close whichever ends pid holds; the ring is freed once both are closed. Caller holds ring_lock */
+static void ring_close_locked(ring_t *ring, uint32_t pid) {
+    if (ring->consumer == pid) {
+        ring->consumer = 0;
+        ring->waiting = 0;
+    }
+    if (ring->producer == pid) {
+        ring->producer = 0;
+        //A blocked consumer wakes to find the ring closed
+        if (ring->waiting) {
+            ring->waiting = 0;
+            scheduler_wake(ring->consumer);
+        }
+    }
+    if (ring->producer == 0 && ring->consumer == 0) {
+        memset(ring, 0, sizeof(*ring));
+    }
+}
+
+/**
+ * Close a process's end of a ring
+ * @param ring: Ring
+ * @param pid: Its producer or consumer
+ */
+void ring_close(ring_t *ring, uint32_t pid) {
+    uint32_t flags;
+    if (pid == 0) {
+        return;
+    }
+    flags = spin_lock_irqsave(&ring_lock);
+    if (ring->slots != NULL) {
+        ring_close_locked(ring, pid);
+    }
+    spin_unlock_irqrestore(&ring_lock, flags);
+}
+
+/**
+ * Close every ring end held by a terminated process
+ * @param pid: Process that exited
+ */
+void ring_process_exit(uint32_t pid) {
+    uint32_t i;
+    uint32_t flags;
+    if (pid == 0) {
+        return;
+    }
+    flags = spin_lock_irqsave(&ring_lock);
+    for (i = 0; i < RING_MAX_CHANNELS; i++) {
+        if (rings[i].slots != NULL) {
+            ring_close_locked(&rings[i], pid);
+        }
+    }
+    spin_unlock_irqrestore(&ring_lock, flags);
+}
+
+//Print every ring with its traffic counters
+void ring_print_stats(void) {
+    uint32_t i;
+    uint32_t flags = spin_lock_irqsave(&ring_lock);
+    serial_puts("\n=== Ring Channels ===\n");
+    serial_puts("Name             | Size  | Prod | Cons | Queued | Published  | Avg batch | Full | Waits | Wakeups\n");
+    for (i = 0; i < RING_MAX_CHANNELS; i++) {
+        ring_t *ring = &rings[i];
+        if (ring->slots == NULL) {
+            continue;
+        }
+        kprintf("%-16s | %5u | %4u | %4u | %6u | %10u | %9u | %4u | %5u | %7u\n",
+                ring->name, ring->mask + 1, ring->producer, ring->consumer, ring_count(ring),
+                ring->published, ring->publishes ? ring->published / ring->publishes : 0,
+                ring->full, ring->waits, ring->wakeups);
+    }
+    spin_unlock_irqrestore(&ring_lock, flags);
+    serial_puts("\n");
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+/* ring.h - Lock-free single-producer/single-consumer ring channels */
+#ifndef RING_H
+#define RING_H
+
+#include "types.h"
+
+#define RING_MAX_CHANNELS   16
+#define RING_NAME_LEN       16
+#define RING_MAX_ENTRIES    1024      /* Largest capacity */
+#define RING_CACHE_LINE     64        /* Head and tail live on separate lines of this size */
+
+//Outcome of ring_wait()
+typedef enum {
+    RING_OK = 0,                      /* Entries are ready */
+    RING_BLOCKED = 1,                 /* Consumer blocked until the producer publishes */
+    RING_ERROR = 2                    /* Invalid consumer, or the producer closed the ring */
+} ring_status_t;
+
+//A channel of 32-bit entries; indices run freely and are masked on use
+typedef struct ring {
+    //Producer's line
+    volatile uint32_t head __attribute__((aligned(RING_CACHE_LINE)));
+    uint32_t tail_cache;              /* Last tail the producer saw */
+    uint32_t published;
+    uint32_t publishes;               /* Batches */
+    uint32_t full;                    /* Batches cut short by a full ring */
+    uint32_t wakeups;
+    //Consumer's line
+    volatile uint32_t tail __attribute__((aligned(RING_CACHE_LINE)));
+    uint32_t head_cache;              /* Last head the consumer saw */
+    volatile uint32_t waiting;        /* Consumer blocked or about to block in ring_wait() */
+    uint32_t consumed;
+    uint32_t consumes;
+    uint32_t waits;
+    //Read-mostly
+    uint32_t *slots __attribute__((aligned(RING_CACHE_LINE)));
+    uint32_t mask;                    /* Capacity - 1 */
+    uint32_t producer;                /* PIDs, 0 once that end has closed */
+    uint32_t consumer;
+    char name[RING_NAME_LEN];
+} ring_t;
+
+//Function declarations
+void ring_init(void);
+ring_t* ring_create(const char *name, uint32_t capacity, uint32_t producer_pid, uint32_t consumer_pid);
+uint32_t ring_publish(ring_t *ring, const uint32_t *entries, uint32_t count);
+uint32_t ring_consume(ring_t *ring, uint32_t *entries, uint32_t max);
+uint32_t ring_count(const ring_t *ring);
+ring_status_t ring_wait(ring_t *ring);
+void ring_close(ring_t *ring, uint32_t pid);
+void ring_process_exit(uint32_t pid);
+void ring_print_stats(void);
+#endif
\ No newline at end of file
@@ -24,7 +24,7 @@ echo ""
 echo "[2] Building test kernel..."
 gcc -m32 -ffreestanding -O2 -Wall -Wextra -nostdinc -fno-builtin -fno-stack-protector -I. -c test_kernel.c -o test_kernel.o > /dev/null 2>&1
 gcc -m32 -ffreestanding -O2 -Wall -Wextra -nostdinc -fno-builtin -fno-stack-protector -I. -c test_suite.c -o test_suite.o > /dev/null 2>&1
-ld -m elf_i386 -T link.ld -o test_kernel.elf boot.o test_kernel.o serial.o string.o memory.o process.o scheduler.o test_suite.o > /dev/null 2>&1
+ld -m elf_i386 -T link.ld -o test_kernel.elf boot.o test_kernel.o serial.o kprintf.o clock.o string.o memory.o process.o scheduler.o timer.o ipc.o sync.o shm.o ring.o deferred.o initrd.o gdt.o syscall.o syscall_entry.o smp.o ap_trampoline.o spinlock.o trace.o workload.o interrupt.o isr.o debugcon.o profile.o latency.o test_suite.o > /dev/null 2>&1
 echo "✓ Test kernel built successfully"
 
 # Run tests
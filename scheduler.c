@@ -4,25 +4,270 @@
 #include "memory.h"
 #include "serial.h"
 #include "string.h"
+#include "smp.h"
+#include "spinlock.h"
+#include "trace.h"
+#include "cpu.h"
+#include "clock.h"
 static scheduler_t scheduler;
-static uint32_t current_process_id = 0;
-static uint32_t time_since_switch = 0;
+#ifdef CONFIG_SCHED_POLICY
+/* Policy fixed at build time: every dispatch on it below constant-folds */
+#define SCHED_ALGORITHM ((scheduling_algorithm_t)CONFIG_SCHED_POLICY)
+#else
+#define SCHED_ALGORITHM (scheduler.algorithm)
+#endif
+static cpu_runqueue_t runqueues[SMP_MAX_CPUS];
+/* Serializes scheduler state between CPUs and against the timer tick */
+static spinlock_t scheduler_lock = SPINLOCK_INIT("scheduler");
+/* Every timed scheduler event; driven by scheduler_update_time() under scheduler_lock */
+static timer_wheel_t scheduler_timers;
+static timer_event_t boost_timer;
+static timer_event_t load_timer;
+static void scheduler_start_slice(uint32_t cpu, uint32_t start);
+static void scheduler_start_waiting(process_control_block_t *pcb);
+static void scheduler_quantum_timeout(timer_event_t *timer);
+static void scheduler_boost_timeout(timer_event_t *timer);
+static void scheduler_load_timeout(timer_event_t *timer);
+
+/* EDF state: deadline-ordered min-heap of active jobs plus the admitted task set */
+static process_control_block_t *edf_heap[EDF_MAX_TASKS];
+static uint32_t edf_heap_size = 0;
+static process_control_block_t *edf_tasks[EDF_MAX_TASKS];
+static uint32_t edf_task_count = 0;
+static uint32_t edf_utilization = 0;
+static uint32_t edf_total_misses = 0;
+
+/* Earlier absolute deadline first; wrap-safe, ties broken by PID */
+static int edf_before(process_control_block_t *a, process_control_block_t *b) {
+    int32_t diff = (int32_t)(a->edf.abs_deadline - b->edf.abs_deadline);
+    return diff < 0 || (diff == 0 && a->process_id < b->process_id);
+}
+
+static void edf_heap_swap(uint32_t i, uint32_t j) {
+    process_control_block_t *tmp = edf_heap[i];
+    edf_heap[i] = edf_heap[j];
+    edf_heap[j] = tmp;
+    edf_heap[i]->edf.heap_index = i;
+    edf_heap[j]->edf.heap_index = j;
+}
+
+static void edf_sift_up(uint32_t i) {
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!edf_before(edf_heap[i], edf_heap[parent])) {
+            break;
+        }
+        edf_heap_swap(i, parent);
+        i = parent;
+    }
+}
+
+static void edf_sift_down(uint32_t i) {
+    while (1) {
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        uint32_t smallest = i;
+        if (left < edf_heap_size && edf_before(edf_heap[left], edf_heap[smallest])) {
+            smallest = left;
+        }
+        if (right < edf_heap_size && edf_before(edf_heap[right], edf_heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        edf_heap_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+static void edf_heap_push(process_control_block_t *pcb) {
+    pcb->edf.heap_index = edf_heap_size;
+    edf_heap[edf_heap_size++] = pcb;
+    edf_sift_up(pcb->edf.heap_index);
+}
+
+static void edf_heap_remove(process_control_block_t *pcb) {
+    uint32_t i = pcb->edf.heap_index;
+    uint32_t last = --edf_heap_size;
+    if (i != last) {
+        edf_heap[i] = edf_heap[last];
+        edf_heap[i]->edf.heap_index = i;
+        edf_sift_up(i);
+        edf_sift_down(edf_heap[i]->edf.heap_index);
+    }
+}
+
+/* Density runtime/deadline, rounded up so admission stays conservative */
+static uint32_t edf_task_utilization(uint32_t runtime, uint32_t deadline) {
+    return (runtime * EDF_UTIL_SCALE + deadline - 1) / deadline;
+}
+
+/* Release a new job for every admitted task whose release time has come */
+static void edf_release_jobs(void) {
+    uint32_t i;
+    for (i = 0; i < edf_task_count; i++) {
+        process_control_block_t *pcb = edf_tasks[i];
+        if (pcb->state == TERMINATED || pcb->edf.remaining != 0 ||
+            (int32_t)(scheduler.current_time - pcb->edf.next_release) < 0) {
+            continue;
+        }
+        pcb->edf.remaining = pcb->edf.runtime;
+        pcb->edf.abs_deadline = pcb->edf.next_release + pcb->edf.deadline;
+        /* Skip releases that were missed entirely rather than bursting */
+        while ((int32_t)(scheduler.current_time - pcb->edf.next_release) >= 0) {
+            pcb->edf.next_release += pcb->edf.period;
+        }
+        edf_heap_push(pcb);
+    }
+}
+
+/**
+ * Advance EDF bookkeeping by one tick (EDF tasks are pinned to CPU 0)
+ * Charges the running job, drops jobs past their deadline and releases new ones
+ * @return: 1 if the running process should be preempted, 0 otherwise
+ */
+static uint32_t edf_tick(void) {
+    cpu_runqueue_t *rq = &runqueues[0];
+    process_control_block_t *current = process_get_pcb(rq->current_process_id);
+    uint32_t resched = 0;
+    if (edf_task_count == 0) {
+        return 0;
+    }
+    /* Charge the running job; a finished job is throttled until its next release */
+    if (current != NULL && current->sched_class == SCHED_CLASS_EDF &&
+        current->state == CURRENT && current->edf.remaining > 0) {
+        if (--current->edf.remaining == 0) {
+            edf_heap_remove(current);
+            current->state = READY;
+            resched = 1;
+        }
+    }
+    /* A job still holding budget at its deadline has missed it; drop it */
+    while (edf_heap_size > 0 &&
+           (int32_t)(scheduler.current_time - edf_heap[0]->edf.abs_deadline) >= 0) {
+        process_control_block_t *late = edf_heap[0];
+        late->edf.deadline_misses++;
+        edf_total_misses++;
+        edf_heap_remove(late);
+        late->edf.remaining = 0;
+        if (late->state == CURRENT) {
+            late->state = READY;
+            resched = 1;
+        }
+    }
+    edf_release_jobs();
+    if (edf_heap_size > 0 && edf_heap[0]->process_id != rq->current_process_id) {
+        resched = 1;
+    }
+    return resched;
+}
+
+/* Caller holds the scheduler lock */
+static void edf_admit(process_control_block_t *pcb, uint32_t runtime, uint32_t period,
+                      uint32_t deadline, uint32_t utilization) {
+    /* EDF is dispatched from the boot CPU's run queue */
+    if (pcb->cpu != 0) {
+        runqueues[pcb->cpu].nr_assigned--;
+        runqueues[0].nr_assigned++;
+        pcb->cpu = 0;
+    }
+    pcb->sched_class = SCHED_CLASS_EDF;
+    pcb->edf.runtime = runtime;
+    pcb->edf.period = period;
+    pcb->edf.deadline = deadline;
+    pcb->edf.next_release = scheduler.current_time;
+    pcb->edf.remaining = 0;
+    pcb->edf.deadline_misses = 0;
+    edf_tasks[edf_task_count++] = pcb;
+    edf_utilization += utilization;
+    edf_release_jobs();
+}
+
+/* Drop a process from the EDF class; caller holds the scheduler lock */
+static void edf_remove(process_control_block_t *pcb) {
+    uint32_t i;
+    if (pcb->sched_class != SCHED_CLASS_EDF) {
+        return;
+    }
+    if (pcb->edf.remaining > 0) {
+        edf_heap_remove(pcb);
+        pcb->edf.remaining = 0;
+    }
+    for (i = 0; i < edf_task_count; i++) {
+        if (edf_tasks[i] == pcb) {
+            edf_tasks[i] = edf_tasks[--edf_task_count];
+            break;
+        }
+    }
+    edf_utilization -= edf_task_utilization(pcb->edf.runtime, pcb->edf.deadline);
+    pcb->sched_class = SCHED_CLASS_NORMAL;
+}
+
 /**
  * Initialize the scheduler
- * @param algorithm: Scheduling algorithm (FCFS or RR)
- * @param time_quantum: Time quantum for round robin (ms)
+ * @param algorithm: Scheduling algorithm (FCFS, RR or MLFQ)
+ * @param time_quantum: Time quantum for round robin, base quantum for MLFQ (ms)
  */
 void scheduler_init(scheduling_algorithm_t algorithm, uint32_t time_quantum) {
+    uint32_t i;
+    uint32_t flags;
+#ifdef CONFIG_SCHED_POLICY
+    if (algorithm != SCHED_ALGORITHM) {
+        serial_puts("[SCHEDULER] WARNING: policy fixed at build time, ignoring requested algorithm\n");
+        algorithm = SCHED_ALGORITHM;
+    }
+#endif
+    flags = spin_lock_irqsave(&scheduler_lock);
+    /* The clock restarts at 0, so pending timers go; sleepers are woken early */
+    for (i = 1; i < process_slot_count(); i++) {
+        process_control_block_t *pcb = process_slot(i);
+        if (pcb->state == BLOCKED && timer_pending(&pcb->sleep_timer)) {
+            pcb->state = READY;
+        }
+    }
+    timer_wheel_reset(&scheduler_timers, 0);
     scheduler.algorithm = algorithm;
     scheduler.time_quantum = time_quantum;
     scheduler.current_time = 0;
     scheduler.process_count = 1;  /* Null process */
-    current_process_id = 0;
-    time_since_switch = 0;
+    scheduler.load_avg[0] = 0;
+    scheduler.load_avg[1] = 0;
+    scheduler.load_avg[2] = 0;
+    memset(runqueues, 0, sizeof(runqueues));
+    runqueues[0].nr_assigned = 1;  /* Null process */
+    edf_heap_size = 0;
+    edf_task_count = 0;
+    edf_utilization = 0;
+    edf_total_misses = 0;
+    timer_setup(&boost_timer, scheduler_boost_timeout);
+    timer_add(&scheduler_timers, &boost_timer, MLFQ_BOOST_INTERVAL);
+    timer_setup(&load_timer, scheduler_load_timeout);
+    timer_add(&scheduler_timers, &load_timer, LOAD_SAMPLE_TICKS);
+    for (i = 0; i < SMP_MAX_CPUS; i++) {
+        timer_setup(&runqueues[i].quantum_timer, scheduler_quantum_timeout);
+        if (i < smp_cpu_count()) {
+            scheduler_start_slice(i, scheduler.current_time);
+        }
+    }
+    for (i = 1; i < process_slot_count(); i++) {
+        process_control_block_t *pcb = process_slot(i);
+        if (pcb->state == READY) {
+            scheduler_start_waiting(pcb);
+        }
+    }
+    spin_unlock_irqrestore(&scheduler_lock, flags);
     serial_puts("[SCHEDULER] Scheduler initialized with ");
     if (algorithm == FCFS) {
         serial_puts("FCFS algorithm\n");
     } 
+    else if (algorithm == MLFQ) {
+        serial_puts("MLFQ algorithm (");
+        serial_put_dec(MLFQ_LEVELS);
+        serial_puts(" levels, base quantum ");
+        serial_put_dec(time_quantum);
+        serial_puts("ms)\n");
+    }
     else {
         serial_puts("Round Robin algorithm (");
         serial_put_dec(time_quantum);
@@ -30,55 +275,290 @@ void scheduler_init(scheduling_algorithm_t algorithm, uint32_t time_quantum) {
     }
 }
 
+/* One exponential-decay step: load = load * e + active * (1 - e) */
+static uint32_t calc_load(uint32_t load, uint32_t exp, uint32_t active) {
+    load *= exp;
+    load += active * (LOAD_FIXED_1 - exp);
+    load += 1 << (LOAD_FSHIFT - 1);
+    return load >> LOAD_FSHIFT;
+}
+
+/* Time slice for a process at the given MLFQ level */
+static uint32_t mlfq_quantum(uint32_t level) {
+    return scheduler.time_quantum << level;
+}
+
 /**
- * Get the next process to run
- * Uses the configured scheduling algorithm
- * @return: Process ID of next process to run
+ * Arm a CPU's quantum timer for the slice that began at slice_start
+ * The slice length follows the policy and, for MLFQ, the running process's level;
+ * a slice that is already over is flagged expired straight away.
+ * @param cpu: CPU whose slice to time
  */
-uint32_t scheduler_get_next_process(void) {
+static void scheduler_arm_quantum(uint32_t cpu) {
+    cpu_runqueue_t *rq = &runqueues[cpu];
+    process_control_block_t *current;
+    uint32_t expires;
+    if (SCHED_ALGORITHM == FCFS) {
+        timer_cancel(&scheduler_timers, &rq->quantum_timer);
+        rq->quantum_expired = 0;
+        return;
+    }
+    expires = rq->slice_start + scheduler.time_quantum;
+    if (SCHED_ALGORITHM == MLFQ) {
+        current = process_get_pcb(rq->current_process_id);
+        expires = rq->slice_start + mlfq_quantum(current != NULL ? current->mlfq_level : 0);
+    }
+    if ((int32_t)(expires - scheduler.current_time) <= 0) {
+        timer_cancel(&scheduler_timers, &rq->quantum_timer);
+        rq->quantum_expired = 1;
+    }
+    else {
+        timer_add(&scheduler_timers, &rq->quantum_timer, expires);
+    }
+}
+
+/* Give the process now running on a CPU a fresh time slice */
+static void scheduler_start_slice(uint32_t cpu, uint32_t start) {
+    runqueues[cpu].slice_start = start;
+    runqueues[cpu].quantum_expired = 0;
+    scheduler_arm_quantum(cpu);
+}
+
+/* Whether the process running on a CPU has used up its time slice */
+static uint32_t scheduler_quantum_expired(uint32_t cpu) {
+    return runqueues[cpu].quantum_expired;
+}
+
+static void scheduler_quantum_timeout(timer_event_t *timer) {
+    container_of(timer, cpu_runqueue_t, quantum_timer)->quantum_expired = 1;
+}
+
+/**
+ * A process became READY: start its FIFO position and wait clock
+ * Its aging timer fires once its total wait reaches AGING_THRESHOLD.
+ * @param pcb: Process, leaving CURRENT or BLOCKED or newly created
+ */
+static void scheduler_start_waiting(process_control_block_t *pcb) {
+    uint32_t waited = pcb->wait_time < AGING_THRESHOLD ? pcb->wait_time : AGING_THRESHOLD;
+    pcb->state = READY;
+    pcb->ready_since = scheduler.current_time;
+    pcb->wait_since = scheduler.current_time;
+    if (pcb->process_id != 0) {
+        timer_add(&scheduler_timers, &pcb->aging_timer, scheduler.current_time + AGING_THRESHOLD - waited);
+    }
+}
+
+/* A process is leaving READY: bank the time it waited and stop its aging timer */
+static void scheduler_stop_waiting(process_control_block_t *pcb) {
+    if (timer_cancel(&scheduler_timers, &pcb->aging_timer)) {
+        pcb->wait_time += scheduler.current_time - pcb->wait_since;
+    }
+}
+
+/*
+ * Waited AGING_THRESHOLD ticks: raise priority one level and start counting again
+ * A process running on an inherited priority keeps it, but its base priority
+ * still moves up so the promotion survives the end of the inheritance.
+ */
+static void scheduler_aging_timeout(timer_event_t *timer) {
+    process_control_block_t *pcb = container_of(timer, process_control_block_t, aging_timer);
+    if (pcb->state != READY) {
+        return;
+    }
+    if (pcb->base_priority > 0) {
+        pcb->base_priority--;
+    }
+    if (pcb->priority > pcb->base_priority) {
+        pcb->priority = pcb->base_priority;
+    }
+    pcb->wait_time = 0;
+    pcb->wait_since = scheduler.current_time;
+    timer_add(&scheduler_timers, timer, scheduler.current_time + AGING_THRESHOLD);
+}
+
+/**
+ * MLFQ selection: lowest level first, FIFO within a level
+ * A process that used its whole slice is demoted; otherwise the running
+ * process keeps the CPU unless a higher level has work.
+ * @param cpu: CPU making the decision
+ * @param next_pid: Receives the chosen process
+ * @param ready: Receives the number of READY processes on this CPU
+ * @return: 1 if a process was chosen, 0 if the queue is empty
+ */
+static uint32_t mlfq_select(uint32_t cpu, uint32_t *next_pid, uint32_t *ready) {
+    cpu_runqueue_t *rq = &runqueues[cpu];
+    process_control_block_t *current = process_get_pcb(rq->current_process_id);
+    process_control_block_t *best = NULL;
+    uint32_t i;
+    if (rq->current_process_id == 0 || (current != NULL && current->state != CURRENT)) {
+        current = NULL;
+    }
+    /* Used the whole slice: treat as CPU-bound and demote */
+    if (current != NULL && rq->quantum_expired) {
+        if (current->mlfq_level < MLFQ_LEVELS - 1) {
+            current->mlfq_level++;
+        }
+        scheduler_start_waiting(current);
+        current = NULL;
+    }
+    for (i = 1; i < process_slot_count(); i++) {
+        process_control_block_t *pcb = process_slot(i);
+        if (pcb->state != READY || pcb->sched_class != SCHED_CLASS_NORMAL || pcb->cpu != cpu) {
+            continue;
+        }
+        (*ready)++;
+        if (best == NULL || pcb->mlfq_level < best->mlfq_level ||
+            (pcb->mlfq_level == best->mlfq_level &&
+             (int32_t)(pcb->ready_since - best->ready_since) < 0)) {
+            best = pcb;
+        }
+    }
+    if (current != NULL && (best == NULL || best->mlfq_level >= current->mlfq_level)) {
+        *next_pid = current->process_id;
+        return 1;
+    }
+    if (best == NULL) {
+        return 0;
+    }
+    *next_pid = best->process_id;
+    return 1;
+}
+
+/* Periodic boost: move every process back to the top level to prevent starvation */
+static void mlfq_boost(void) {
+    uint32_t i;
+    for (i = 1; i < process_slot_count(); i++) {
+        process_slot(i)->mlfq_level = 0;
+    }
+}
+
+static void scheduler_boost_timeout(timer_event_t *timer) {
+    uint32_t i;
+    timer_add(&scheduler_timers, timer, timer->expires + MLFQ_BOOST_INTERVAL);
+    if (SCHED_ALGORITHM != MLFQ) {
+        return;
+    }
+    mlfq_boost();
+    /* Running processes are back on level 0 too, so their slices shrink */
+    for (i = 0; i < smp_cpu_count(); i++) {
+        scheduler_arm_quantum(i);
+    }
+}
+
+/* Every LOAD_SAMPLE_TICKS: fold the number of runnable processes into the load averages */
+static void scheduler_load_timeout(timer_event_t *timer) {
+    uint32_t i;
+    uint32_t active = 0;
+    timer_add(&scheduler_timers, timer, timer->expires + LOAD_SAMPLE_TICKS);
+    for (i = 1; i < process_slot_count(); i++) {
+        process_control_block_t *pcb = process_slot(i);
+        if (pcb->state == READY || pcb->state == CURRENT) {
+            active++;
+        }
+    }
+    active <<= LOAD_FSHIFT;
+    scheduler.load_avg[0] = calc_load(scheduler.load_avg[0], LOAD_EXP_1, active);
+    scheduler.load_avg[1] = calc_load(scheduler.load_avg[1], LOAD_EXP_5, active);
+    scheduler.load_avg[2] = calc_load(scheduler.load_avg[2], LOAD_EXP_15, active);
+}
+
+/**
+ * Pull the longest-waiting READY process from the CPU with the most waiters
+ * @param cpu: Idle CPU doing the stealing
+ * @return: Process ID migrated to cpu, or 0 if nothing could be stolen
+ */
+static uint32_t scheduler_steal(uint32_t cpu) {
+    uint32_t waiting[SMP_MAX_CPUS];
+    uint32_t i;
+    uint32_t victim = cpu;
+    process_control_block_t *stolen = NULL;
+    memset(waiting, 0, sizeof(waiting));
+    for (i = 1; i < process_slot_count(); i++) {
+        process_control_block_t *pcb = process_slot(i);
+        if (pcb->state == READY && pcb->sched_class == SCHED_CLASS_NORMAL && pcb->cpu != cpu) {
+            waiting[pcb->cpu]++;
+        }
+    }
+    for (i = 0; i < SMP_MAX_CPUS; i++) {
+        if (waiting[i] > 0 && (victim == cpu || waiting[i] > waiting[victim])) {
+            victim = i;
+        }
+    }
+    if (victim == cpu) {
+        return 0;
+    }
+    for (i = 1; i < process_slot_count(); i++) {
+        process_control_block_t *pcb = process_slot(i);
+        if (pcb->state == READY && pcb->sched_class == SCHED_CLASS_NORMAL &&
+            pcb->cpu == victim && (stolen == NULL || scheduler_wait_time(pcb) > scheduler_wait_time(stolen))) {
+            stolen = pcb;
+        }
+    }
+    stolen->cpu = cpu;
+    runqueues[victim].nr_assigned--;
+    runqueues[cpu].nr_assigned++;
+    runqueues[cpu].steals++;
+    return stolen->process_id;
+}
+
+/*
+ * FCFS/RR selection key; the smallest key wins
+ * FCFS: priority. RR: first in, first out by the time it became READY.
+ * Ties fall back to priority, then table slot (creation order).
+ */
+static inline uint64_t scheduler_key(process_control_block_t *pcb, uint32_t slot) {
+    uint64_t key = ((uint64_t)(pcb->priority & 0xFFFF) << 16) | slot;
+    if (SCHED_ALGORITHM == RR) {
+        key |= (uint64_t)pcb->ready_since << 32;
+    }
+    return key;
+}
+
+/* Select from the calling CPU's run queue; caller holds the scheduler lock */
+static uint32_t scheduler_pick_next(uint32_t cpu) {
+    cpu_runqueue_t *rq = &runqueues[cpu];
     uint32_t i;
     uint32_t next_pid = 0;
-    uint32_t highest_priority = 256;
-    uint32_t lowest_wait_time = 0xFFFFFFFF;
     uint32_t found = 0;
+    uint32_t ready = 0;
     
-    if (scheduler.algorithm == FCFS) {
-        /* First Come First Served - pick first READY process with highest priority */
-        for (i = 1; i < 256; i++) {
-            process_control_block_t *pcb = process_get_pcb(i);
-            
-            if (pcb != NULL && pcb->state == READY) {
-                if (!found || pcb->priority < highest_priority || 
-                    (pcb->priority == highest_priority && i < next_pid)) {
-                    highest_priority = pcb->priority;
-                    next_pid = i;
-                    found = 1;
-                }
-            }
-        }
+    rq->last_pick_stolen = 0;
+    /* Real-time jobs take precedence: earliest deadline wins */
+    if (cpu == 0 && edf_heap_size > 0) {
+        rq->nr_ready = edf_heap_size;
+        return edf_heap[0]->process_id;
+    }
+    if (SCHED_ALGORITHM == MLFQ) {
+        found = mlfq_select(cpu, &next_pid, &ready);
     } else {
-        /* Round Robin with Aging */
-        /* First, check if time quantum expired for current process */
-        if (time_since_switch >= scheduler.time_quantum) {
-            process_control_block_t *current = process_get_pcb(current_process_id);
+        uint32_t count = process_slot_count();
+        uint64_t best_key = ~0ULL;
+        /* Round Robin: if the time quantum expired the current process competes again */
+        if (SCHED_ALGORITHM == RR && rq->quantum_expired) {
+            process_control_block_t *current = process_get_pcb(rq->current_process_id);
             if (current != NULL && current->state == CURRENT) {
-                current->state = READY;
+                scheduler_start_waiting(current);
             }
         }
-        /* Find READY process with lowest wait time (aging) */
-        for (i = 1; i < 256; i++) {
-            process_control_block_t *pcb = process_get_pcb(i);
-            if (pcb != NULL && pcb->state == READY) {
-                if (!found || pcb->wait_time < lowest_wait_time || 
-                    (pcb->wait_time == lowest_wait_time && pcb->priority < highest_priority) ||
-                    (pcb->wait_time == lowest_wait_time && pcb->priority == highest_priority && i < next_pid)) {
-                    lowest_wait_time = pcb->wait_time;
-                    highest_priority = pcb->priority;
-                    next_pid = i;
-                    found = 1;
+        for (i = 1; i < count; i++) {
+            process_control_block_t *pcb = process_slot(i);
+            if (pcb->state == READY && pcb->sched_class == SCHED_CLASS_NORMAL && pcb->cpu == cpu) {
+                uint64_t key = scheduler_key(pcb, i);
+                ready++;
+                if (key < best_key) {
+                    best_key = key;
+                    next_pid = pcb->process_id;
                 }
             }
         }
+        found = best_key != ~0ULL;
+    }
+    rq->nr_ready = ready;
+    /* Own queue empty: try to take work from a busier CPU */
+    if (!found && smp_cpu_count() > 1) {
+        next_pid = scheduler_steal(cpu);
+        found = next_pid != 0;
+        rq->last_pick_stolen = found;
     }
     /* If no READY process, return idle process (PID 0) */
     if (!found) {
@@ -86,84 +566,561 @@ uint32_t scheduler_get_next_process(void) {
     }
     return next_pid;
 }
-/**
- * Perform a context switch
- * @param from_pid: Current process ID
- * @param to_pid: Next process ID
- */
-void scheduler_context_switch(uint32_t from_pid, uint32_t to_pid) {
+
+/* Switch the given CPU from one process to another; caller holds the scheduler lock */
+/* The incoming process's slice is taken to have begun at slice_start */
+static void scheduler_switch(uint32_t cpu, uint32_t from_pid, uint32_t to_pid, trace_reason_t reason,
+                             uint32_t slice_start) {
     process_control_block_t *from = process_get_pcb(from_pid);
     process_control_block_t *to = process_get_pcb(to_pid);
+    uint64_t now = clock_cycles();
+    if (runqueues[cpu].last_pick_stolen) {
+        reason = TRACE_REASON_STEAL;
+    }
+    trace_switch(cpu, from_pid, to_pid, reason, runqueues[cpu].nr_ready);
+    if (from != NULL) {
+        from->cpu_cycles += now - from->run_start;
+        if (reason == TRACE_REASON_YIELD || reason == TRACE_REASON_BLOCK || reason == TRACE_REASON_EXIT ||
+            reason == TRACE_REASON_HANDOFF) {
+            from->voluntary_switches++;
+        }
+        else {
+            from->involuntary_switches++;
+        }
+    }
+    if (to != NULL) {
+        to->run_start = now;
+        to->switches_in++;
+    }
     if (from != NULL && from->state == CURRENT) {
-        from->state = READY;
+        scheduler_start_waiting(from);
     }
     if (to != NULL) {
+        scheduler_stop_waiting(to);
         to->state = CURRENT;
-        current_process_id = to_pid;
-        time_since_switch = 0;
+        runqueues[cpu].current_process_id = to_pid;
+        scheduler_start_slice(cpu, slice_start);
     }
 }
-//Schedule and perform context switch
-void scheduler_schedule(void) {
-    uint32_t next_pid = scheduler_get_next_process();
-    if (next_pid != current_process_id) {
-        scheduler_context_switch(current_process_id, next_pid);
+
+static void scheduler_schedule_locked(uint32_t cpu, trace_reason_t reason) {
+    uint32_t next_pid = scheduler_pick_next(cpu);
+    runqueues[cpu].need_resched = 0;
+    if (next_pid != runqueues[cpu].current_process_id) {
+        scheduler_switch(cpu, runqueues[cpu].current_process_id, next_pid, reason, scheduler.current_time);
     }
+    else {
+        /* Re-picked after giving up its slice: start a fresh one */
+        process_control_block_t *pcb = process_get_pcb(next_pid);
+        if (pcb != NULL && pcb->state == READY) {
+            scheduler_stop_waiting(pcb);
+            pcb->state = CURRENT;
+            scheduler_start_slice(cpu, scheduler.current_time);
+        }
+    }
+}
+
+/* A process stopped being runnable: if it is running, get its CPU to pick another */
+static void scheduler_kick(process_control_block_t *pcb, trace_reason_t reason) {
+    if (runqueues[pcb->cpu].current_process_id != pcb->process_id) {
+        return;
+    }
+    if (pcb->cpu == smp_cpu_id()) {
+        scheduler_schedule_locked(pcb->cpu, reason);
+    }
+    else {
+        runqueues[pcb->cpu].need_resched = 1;
+    }
+}
+
+/**
+ * Get the next process to run on the calling CPU
+ * Uses the configured scheduling algorithm, stealing work when the local queue is empty
+ * @return: Process ID of next process to run
+ */
+uint32_t scheduler_get_next_process(void) {
+    uint32_t next_pid;
+    uint32_t flags = spin_lock_irqsave(&scheduler_lock);
+    next_pid = scheduler_pick_next(smp_cpu_id());
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+    return next_pid;
+}
+/**
+ * Perform a context switch on the calling CPU
+ * @param from_pid: Current process ID
+ * @param to_pid: Next process ID
+ */
+void scheduler_context_switch(uint32_t from_pid, uint32_t to_pid) {
+    uint32_t flags = spin_lock_irqsave(&scheduler_lock);
+    uint32_t cpu = smp_cpu_id();
+    runqueues[cpu].last_pick_stolen = 0;
+    scheduler_switch(cpu, from_pid, to_pid, TRACE_REASON_DIRECT, scheduler.current_time);
+    spin_unlock_irqrestore(&scheduler_lock, flags);
 }
- //Update scheduler time (called periodically)
+//Schedule and perform context switch on the calling CPU
+void scheduler_schedule(void) {
+    uint32_t flags = spin_lock_irqsave(&scheduler_lock);
+    scheduler_schedule_locked(smp_cpu_id(), TRACE_REASON_SCHEDULE);
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+}
+ //Update scheduler time (called periodically by the boot CPU)
 void scheduler_update_time(void) {
     uint32_t i;
+    uint32_t cpu = smp_cpu_id();
+    uint32_t cpu_count = smp_cpu_count();
+    uint32_t edf_resched;
+    uint32_t flags = spin_lock_irqsave(&scheduler_lock);
     scheduler.current_time++;
-    time_since_switch++;
-    //Update wait times for aging
-    for (i = 0; i < 256; i++) {
-        process_control_block_t *pcb = process_get_pcb(i);
-        if (pcb != NULL && pcb->state == READY) {
-            pcb->wait_time++;
+    edf_resched = edf_tick();
+    //Sleeps, slice ends, aging, MLFQ boosts and load sampling: only what is due this tick
+    timer_advance(&scheduler_timers, scheduler.current_time);
+    //Ask other CPUs to reschedule on quantum expiry, and idle ones to look for work
+    for (i = 0; i < cpu_count; i++) {
+        if (i != cpu && (runqueues[i].current_process_id == 0 || scheduler_quantum_expired(i))) {
+            runqueues[i].need_resched = 1;
         }
     }
     //Trigger scheduling decision if time quantum expired */
-    if (scheduler.algorithm == RR && time_since_switch >= scheduler.time_quantum) {
-        scheduler_schedule();
+    if (cpu == 0 && edf_resched) {
+        scheduler_schedule_locked(cpu, TRACE_REASON_EDF);
+    }
+    else if (scheduler_quantum_expired(cpu)) {
+        scheduler_schedule_locked(cpu, TRACE_REASON_QUANTUM);
     }
+    spin_unlock_irqrestore(&scheduler_lock, flags);
 }
 
-//Apply aging to waiting processes
-//Increases priority of processes waiting too long
-void scheduler_apply_aging(void) {
-    uint32_t i;
-    const uint32_t AGING_THRESHOLD = 1000;  /* Milliseconds */
-    for (i = 0; i < 256; i++) {
-        process_control_block_t *pcb = process_get_pcb(i);
-        
-        if (pcb != NULL && pcb->state == READY && pcb->wait_time > AGING_THRESHOLD) {
-            /* Increase priority (decrease priority value) */
-            if (pcb->priority > 0) {
-                pcb->priority--;
-            }
-            pcb->wait_time = 0;  /* Reset wait time */
+/* Block a process, optionally waking it again after a number of ticks */
+static uint32_t scheduler_suspend(uint32_t process_id, uint32_t timed, uint32_t ticks) {
+    process_control_block_t *pcb = process_get_pcb(process_id);
+    uint32_t blocked = 0;
+    uint32_t flags;
+    if (pcb == NULL || process_id == 0) {
+        serial_puts("[SCHEDULER] ERROR: Cannot block invalid process\n");
+        return 0;
+    }
+    if (pcb->sched_class != SCHED_CLASS_NORMAL) {
+        serial_puts("[SCHEDULER] ERROR: EDF processes cannot block\n");
+        return 0;
+    }
+    flags = spin_lock_irqsave(&scheduler_lock);
+    if (pcb->state == READY || pcb->state == CURRENT) {
+        scheduler_stop_waiting(pcb);
+        pcb->state = BLOCKED;
+        if (timed) {
+            timer_add(&scheduler_timers, &pcb->sleep_timer, scheduler.current_time + ticks);
+        }
+        scheduler_kick(pcb, TRACE_REASON_BLOCK);
+        blocked = 1;
+    }
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+    return blocked;
+}
+
+/**
+ * Block a process until scheduler_wake()
+ * Blocked processes are skipped by every policy; a running one gives up its CPU.
+ * @param process_id: ID of process
+ * @return: 1 if blocked, 0 if the process cannot block
+ */
+uint32_t scheduler_block(uint32_t process_id) {
+    return scheduler_suspend(process_id, 0, 0);
+}
+
+/**
+ * Block a process for a number of ticks
+ * It is woken by the tick that ends the sleep, or earlier by scheduler_wake().
+ * @param process_id: ID of process
+ * @param ticks: Ticks to sleep; 0 wakes it on the next tick
+ * @return: 1 if asleep, 0 if the process cannot block
+ */
+uint32_t scheduler_sleep(uint32_t process_id, uint32_t ticks) {
+    return scheduler_suspend(process_id, 1, ticks);
+}
+
+/* Caller holds the scheduler lock */
+static void scheduler_wake_locked(process_control_block_t *pcb) {
+    if (pcb->state != BLOCKED) {
+        return;
+    }
+    timer_cancel(&scheduler_timers, &pcb->sleep_timer);
+    scheduler_start_waiting(pcb);
+    if (runqueues[pcb->cpu].current_process_id == 0) {
+        runqueues[pcb->cpu].need_resched = 1;
+    }
+}
+
+static void scheduler_sleep_timeout(timer_event_t *timer) {
+    scheduler_wake_locked(container_of(timer, process_control_block_t, sleep_timer));
+}
+
+/**
+ * Make a blocked process READY again
+ * Its MLFQ level is kept, so processes that block before their slice ends stay interactive.
+ * @param process_id: ID of process
+ */
+void scheduler_wake(uint32_t process_id) {
+    process_control_block_t *pcb = process_get_pcb(process_id);
+    uint32_t flags;
+    if (pcb == NULL) {
+        return;
+    }
+    flags = spin_lock_irqsave(&scheduler_lock);
+    scheduler_wake_locked(pcb);
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+}
+
+/**
+ * Give the calling CPU straight from one process to another (IPC fast path)
+ * The run queue is not consulted: the target runs on the rest of the donor's
+ * time slice, and the donor becomes READY, or BLOCKED if it now waits on the
+ * target. If the donor is not running on this CPU, or either side is in the
+ * EDF class, the target is only made READY (and the donor blocked as asked).
+ * @param from_pid: Donor; must be able to block when block is set
+ * @param to_pid: Process to run, normally BLOCKED
+ * @param block: Nonzero to block the donor
+ * @return: 1 if the CPU was handed over, 0 if the slow path was taken
+ */
+uint32_t scheduler_handoff(uint32_t from_pid, uint32_t to_pid, uint32_t block) {
+    process_control_block_t *from = process_get_pcb(from_pid);
+    process_control_block_t *to = process_get_pcb(to_pid);
+    uint32_t cpu = smp_cpu_id();
+    cpu_runqueue_t *rq = &runqueues[cpu];
+    uint32_t direct = 0;
+    uint32_t flags;
+    if (from == NULL || to == NULL || from_pid == 0 || to_pid == 0 || from == to) {
+        return 0;
+    }
+    flags = spin_lock_irqsave(&scheduler_lock);
+    if (from->state == CURRENT && rq->current_process_id == from_pid &&
+        (to->state == BLOCKED || to->state == READY) &&
+        from->sched_class == SCHED_CLASS_NORMAL && to->sched_class == SCHED_CLASS_NORMAL) {
+        timer_cancel(&scheduler_timers, &to->sleep_timer);
+        if (to->cpu != cpu) {
+            runqueues[to->cpu].nr_assigned--;
+            rq->nr_assigned++;
+            to->cpu = cpu;
+        }
+        if (block) {
+            from->state = BLOCKED;
+        }
+        rq->last_pick_stolen = 0;
+        /* Slice donation: the target finishes the donor's slice rather than starting its own */
+        scheduler_switch(cpu, from_pid, to_pid, TRACE_REASON_HANDOFF, rq->slice_start);
+        direct = 1;
+    }
+    else {
+        /* Wake first so a donor that blocks here can pick the target next */
+        scheduler_wake_locked(to);
+        if (block && from->sched_class == SCHED_CLASS_NORMAL &&
+            (from->state == READY || from->state == CURRENT)) {
+            scheduler_stop_waiting(from);
+            from->state = BLOCKED;
+            scheduler_kick(from, TRACE_REASON_BLOCK);
+        }
+    }
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+    return direct;
+}
+
+/**
+ * Voluntarily give up the CPU
+ * Under MLFQ a process that yields before its slice ends is treated as
+ * interactive and promoted one level.
+ */
+void scheduler_yield(void) {
+    uint32_t flags = spin_lock_irqsave(&scheduler_lock);
+    uint32_t cpu = smp_cpu_id();
+    process_control_block_t *current = process_get_pcb(runqueues[cpu].current_process_id);
+    if (current != NULL && current->process_id != 0 && current->state == CURRENT) {
+        if (SCHED_ALGORITHM == MLFQ && current->mlfq_level > 0) {
+            current->mlfq_level--;
         }
+        scheduler_start_waiting(current);
     }
+    scheduler_schedule_locked(cpu, TRACE_REASON_YIELD);
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+}
+
+//Apply aging to waiting processes
+//Promotions come from each READY process's aging timer; this runs any that are due
+void scheduler_apply_aging(void) {
+    uint32_t flags = spin_lock_irqsave(&scheduler_lock);
+    timer_advance(&scheduler_timers, scheduler.current_time);
+    spin_unlock_irqrestore(&scheduler_lock, flags);
 }
 
 //Print scheduler status
 void scheduler_print_status(void) {
     serial_puts("\n=== Scheduler Status ===\n");
     serial_puts("Algorithm: ");
-    if (scheduler.algorithm == FCFS) {
+    if (SCHED_ALGORITHM == FCFS) {
         serial_puts("FCFS\n");
+    } else if (SCHED_ALGORITHM == MLFQ) {
+        serial_puts("MLFQ (");
+        serial_put_dec(MLFQ_LEVELS);
+        serial_puts(" levels, base quantum ");
+        serial_put_dec(scheduler.time_quantum);
+        serial_puts("ms)\n");
     } else {
         serial_puts("Round Robin (");
         serial_put_dec(scheduler.time_quantum);
         serial_puts("ms)\n");
     }
-    serial_puts("Current Time: ");
+    serial_puts("Ticks: ");
     serial_put_dec(scheduler.current_time);
-    serial_puts("ms\n");
+    serial_puts("\nUptime: ");
+    clock_put_ms(clock_now_ns());
+    serial_puts("\n");
+    scheduler_print_loadavg();
     serial_puts("Current Process: ");
-    serial_put_dec(current_process_id);
+    serial_put_dec(scheduler_current_process());
     serial_puts("\n");
     serial_puts("Time Since Switch: ");
-    serial_put_dec(time_since_switch);
-    serial_puts("ms\n\n");
+    serial_put_dec(scheduler.current_time - runqueues[smp_cpu_id()].slice_start);
+    serial_puts(" ticks, ");
+    clock_put_ms(scheduler_time_since_switch_ns());
+    serial_puts("\nPending Timers: ");
+    serial_put_dec(scheduler_timers.pending);
+    serial_puts("\n");
+    if (smp_cpu_count() > 1) {
+        uint32_t i;
+        for (i = 0; i < smp_cpu_count(); i++) {
+            serial_puts("CPU ");
+            serial_put_dec(i);
+            serial_puts(": current PID ");
+            serial_put_dec(runqueues[i].current_process_id);
+            serial_puts(", ");
+            serial_put_dec(runqueues[i].nr_assigned);
+            serial_puts(" processes, ");
+            serial_put_dec(runqueues[i].steals);
+            serial_puts(" stolen\n");
+        }
+    }
+    serial_puts("EDF Tasks: ");
+    serial_put_dec(edf_task_count);
+    serial_puts(" (utilization ");
+    serial_put_dec(edf_utilization / 100);
+    serial_puts(".");
+    serial_put_dec((edf_utilization % 100) / 10);
+    serial_put_dec(edf_utilization % 10);
+    serial_puts("%, ");
+    serial_put_dec(edf_total_misses);
+    serial_puts(" deadline misses)\n\n");
+}
+
+/**
+ * Admit a process into the EDF real-time class
+ * Re-admitting an EDF process replaces its previous reservation. The first
+ * job is released at once, so a process that is BLOCKED is refused.
+ * @param process_id: ID of process
+ * @param runtime: Execution budget per period (ticks)
+ * @param period: Release interval (ticks)
+ * @param deadline: Relative deadline (ticks), runtime <= deadline <= period
+ * @return: 1 if admitted, 0 if rejected
+ */
+uint32_t scheduler_set_edf(uint32_t process_id, uint32_t runtime, uint32_t period, uint32_t deadline) {
+    process_control_block_t *pcb = process_get_pcb(process_id);
+    uint32_t utilization;
+    uint32_t others;              /* Utilization of every other EDF task */
+    uint32_t tasks;
+    uint32_t admitted = 0;
+    uint32_t runnable;
+    uint32_t flags;
+    if (pcb == NULL || pcb->state == TERMINATED || process_id == 0) {
+        serial_puts("[SCHEDULER] ERROR: EDF admission for invalid process\n");
+        return 0;
+    }
+    if (runtime == 0 || runtime > deadline || deadline > period || period > EDF_MAX_PERIOD) {
+        serial_puts("[SCHEDULER] ERROR: Invalid EDF parameters\n");
+        return 0;
+    }
+    utilization = edf_task_utilization(runtime, deadline);
+    flags = spin_lock_irqsave(&scheduler_lock);
+    /* A job is released at once, so a process still asleep or queued on a lock must not get one */
+    runnable = pcb->state == READY || pcb->state == CURRENT;
+    others = edf_utilization;
+    tasks = edf_task_count;
+    if (pcb->sched_class == SCHED_CLASS_EDF) {
+        /* Re-admission: the old reservation stays until the new one is accepted */
+        others -= edf_task_utilization(pcb->edf.runtime, pcb->edf.deadline);
+        tasks--;
+    }
+    if (runnable && tasks < EDF_MAX_TASKS && others + utilization <= EDF_UTIL_SCALE) {
+        edf_remove(pcb);
+        edf_admit(pcb, runtime, period, deadline, utilization);
+        admitted = 1;
+    }
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+    if (!runnable) {
+        serial_puts("[SCHEDULER] EDF admission rejected: process is blocked\n");
+    }
+    else if (!admitted) {
+        serial_puts("[SCHEDULER] EDF admission rejected: utilization would exceed 100%\n");
+    }
+    return admitted;
+}
+
+/**
+ * Remove a terminated process from its run queue and release any EDF reservation
+ * @param process_id: ID of process
+ */
+void scheduler_remove_process(uint32_t process_id) {
+    process_control_block_t *pcb = process_get_pcb(process_id);
+    uint32_t flags;
+    if (pcb == NULL) {
+        return;
+    }
+    flags = spin_lock_irqsave(&scheduler_lock);
+    edf_remove(pcb);
+    scheduler_stop_waiting(pcb);
+    timer_cancel(&scheduler_timers, &pcb->sleep_timer);
+    if (runqueues[pcb->cpu].nr_assigned > 0) {
+        runqueues[pcb->cpu].nr_assigned--;
+    }
+    scheduler_kick(pcb, TRACE_REASON_EXIT);
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+}
+
+/**
+ * Home a newly created process on the least loaded online CPU
+ * @param process_id: ID of process
+ */
+void scheduler_enqueue_process(uint32_t process_id) {
+    process_control_block_t *pcb = process_get_pcb(process_id);
+    uint32_t i;
+    uint32_t target = 0;
+    uint32_t flags;
+    if (pcb == NULL) {
+        return;
+    }
+    flags = spin_lock_irqsave(&scheduler_lock);
+    for (i = 1; i < smp_cpu_count(); i++) {
+        if (runqueues[i].nr_assigned < runqueues[target].nr_assigned) {
+            target = i;
+        }
+    }
+    pcb->cpu = target;
+    /* A reused slot may still have timers queued from a process_init()-era predecessor */
+    timer_cancel(&scheduler_timers, &pcb->aging_timer);
+    timer_cancel(&scheduler_timers, &pcb->sleep_timer);
+    timer_setup(&pcb->aging_timer, scheduler_aging_timeout);
+    timer_setup(&pcb->sleep_timer, scheduler_sleep_timeout);
+    scheduler_start_waiting(pcb);
+    runqueues[target].nr_assigned++;
+    //An idle CPU picks the new arrival up at its next scheduling point
+    if (runqueues[target].current_process_id == 0) {
+        runqueues[target].need_resched = 1;
+    }
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+}
+
+//Process currently running on the calling CPU
+uint32_t scheduler_current_process(void) {
+    return runqueues[smp_cpu_id()].current_process_id;
+}
+
+//Real time the calling CPU's current process has been running since it was switched in
+uint64_t scheduler_time_since_switch_ns(void) {
+    process_control_block_t *pcb = process_get_pcb(scheduler_current_process());
+    return pcb != NULL ? clock_cycles_to_ns(clock_cycles() - pcb->run_start) : 0;
+}
+
+/**
+ * Switch the scheduling policy of a running system
+ * Processes keep their run queues and MLFQ levels.
+ * @param algorithm: Scheduling algorithm (FCFS, RR or MLFQ)
+ * @param time_quantum: Time slice for RR, base slice for MLFQ (ms)
+ * @return: 1 on success, 0 if rejected
+ */
+uint32_t scheduler_set_algorithm(scheduling_algorithm_t algorithm, uint32_t time_quantum) {
+    uint32_t i;
+    uint32_t flags;
+#ifdef CONFIG_SCHED_POLICY
+    if (algorithm != SCHED_ALGORITHM) {
+        serial_puts("[SCHEDULER] ERROR: Policy is fixed at build time\n");
+        return 0;
+    }
+#endif
+    if (algorithm > MLFQ || (algorithm != FCFS && time_quantum == 0)) {
+        serial_puts("[SCHEDULER] ERROR: Invalid scheduling algorithm or time quantum\n");
+        return 0;
+    }
+    flags = spin_lock_irqsave(&scheduler_lock);
+    scheduler.algorithm = algorithm;
+    scheduler.time_quantum = time_quantum;
+    /* Running slices keep their start but end by the new rules */
+    for (i = 0; i < smp_cpu_count(); i++) {
+        scheduler_arm_quantum(i);
+    }
+    spin_unlock_irqrestore(&scheduler_lock, flags);
+    return 1;
+}
+
+//Active scheduling algorithm
+scheduling_algorithm_t scheduler_get_algorithm(void) {
+    return SCHED_ALGORITHM;
+}
+
+//Active time quantum (ms)
+uint32_t scheduler_get_quantum(void) {
+    return scheduler.time_quantum;
+}
+
+//Scheduler ticks elapsed since scheduler_init
+uint32_t scheduler_get_time(void) {
+    return scheduler.current_time;
+}
+
+//Ticks a process has spent READY since its last aging promotion
+uint32_t scheduler_wait_time(const process_control_block_t *pcb) {
+    uint32_t waited = pcb->wait_time;
+    if (timer_pending(&pcb->aging_timer)) {
+        waited += scheduler.current_time - pcb->wait_since;
+    }
+    return waited;
+}
+
+//Timers queued on the scheduler's wheel (sleeps, slices, aging, periodic work)
+uint32_t scheduler_pending_timers(void) {
+    return scheduler_timers.pending;
+}
+
+/**
+ * Get the exponentially-decayed load averages
+ * @param loads: Receives the 1s, 5s and 15s averages (LOAD_FIXED_1 == 1.0)
+ */
+void scheduler_get_loadavg(uint32_t loads[3]) {
+    loads[0] = scheduler.load_avg[0];
+    loads[1] = scheduler.load_avg[1];
+    loads[2] = scheduler.load_avg[2];
+}
+
+//Print load averages as "a.bb c.dd e.ff"
+void scheduler_print_loadavg(void) {
+    uint32_t i;
+    serial_puts("Load average (1s/5s/15s): ");
+    for (i = 0; i < 3; i++) {
+        uint32_t load = scheduler.load_avg[i];
+        uint32_t hundredths = ((load & (LOAD_FIXED_1 - 1)) * 100) >> LOAD_FSHIFT;
+        serial_put_dec(load >> LOAD_FSHIFT);
+        serial_puts(hundredths < 10 ? ".0" : ".");
+        serial_put_dec(hundredths);
+        serial_puts(i < 2 ? " " : "\n");
+    }
+}
+
+//Whether the tick has asked the calling CPU to make a scheduling decision
+uint32_t scheduler_need_resched(void) {
+    return runqueues[smp_cpu_id()].need_resched;
+}
+
+//Total admitted EDF utilization (EDF_UTIL_SCALE == 100%)
+uint32_t scheduler_edf_utilization(void) {
+    return edf_utilization;
+}
+
+//Deadline misses across all EDF tasks since scheduler_init
+uint32_t scheduler_edf_deadline_misses(void) {
+    return edf_total_misses;
 }
@@ -2,12 +2,15 @@
 #define SCHEDULER_H
 #include "types.h"
 #include "process.h"
+#include "timer.h"
 //Scheduling algorithm types 
 typedef enum {
     // first come first served
     FCFS = 0,  
     // Round Robin         
-    RR = 1            
+    RR = 1,
+    // Multilevel feedback queue
+    MLFQ = 2
 } scheduling_algorithm_t;
 
 //Scheduler structure
@@ -16,14 +19,69 @@ typedef struct {
     uint32_t time_quantum;      /* Time slice for round robin (ms) */
     uint32_t current_time;
     uint32_t process_count;
+    uint32_t load_avg[3];       /* Runnable-process averages, LOAD_FIXED_1 == 1.0 */
 } scheduler_t;
 
+//Per-CPU run queue: processes are homed on a CPU through pcb->cpu
+typedef struct {
+    uint32_t current_process_id;
+    uint32_t slice_start;             /* Tick the current time slice began */
+    uint32_t quantum_expired;         /* Set by quantum_timer, cleared by the next slice */
+    timer_event_t quantum_timer;
+    volatile uint32_t need_resched;   /* Set by the tick, consumed by the owning CPU */
+    uint32_t nr_assigned;             /* Live processes homed on this CPU */
+    uint32_t steals;                  /* Processes pulled from other CPUs */
+    uint32_t nr_ready;                /* READY processes seen by the last pick */
+    uint32_t last_pick_stolen;        /* Last pick came from another CPU */
+} cpu_runqueue_t;
+
+//MLFQ tuning: level N gets time_quantum << N ticks
+#define MLFQ_LEVELS           4
+#define MLFQ_BOOST_INTERVAL   200       /* Ticks between moving everyone back to level 0 */
+
+//Aging: a normal-class process READY this long in total gets one priority level back
+#define AGING_THRESHOLD       1000
+
+//Load averages: sampled every LOAD_SAMPLE_TICKS, decayed over ~1s/5s/15s of 1ms ticks
+#define LOAD_SAMPLE_TICKS     100
+#define LOAD_FSHIFT           11
+#define LOAD_FIXED_1          (1 << LOAD_FSHIFT)
+#define LOAD_EXP_1            1853      /* 2048 * e^(-0.1/1) */
+#define LOAD_EXP_5            2007      /* 2048 * e^(-0.1/5) */
+#define LOAD_EXP_15           2034      /* 2048 * e^(-0.1/15) */
+
+//EDF admission control limits
+#define EDF_MAX_TASKS     32
+#define EDF_MAX_PERIOD    100000    /* Keeps utilization math in 32 bits */
+#define EDF_UTIL_SCALE    10000     /* Fixed-point utilization, 10000 == 100% */
+
 //Function declarations
 void scheduler_init(scheduling_algorithm_t algorithm, uint32_t time_quantum);
 void scheduler_schedule(void);
 void scheduler_context_switch(uint32_t from_pid, uint32_t to_pid);
 uint32_t scheduler_get_next_process(void);
 void scheduler_update_time(void);
+void scheduler_yield(void);
+uint32_t scheduler_block(uint32_t process_id);
+uint32_t scheduler_sleep(uint32_t process_id, uint32_t ticks);
+void scheduler_wake(uint32_t process_id);
+uint32_t scheduler_handoff(uint32_t from_pid, uint32_t to_pid, uint32_t block);
 void scheduler_apply_aging(void);
 void scheduler_print_status(void);
+void scheduler_enqueue_process(uint32_t process_id);
+uint32_t scheduler_current_process(void);
+uint64_t scheduler_time_since_switch_ns(void);
+uint32_t scheduler_set_algorithm(scheduling_algorithm_t algorithm, uint32_t time_quantum);
+scheduling_algorithm_t scheduler_get_algorithm(void);
+uint32_t scheduler_get_quantum(void);
+uint32_t scheduler_get_time(void);
+uint32_t scheduler_wait_time(const process_control_block_t *pcb);
+uint32_t scheduler_pending_timers(void);
+void scheduler_get_loadavg(uint32_t loads[3]);
+void scheduler_print_loadavg(void);
+uint32_t scheduler_need_resched(void);
+uint32_t scheduler_set_edf(uint32_t process_id, uint32_t runtime, uint32_t period, uint32_t deadline);
+void scheduler_remove_process(uint32_t process_id);
+uint32_t scheduler_edf_utilization(void);
+uint32_t scheduler_edf_deadline_misses(void);
 #endif
@@ -1,9 +1,71 @@
 /* serial.c - Serial port driver (COM1) */
 #include "serial.h"
 #include "io.h"
+#include "cpu.h"
+#include "interrupt.h"
+#include "spinlock.h"
+#include "kprintf.h"
+#include "latency.h"
+#include "deferred.h"
 
 #define COM1 0x3F8   /* I/O port base address for COM1 */
 
+//UART registers and bits
+#define UART_IER        1         /* Interrupt enable */
+#define UART_IIR        2         /* Interrupt identification (read) */
+#define UART_LSR        5         /* Line status */
+#define IER_RDA         0x01      /* Interrupt when received data is available */
+#define IER_THRE        0x02      /* Interrupt when the transmit FIFO empties */
+#define LSR_DR          0x01      /* Received data ready */
+#define LSR_THRE        0x20      /* Transmit FIFO empty */
+#define UART_FIFO_SIZE  16
+
+#define RX_STAGE_SIZE   64        /* Bytes the RX interrupt can hold for the deferred half */
+
+#define TX_MASK (SERIAL_TX_BUFFER_SIZE - 1)
+#define RX_MASK (SERIAL_RX_BUFFER_SIZE - 1)
+#define RX_STAGE_MASK (RX_STAGE_SIZE - 1)
+
+/*
+ * Transmit ring: writers append at tx_head under serial_lock, the THRE
+ * interrupt moves up to UART_FIFO_SIZE bytes from tx_tail into the UART
+ * per interrupt. Indices run freely and are masked on access.
+ */
+static char tx_buffer[SERIAL_TX_BUFFER_SIZE];
+static volatile uint32_t tx_head;
+static volatile uint32_t tx_tail;
+static volatile uint32_t tx_irq_mode;     /* 0 = polled output (early boot, panics) */
+static volatile uint32_t tx_muted;        /* Drop output, e.g. around timed benchmark loops */
+static uint8_t ier_bits;                  /* UART_IER value apart from IER_THRE */
+static spinlock_t serial_lock = SPINLOCK_INIT("serial");
+
+/*
+ * Receive side: each byte the RX interrupt picks up goes through the line
+ * discipline. In canonical mode the line being typed is edited in
+ * rx_edit (with echo) and only whole lines, '\n' terminated, reach
+ * rx_buffer; in raw mode bytes go straight to rx_buffer.
+ */
+static char rx_buffer[SERIAL_RX_BUFFER_SIZE];
+static volatile uint32_t rx_head;
+static volatile uint32_t rx_tail;
+static volatile uint32_t rx_lines;        /* Complete lines in rx_buffer */
+static volatile uint32_t rx_irq_mode;
+static volatile uint32_t rx_raw;
+static uint32_t rx_overruns;              /* Lines or bytes dropped with rx_buffer or rx_stage full */
+static char rx_edit[SERIAL_LINE_MAX];
+static uint32_t rx_edit_len;
+
+/*
+ * The RX interrupt only drains the UART into rx_stage; serial_rx_work runs
+ * the line discipline (and its echo) later as deferred work. Both sides
+ * hold serial_lock.
+ */
+static void serial_rx_deferred(void *arg);
+static char rx_stage[RX_STAGE_SIZE];
+static uint32_t rx_stage_head;
+static uint32_t rx_stage_tail;
+static deferred_work_t serial_rx_work = DEFERRED_WORK_INIT(serial_rx_deferred, NULL);
+
 /*
 You can find more information here: https://caro.su/msx/ocm_de1/16550.pdf
 
@@ -33,69 +95,364 @@ void serial_init(void) {
 }
 
 static int is_transmit_empty(void) {
-    return inb(COM1 + 5) & 0x20;
+    return inb(COM1 + UART_LSR) & LSR_THRE;
 }
 
-void serial_putc(char c) {
+/* Busy-wait output for polled mode */
+static void serial_putc_polled(char c) {
     if (c == '\n') {
-        serial_putc('\r');  /* Add carriage return */
+        serial_putc_polled('\r');  /* Add carriage return */
     }
     while (!is_transmit_empty());
     outb(COM1, c);
 }
 
-void serial_puts(const char* str) {
+/* Refill an empty UART FIFO from the ring; caller holds serial_lock */
+static void serial_tx_fill(void) {
+    uint32_t sent = 0;
+    if (is_transmit_empty()) {
+        while (tx_tail != tx_head && sent < UART_FIFO_SIZE) {
+            outb(COM1, tx_buffer[tx_tail & TX_MASK]);
+            tx_tail++;
+            sent++;
+        }
+    }
+    /* Ask for an interrupt only while there is more to send */
+    outb(COM1 + UART_IER, tx_tail != tx_head ? ier_bits | IER_THRE : ier_bits);
+}
+
+/* Echo one byte from the line discipline; caller holds serial_lock */
+static void serial_echo(char c) {
+    if (!tx_irq_mode) {
+        serial_putc_polled(c);
+        return;
+    }
+    if (c == '\n' && tx_head - tx_tail < SERIAL_TX_BUFFER_SIZE) {
+        tx_buffer[tx_head++ & TX_MASK] = '\r';
+    }
+    if (tx_head - tx_tail < SERIAL_TX_BUFFER_SIZE) {
+        tx_buffer[tx_head++ & TX_MASK] = c;
+    }
+}
+
+static void serial_echo_string(const char *str) {
     while (*str) {
-        serial_putc(*str++);
+        serial_echo(*str++);
+    }
+}
+
+/* Line discipline for one received byte; caller holds serial_lock */
+static void serial_rx_locked(char c) {
+    uint32_t i;
+    if (rx_raw) {
+        if (rx_head - rx_tail < SERIAL_RX_BUFFER_SIZE) {
+            rx_buffer[rx_head++ & RX_MASK] = c;
+        }
+        else {
+            rx_overruns++;
+        }
+        return;
+    }
+    if (c == '\r' || c == '\n') {
+        serial_echo('\n');
+        if (SERIAL_RX_BUFFER_SIZE - (rx_head - rx_tail) <= rx_edit_len) {
+            rx_overruns++;
+        }
+        else {
+            for (i = 0; i < rx_edit_len; i++) {
+                rx_buffer[rx_head++ & RX_MASK] = rx_edit[i];
+            }
+            rx_buffer[rx_head++ & RX_MASK] = '\n';
+            rx_lines++;
+        }
+        rx_edit_len = 0;
+    }
+    else if ((c == '\b' || c == 0x7F) && rx_edit_len > 0) {
+        rx_edit_len--;
+        serial_echo_string("\b \b");  /* Erase character on screen */
+    }
+    else if (c >= 32 && c < 127 && rx_edit_len < SERIAL_LINE_MAX - 1) {
+        rx_edit[rx_edit_len++] = c;
+        serial_echo(c);
     }
 }
 
-static int serial_received(void) {
-    return inb(COM1 + 5) & 0x01;
+/**
+ * Feed one received byte through the line discipline
+ * Used by the polled reader; tests use it to inject input.
+ * @param c: Received byte
+ */
+void serial_rx_input(char c) {
+    uint32_t flags = spin_lock_irqsave(&serial_lock);
+    serial_rx_locked(c);
+    if (tx_irq_mode) {
+        serial_tx_fill();
+    }
+    spin_unlock_irqrestore(&serial_lock, flags);
 }
 
-char serial_getc(void) {
-    while (!serial_received());
-    return inb(COM1);
+/* Ring full: push bytes out by hand, which also works with interrupts off */
+static void serial_tx_wait(void) {
+    uint32_t flags = spin_lock_irqsave(&serial_lock);
+    serial_tx_fill();
+    spin_unlock_irqrestore(&serial_lock, flags);
+    cpu_relax();
 }
 
-void serial_put_hex(uint32_t value) {
-    const char hex_chars[] = "0123456789ABCDEF";
+/* Deferred half of the RX interrupt: run staged bytes through the line discipline */
+static void serial_rx_deferred(void *arg) {
+    uint32_t flags;
+    (void)arg;
+    flags = spin_lock_irqsave(&serial_lock);
+    while (rx_stage_tail != rx_stage_head) {
+        serial_rx_locked(rx_stage[rx_stage_tail++ & RX_STAGE_MASK]);
+    }
+    serial_tx_fill();
+    spin_unlock_irqrestore(&serial_lock, flags);
+}
+
+/* COM1 interrupt: input arrived and/or the transmit FIFO has drained */
+static void serial_irq(interrupt_frame_t *frame) {
+    uint32_t staged = 0;
+    (void)frame;
+    spin_lock(&serial_lock);
+    inb(COM1 + UART_IIR);   /* Acknowledge */
+    while (inb(COM1 + UART_LSR) & LSR_DR) {
+        char c = inb(COM1);
+        if (rx_stage_head - rx_stage_tail < RX_STAGE_SIZE) {
+            rx_stage[rx_stage_head++ & RX_STAGE_MASK] = c;
+            staged = 1;
+        }
+        else {
+            rx_overruns++;
+        }
+    }
+    serial_tx_fill();
+    spin_unlock(&serial_lock);
+    if (staged) {
+        deferred_queue(&serial_rx_work);
+    }
+}
+
+//Switch to interrupt-driven input and output (after interrupt_init)
+void serial_enable_irq(void) {
+    uint32_t flags = spin_lock_irqsave(&serial_lock);
+    irq_register(IRQ_COM1, serial_irq);
+    ier_bits = IER_RDA;
+    tx_irq_mode = 1;
+    rx_irq_mode = 1;
+    serial_tx_fill();
+    spin_unlock_irqrestore(&serial_lock, flags);
+}
+
+/**
+ * Queue bytes for transmission without waiting
+ * Newlines are expanded to CR LF. Before serial_enable_irq() the bytes are
+ * written out immediately instead.
+ * @param buf: Bytes to send
+ * @param len: Number of bytes
+ * @return: Number of bytes accepted; less than len if the ring is full
+ */
+uint32_t serial_write(const char *buf, uint32_t len) {
     uint32_t i;
-    uint32_t started = 0;
-    
-    for (i = 0; i < 8; i++) {
-        uint32_t digit = (value >> (28 - i * 4)) & 0x0F;
-        
-        if (digit != 0 || started) {
-            serial_putc(hex_chars[digit]);
-            started = 1;
+    uint32_t flags;
+    if (tx_muted) {
+        return len;
+    }
+    if (!tx_irq_mode) {
+        for (i = 0; i < len; i++) {
+            serial_putc_polled(buf[i]);
         }
+        return len;
     }
-    
-    if (!started) {
-        serial_putc('0');
+    flags = spin_lock_irqsave(&serial_lock);
+    for (i = 0; i < len; i++) {
+        uint32_t needed = buf[i] == '\n' ? 2 : 1;
+        if (SERIAL_TX_BUFFER_SIZE - (tx_head - tx_tail) < needed) {
+            break;
+        }
+        if (buf[i] == '\n') {
+            tx_buffer[tx_head++ & TX_MASK] = '\r';
+        }
+        tx_buffer[tx_head++ & TX_MASK] = buf[i];
     }
+    serial_tx_fill();
+    spin_unlock_irqrestore(&serial_lock, flags);
+    return i;
 }
 
-void serial_put_dec(uint32_t value) {
-    if (value == 0) {
-        serial_putc('0');
-        return;
+//Bytes queued but not yet handed to the UART
+uint32_t serial_tx_pending(void) {
+    return tx_head - tx_tail;
+}
+
+//Wait until everything queued has been handed to the UART
+void serial_flush(void) {
+    while (tx_tail != tx_head) {
+        serial_tx_wait();
     }
-    
-    uint32_t divisor = 1000000000;
-    uint32_t started = 0;
-    
-    while (divisor > 0) {
-        uint32_t digit = value / divisor;
-        value %= divisor;
-        
-        if (digit != 0 || started) {
-            serial_putc('0' + digit);
-            started = 1;
+}
+
+//Drop back to lock-free polled output for fatal error reports
+void serial_panic_mode(void) {
+    tx_irq_mode = 0;
+    tx_muted = 0;
+    while (tx_tail != tx_head) {
+        while (!is_transmit_empty());
+        outb(COM1, tx_buffer[tx_tail++ & TX_MASK]);
+    }
+}
+
+/**
+ * Discard console output until unmuted
+ * Kernel messages at 38400 baud would otherwise dominate anything being timed.
+ * @param muted: Non-zero to drop output
+ * @return: Previous setting
+ */
+uint32_t serial_set_muted(uint32_t muted) {
+    uint32_t previous = tx_muted;
+    tx_muted = muted ? 1 : 0;
+    return previous;
+}
+
+void serial_putc(char c) {
+    while (serial_write(&c, 1) == 0) {
+        serial_tx_wait();
+    }
+}
+
+/* Write a whole buffer, waiting for ring space as needed */
+static void serial_write_all(const char *buf, uint32_t len) {
+    while (len > 0) {
+        uint32_t sent = serial_write(buf, len);
+        buf += sent;
+        len -= sent;
+        if (len > 0) {
+            serial_tx_wait();
         }
-        
-        divisor /= 10;
     }
 }
+
+void serial_puts(const char* str) {
+    uint32_t len = 0;
+    while (str[len]) {
+        len++;
+    }
+    serial_write_all(str, len);
+}
+
+static uint32_t serial_line_ready(void) {
+    return rx_lines != 0;
+}
+
+/*
+ * Halt until the next interrupt unless the condition already holds;
+ * the caller re-checks it. Interrupts stay enabled while halted, so other
+ * interrupt-driven work carries on while the console is idle.
+ */
+static void serial_rx_sleep(uint32_t (*ready)(void)) {
+    uint32_t idle;
+    cpu_irq_disable();
+    latency_irqs_off((uint32_t)(uintptr_t)serial_rx_sleep);
+    idle = !ready();
+    latency_irqs_on((uint32_t)(uintptr_t)serial_rx_sleep);
+    if (idle) {
+        cpu_wait_for_interrupt();
+    }
+    cpu_irq_enable();
+}
+
+//Lines or bytes dropped because the receive ring was full
+uint32_t serial_rx_overruns(void) {
+    return rx_overruns;
+}
+
+//Whether input is waiting (whole lines only in canonical mode)
+int serial_received(void) {
+    if (!rx_irq_mode) {
+        return inb(COM1 + UART_LSR) & LSR_DR;
+    }
+    return rx_head != rx_tail;
+}
+
+static uint32_t serial_rx_available(void) {
+    return rx_head != rx_tail;
+}
+
+//Read one byte, sleeping until one arrives
+char serial_getc(void) {
+    char c;
+    uint32_t flags;
+    if (!rx_irq_mode) {
+        while (!(inb(COM1 + UART_LSR) & LSR_DR));
+        return inb(COM1);
+    }
+    while (!serial_rx_available()) {
+        serial_rx_sleep(serial_rx_available);
+    }
+    flags = spin_lock_irqsave(&serial_lock);
+    c = rx_buffer[rx_tail++ & RX_MASK];
+    if (c == '\n' && !rx_raw) {
+        rx_lines--;
+    }
+    spin_unlock_irqrestore(&serial_lock, flags);
+    return c;
+}
+
+/**
+ * Read one edited line, sleeping until the user presses Enter
+ * Backspace editing and echo are handled by the driver.
+ * @param buf: Destination, NUL terminated; longer lines are truncated
+ * @param size: Size of buf
+ * @return: Length of the line without the newline
+ */
+uint32_t serial_read_line(char *buf, uint32_t size) {
+    uint32_t len = 0;
+    char c;
+    uint32_t flags;
+    while (!serial_line_ready()) {
+        if (rx_irq_mode) {
+            serial_rx_sleep(serial_line_ready);
+        }
+        else {
+            while (!(inb(COM1 + UART_LSR) & LSR_DR));
+            serial_rx_input(inb(COM1));
+        }
+    }
+    flags = spin_lock_irqsave(&serial_lock);
+    while ((c = rx_buffer[rx_tail++ & RX_MASK]) != '\n') {
+        if (len + 1 < size) {
+            buf[len++] = c;
+        }
+    }
+    rx_lines--;
+    spin_unlock_irqrestore(&serial_lock, flags);
+    if (size > 0) {
+        buf[len] = '\0';
+    }
+    return len;
+}
+
+/**
+ * Switch between canonical (line-edited) and raw input
+ * Pending input is discarded.
+ * @param raw: 1 for raw bytes without echo, 0 for edited lines
+ */
+void serial_set_raw(uint32_t raw) {
+    uint32_t flags = spin_lock_irqsave(&serial_lock);
+    rx_raw = raw;
+    rx_tail = rx_head;
+    rx_lines = 0;
+    rx_edit_len = 0;
+    spin_unlock_irqrestore(&serial_lock, flags);
+}
+
+void serial_put_hex(uint32_t value) {
+    char digits[8];
+    serial_write_all(digits, kfmt_hex(digits, value, 1));
+}
+
+void serial_put_dec(uint32_t value) {
+    char digits[10];
+    serial_write_all(digits, kfmt_dec(digits, value));
+}
\ No newline at end of file
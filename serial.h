@@ -4,10 +4,25 @@
 
 #include "types.h"
 
+#define SERIAL_TX_BUFFER_SIZE  4096   /* Transmit ring; must be a power of two */
+#define SERIAL_RX_BUFFER_SIZE  512    /* Receive ring; must be a power of two */
+#define SERIAL_LINE_MAX        128    /* Longest line the line discipline edits */
+
 void serial_init(void);
+void serial_enable_irq(void);
+uint32_t serial_write(const char *buf, uint32_t len);
+uint32_t serial_tx_pending(void);
+void serial_flush(void);
+void serial_panic_mode(void);
+uint32_t serial_set_muted(uint32_t muted);
 void serial_putc(char c);
 void serial_puts(const char* str);
 char serial_getc(void);
+int serial_received(void);
+void serial_rx_input(char c);
+uint32_t serial_read_line(char *buf, uint32_t size);
+void serial_set_raw(uint32_t raw);
+uint32_t serial_rx_overruns(void);
 void serial_put_hex(uint32_t value);
 void serial_put_dec(uint32_t value);
 
@@ -0,0 +1,250 @@
+/* shm.c - Named shared-memory regions
+ *
+ * A region is one allocator block owned by MEMORY_OWNER_SHARED instead of a
+ * process, so memory_free_process() never takes it away from the processes
+ * still using it. Each attached process holds one reference; the block is
+ * freed and the name released when the last one detaches or exits. There is
+ * no paging yet, so every process sees a region at the same address.
+ */
+#include "shm.h"
+#include "memory.h"
+#include "process.h"
+#include "spinlock.h"
+#include "serial.h"
+#include "string.h"
+#include "kprintf.h"
+
+//One named region
+typedef struct {
+    char name[SHM_NAME_LEN];
+    uint32_t address;                 /* 0 while the slot is unused */
+    uint32_t size;
+    uint32_t refs;                    /* Attached processes */
+    uint32_t attached[(MAX_PROCESSES + 31) / 32];    /* Bit per process table slot */
+} shm_region_t;
+
+static shm_region_t regions[SHM_MAX_REGIONS];
+/* Taken before the memory lock */
+static spinlock_t shm_lock = SPINLOCK_INIT("shm");
+
+/* Region with this name, or NULL */
+static shm_region_t *shm_find(const char *name) {
+    uint32_t i;
+    for (i = 0; i < SHM_MAX_REGIONS; i++) {
+        if (regions[i].address != 0 && strcmp(regions[i].name, name) == 0) {
+            return &regions[i];
+        }
+    }
+    return NULL;
+}
+
+static shm_region_t *shm_find_address(uint32_t address) {
+    uint32_t i;
+    for (i = 0; i < SHM_MAX_REGIONS; i++) {
+        if (regions[i].address != 0 && regions[i].address == address) {
+            return &regions[i];
+        }
+    }
+    return NULL;
+}
+
+/* Live, non-null process's table slot, or 0 */
+static uint32_t shm_slot(uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    if (pid == 0 || pcb == NULL || pcb->state == TERMINATED) {
+        return 0;
+    }
+    return (uint32_t)(pcb - process_slot(0));
+}
+
+static uint32_t shm_is_attached(shm_region_t *region, uint32_t slot) {
+    return (region->attached[slot / 32] >> (slot % 32)) & 1;
+}
+
+/* Add a reference for a process; attaching twice is a no-op */
+static void shm_add_ref(shm_region_t *region, uint32_t slot) {
+    if (!shm_is_attached(region, slot)) {
+        region->attached[slot / 32] |= 1U << (slot % 32);
+        region->refs++;
+    }
+}
+
+/* Drop a process's reference, freeing the region with the last one; caller holds shm_lock */
+static void shm_drop_ref(shm_region_t *region, uint32_t slot) {
+    region->attached[slot / 32] &= ~(1U << (slot % 32));
+    if (--region->refs == 0) {
+        memory_free(region->address);
+        memset(region, 0, sizeof(*region));
+    }
+}
+
+//Forget every region; the allocator and process table have been reset
+void shm_init(void) {
+    uint32_t flags = spin_lock_irqsave(&shm_lock);
+    memset(regions, 0, sizeof(regions));
+    spin_unlock_irqrestore(&shm_lock, flags);
+}
+
+/**
+ * Create a named region and attach the creator to it
+ * @param name: Region name, at most SHM_NAME_LEN - 1 characters
+ * @param size: Size in bytes
+ * @param pid: Creating process
+ * @return: Region address, or 0 if the name is taken or memory ran out
+ */
+uint32_t shm_create(const char *name, uint32_t size, uint32_t pid) {
+    uint32_t slot = shm_slot(pid);
+    shm_region_t *region = NULL;
+    uint32_t address = 0;
+    uint32_t i;
+    uint32_t flags;
+    if (slot == 0 || name[0] == '\0' || strlen(name) >= SHM_NAME_LEN) {
+        serial_puts("[SHM] ERROR: Invalid process or region name\n");
+        return 0;
+    }
+    flags = spin_lock_irqsave(&shm_lock);
+    if (shm_find(name) != NULL) {
+        spin_unlock_irqrestore(&shm_lock, flags);
+        serial_puts("[SHM] ERROR: Region name already in use\n");
+        return 0;
+    }
+    for (i = 0; i < SHM_MAX_REGIONS && region == NULL; i++) {
+        if (regions[i].address == 0) {
+            region = &regions[i];
+        }
+    }
+    if (region != NULL) {
+        address = memory_allocate(size, MEMORY_OWNER_SHARED);
+    }
+    if (address != 0) {
+        strcpy(region->name, name);
+        region->address = address;
+        region->size = size;
+        shm_add_ref(region, slot);
+    }
+    spin_unlock_irqrestore(&shm_lock, flags);
+    if (region == NULL) {
+        serial_puts("[SHM] ERROR: Region table full\n");
+    }
+    return address;
+}
+
+/**
+ * Attach a process to an existing region
+ * @param name: Region name
+ * @param pid: Process attaching
+ * @return: Region address, or 0 if there is no such region
+ */
+uint32_t shm_attach(const char *name, uint32_t pid) {
+    uint32_t slot = shm_slot(pid);
+    uint32_t address = 0;
+    shm_region_t *region;
+    uint32_t flags;
+    if (slot == 0) {
+        serial_puts("[SHM] ERROR: Invalid process\n");
+        return 0;
+    }
+    flags = spin_lock_irqsave(&shm_lock);
+    region = shm_find(name);
+    if (region != NULL) {
+        shm_add_ref(region, slot);
+        address = region->address;
+    }
+    spin_unlock_irqrestore(&shm_lock, flags);
+    if (address == 0) {
+        serial_puts("[SHM] ERROR: No such region\n");
+    }
+    return address;
+}
+
+/**
+ * Detach a process from a region; the last detach frees it
+ * @param address: Region address returned by shm_create()/shm_attach()
+ * @param pid: Attached process
+ * @return: 1 if detached, 0 if pid was not attached there
+ */
+uint32_t shm_detach(uint32_t address, uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    uint32_t detached = 0;
+    shm_region_t *region;
+    uint32_t slot;
+    uint32_t flags;
+    if (pcb == NULL || pid == 0) {
+        return 0;
+    }
+    slot = (uint32_t)(pcb - process_slot(0));
+    flags = spin_lock_irqsave(&shm_lock);
+    region = shm_find_address(address);
+    if (region != NULL && shm_is_attached(region, slot)) {
+        shm_drop_ref(region, slot);
+        detached = 1;
+    }
+    spin_unlock_irqrestore(&shm_lock, flags);
+    if (!detached) {
+        serial_puts("[SHM] WARNING: Process not attached to that region\n");
+    }
+    return detached;
+}
+
+//Processes attached to a region, 0 if it does not exist
+uint32_t shm_refcount(const char *name) {
+    uint32_t flags = spin_lock_irqsave(&shm_lock);
+    shm_region_t *region = shm_find(name);
+    uint32_t refs = region != NULL ? region->refs : 0;
+    spin_unlock_irqrestore(&shm_lock, flags);
+    return refs;
+}
+
+//Size of a region in bytes, 0 if it does not exist
+uint32_t shm_size(const char *name) {
+    uint32_t flags = spin_lock_irqsave(&shm_lock);
+    shm_region_t *region = shm_find(name);
+    uint32_t size = region != NULL ? region->size : 0;
+    spin_unlock_irqrestore(&shm_lock, flags);
+    return size;
+}
+
+/**
+ * Detach a terminated process from every region it used
+ * @param pid: Process that exited
+ */
+void shm_process_exit(uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    uint32_t i;
+    uint32_t slot;
+    uint32_t flags;
+    if (pcb == NULL || pid == 0) {
+        return;
+    }
+    slot = (uint32_t)(pcb - process_slot(0));
+    flags = spin_lock_irqsave(&shm_lock);
+    for (i = 0; i < SHM_MAX_REGIONS; i++) {
+        if (regions[i].address != 0 && shm_is_attached(&regions[i], slot)) {
+            shm_drop_ref(&regions[i], slot);
+        }
+    }
+    spin_unlock_irqrestore(&shm_lock, flags);
+}
+
+//Print every region with its attached processes
+void shm_print_status(void) {
+    uint32_t i, slot;
+    uint32_t flags = spin_lock_irqsave(&shm_lock);
+    serial_puts("\n=== Shared Memory ===\n");
+    serial_puts("Name             | Address    | Size     | Refs | Attached PIDs\n");
+    for (i = 0; i < SHM_MAX_REGIONS; i++) {
+        shm_region_t *region = &regions[i];
+        if (region->address == 0) {
+            continue;
+        }
+        kprintf("%-16s | 0x%08X | %8u | %4u |", region->name, region->address, region->size, region->refs);
+        for (slot = 1; slot < process_slot_count(); slot++) {
+            if (shm_is_attached(region, slot)) {
+                kprintf(" %u", process_slot(slot)->process_id);
+            }
+        }
+        serial_puts("\n");
+    }
+    spin_unlock_irqrestore(&shm_lock, flags);
+    serial_puts("\n");
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+/* shm.h - Named shared-memory regions */
+#ifndef SHM_H
+#define SHM_H
+
+#include "types.h"
+
+#define SHM_MAX_REGIONS     16
+#define SHM_NAME_LEN        16        /* Including the terminator */
+
+//Function declarations
+void shm_init(void);
+uint32_t shm_create(const char *name, uint32_t size, uint32_t pid);
+uint32_t shm_attach(const char *name, uint32_t pid);
+uint32_t shm_detach(uint32_t address, uint32_t pid);
+uint32_t shm_refcount(const char *name);
+uint32_t shm_size(const char *name);
+void shm_process_exit(uint32_t pid);
+void shm_print_status(void);
+#endif
\ No newline at end of file
@@ -0,0 +1,166 @@
+/* smp.c - Local APIC setup and application processor startup */
+#include "smp.h"
+#include "cpu.h"
+#include "io.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "spinlock.h"
+#include "string.h"
+#include "gdt.h"
+#include "syscall.h"
+
+#define LAPIC_REG_ID      0x020
+#define LAPIC_REG_SVR     0x0F0
+#define LAPIC_REG_ICR_LO  0x300
+#define LAPIC_REG_ICR_HI  0x310
+
+#define LAPIC_SVR_ENABLE         0x100
+#define LAPIC_ICR_PENDING        (1 << 12)
+#define LAPIC_ICR_ALL_BUT_SELF   (3 << 18)
+#define LAPIC_ICR_LEVEL_ASSERT   (1 << 14)
+#define LAPIC_ICR_INIT           (5 << 8)
+#define LAPIC_ICR_STARTUP        (6 << 8)
+
+/* Provided by ap_trampoline.S */
+extern uint8_t ap_trampoline_start[];
+extern uint8_t ap_trampoline_end[];
+
+/* Shared with ap_trampoline.S */
+uint8_t ap_stacks[SMP_MAX_CPUS][SMP_AP_STACK_SIZE] __attribute__((aligned(16)));
+volatile uint32_t ap_next_index = 1;
+const uint32_t smp_max_cpus = SMP_MAX_CPUS;
+
+static volatile uint32_t *lapic_base = NULL;
+static cpu_info_t cpus[SMP_MAX_CPUS];
+static atomic_t cpus_online = ATOMIC_INIT(1);
+static uint8_t apic_to_cpu[256];
+
+static uint32_t lapic_read(uint32_t reg) {
+    return lapic_base[reg / 4];
+}
+
+static void lapic_write(uint32_t reg, uint32_t value) {
+    lapic_base[reg / 4] = value;
+}
+
+static uint32_t lapic_id(void) {
+    return lapic_read(LAPIC_REG_ID) >> 24;
+}
+
+static void lapic_enable(void) {
+    lapic_write(LAPIC_REG_SVR, lapic_read(LAPIC_REG_SVR) | LAPIC_SVR_ENABLE | 0xFF);
+}
+
+/* Each write to the POST diagnostic port takes roughly a microsecond */
+static void smp_delay_us(uint32_t us) {
+    while (us--) {
+        outb(0x80, 0);
+    }
+}
+
+static void lapic_send_ipi(uint32_t icr) {
+    lapic_write(LAPIC_REG_ICR_HI, 0);
+    lapic_write(LAPIC_REG_ICR_LO, icr);
+    while (lapic_read(LAPIC_REG_ICR_LO) & LAPIC_ICR_PENDING) {
+        cpu_relax();
+    }
+}
+
+/**
+ * Entry point for application processors (called from ap_trampoline.S)
+ * @param cpu_index: Logical CPU index claimed by this AP
+ */
+void ap_main(uint32_t cpu_index) {
+    /* Swap the trampoline's GDT for the kernel's, with this CPU's TSS */
+    gdt_init_cpu(cpu_index);
+    syscall_init_cpu(cpu_index);
+    lapic_enable();
+    cpus[cpu_index].apic_id = lapic_id();
+    apic_to_cpu[cpus[cpu_index].apic_id] = (uint8_t)cpu_index;
+    cpus[cpu_index].online = 1;
+    atomic_inc(&cpus_online);
+
+    /* Idle loop: run this CPU's queue whenever the tick asks for a decision */
+    while (1) {
+        if (scheduler_need_resched()) {
+            scheduler_schedule();
+        }
+        cpu_relax();
+    }
+}
+
+/**
+ * Bring up all application processors
+ * Broadcasts INIT-SIPI-SIPI; APs that answer claim consecutive CPU indices.
+ */
+void smp_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t waited;
+
+    cpus[0].online = 1;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEAT_EDX_APIC)) {
+        serial_puts("[SMP] No local APIC, running on the boot CPU only\n");
+        return;
+    }
+    lapic_base = (volatile uint32_t *)(uint32_t)(rdmsr(MSR_IA32_APIC_BASE) & 0xFFFFF000);
+    lapic_enable();
+    cpus[0].apic_id = lapic_id();
+    apic_to_cpu[cpus[0].apic_id] = 0;
+
+    memcpy((void *)SMP_TRAMPOLINE_BASE, ap_trampoline_start,
+           (size_t)(ap_trampoline_end - ap_trampoline_start));
+
+    lapic_send_ipi(LAPIC_ICR_ALL_BUT_SELF | LAPIC_ICR_LEVEL_ASSERT | LAPIC_ICR_INIT);
+    smp_delay_us(10000);
+    lapic_send_ipi(LAPIC_ICR_ALL_BUT_SELF | LAPIC_ICR_STARTUP | (SMP_TRAMPOLINE_BASE >> 12));
+    smp_delay_us(200);
+    lapic_send_ipi(LAPIC_ICR_ALL_BUT_SELF | LAPIC_ICR_STARTUP | (SMP_TRAMPOLINE_BASE >> 12));
+
+    /* Give APs time to claim an index, then wait for each claimant to finish */
+    smp_delay_us(10000);
+    for (waited = 0; waited < 100; waited++) {
+        uint32_t claimed = ap_next_index < SMP_MAX_CPUS ? ap_next_index : SMP_MAX_CPUS;
+        if (atomic_read(&cpus_online) == claimed) {
+            break;
+        }
+        smp_delay_us(1000);
+    }
+
+    serial_puts("[SMP] ");
+    serial_put_dec(atomic_read(&cpus_online));
+    serial_puts(" CPU(s) online\n");
+}
+
+/**
+ * Get the logical index of the calling CPU
+ * @return: 0 for the boot CPU (or before smp_init), 1.. for APs
+ */
+uint32_t smp_cpu_id(void) {
+    if (lapic_base == NULL) {
+        return 0;
+    }
+    return apic_to_cpu[lapic_id()];
+}
+
+//Number of CPUs that completed bring-up
+uint32_t smp_cpu_count(void) {
+    return atomic_read(&cpus_online);
+}
+
+//Print per-CPU APIC information
+void smp_print_status(void) {
+    uint32_t i;
+    serial_puts("\n=== CPUs ===\n");
+    for (i = 0; i < SMP_MAX_CPUS; i++) {
+        if (!cpus[i].online) {
+            continue;
+        }
+        serial_puts("CPU ");
+        serial_put_dec(i);
+        serial_puts(": APIC ID ");
+        serial_put_dec(cpus[i].apic_id);
+        serial_puts(i == 0 ? " (boot)\n" : "\n");
+    }
+    serial_puts("\n");
+}
@@ -0,0 +1,22 @@
+/* smp.h - Symmetric multiprocessing bring-up for kacchiOS */
+#ifndef SMP_H
+#define SMP_H
+
+#include "types.h"
+
+#define SMP_MAX_CPUS          8
+#define SMP_AP_STACK_SIZE     4096      /* Must match AP_STACK_SHIFT in ap_trampoline.S */
+#define SMP_TRAMPOLINE_BASE   0x8000    /* Must match AP_TRAMPOLINE_BASE in ap_trampoline.S */
+
+//Per-CPU bookkeeping
+typedef struct {
+    uint32_t apic_id;
+    uint32_t online;
+} cpu_info_t;
+
+//Function declarations
+void smp_init(void);
+uint32_t smp_cpu_id(void);
+uint32_t smp_cpu_count(void);
+void smp_print_status(void);
+#endif
@@ -0,0 +1,196 @@
+/* spinlock.c - Ticket spinlocks, IRQ-safe locking and lock-free queues */
+#include "spinlock.h"
+#include "cpu.h"
+#include "math64.h"
+#include "serial.h"
+#include "kprintf.h"
+#include "clock.h"
+#include "latency.h"
+
+static spinlock_t *tracked_locks[SPINLOCK_MAX_TRACKED];
+static atomic_t tracked_count = ATOMIC_INIT(0);
+
+/* Make a lock visible to spinlock_print_stats() the first time it is taken */
+static void spinlock_track(spinlock_t *lock) {
+    uint32_t slot;
+    if (lock->registered || !__sync_bool_compare_and_swap(&lock->registered, 0, 1)) {
+        return;
+    }
+    slot = atomic_inc(&tracked_count) - 1;
+    if (slot < SPINLOCK_MAX_TRACKED) {
+        tracked_locks[slot] = lock;
+    }
+}
+
+/* Bookkeeping done by the new owner once the lock is held */
+static void spinlock_acquired(spinlock_t *lock, uint32_t contended) {
+    spinlock_track(lock);
+    lock->acquisitions++;
+    if (contended) {
+        lock->contentions++;
+    }
+    lock->acquired_at = rdtsc();
+}
+
+/**
+ * Initialize a lock at run time
+ * @param lock: Lock to initialize
+ * @param name: Name shown in lock statistics
+ */
+void spin_lock_init(spinlock_t *lock, const char *name) {
+    lock->next_ticket = 0;
+    lock->now_serving = 0;
+    lock->name = name;
+    lock->registered = 0;
+    lock->acquisitions = 0;
+    lock->contentions = 0;
+    lock->hold_max = 0;
+    lock->hold_total = 0;
+    lock->acquired_at = 0;
+}
+
+/**
+ * Acquire a lock, spinning in FIFO order behind earlier waiters
+ * @param lock: Lock to acquire
+ */
+void spin_lock(spinlock_t *lock) {
+    uint32_t ticket = __sync_fetch_and_add(&lock->next_ticket, 1);
+    uint32_t contended = 0;
+    while (lock->now_serving != ticket) {
+        contended = 1;
+        cpu_relax();
+    }
+    spinlock_acquired(lock, contended);
+}
+
+/**
+ * Acquire a lock only if it is free
+ * @param lock: Lock to acquire
+ * @return: 1 if acquired, 0 if it was held
+ */
+uint32_t spin_trylock(spinlock_t *lock) {
+    uint32_t ticket = lock->now_serving;
+    if (lock->next_ticket != ticket ||
+        !__sync_bool_compare_and_swap(&lock->next_ticket, ticket, ticket + 1)) {
+        return 0;
+    }
+    spinlock_acquired(lock, 0);
+    return 1;
+}
+
+/**
+ * Release a lock and hand it to the next waiter
+ * @param lock: Lock held by the caller
+ */
+void spin_unlock(spinlock_t *lock) {
+    uint64_t held = rdtsc() - lock->acquired_at;
+    uint32_t held32 = (held >> 32) ? 0xFFFFFFFF : (uint32_t)held;
+    if (held32 > lock->hold_max) {
+        lock->hold_max = held32;
+    }
+    lock->hold_total += held;
+    __asm__ volatile ("" : : : "memory");
+    lock->now_serving = lock->now_serving + 1;
+}
+
+/**
+ * Disable interrupts on this CPU, then acquire a lock
+ * Use for state that interrupt handlers also touch.
+ * @param lock: Lock to acquire
+ * @return: Saved EFLAGS to pass to spin_unlock_irqrestore()
+ */
+uint32_t spin_lock_irqsave(spinlock_t *lock) {
+    uint32_t flags = cpu_save_flags();
+    cpu_irq_disable();
+    if (flags & EFLAGS_IF) {
+        latency_irqs_off(LATENCY_CALLER());
+    }
+    spin_lock(lock);
+    return flags;
+}
+
+/**
+ * Release a lock and restore the interrupt state saved at acquisition
+ * @param lock: Lock held by the caller
+ * @param flags: Value returned by spin_lock_irqsave()
+ */
+void spin_unlock_irqrestore(spinlock_t *lock, uint32_t flags) {
+    spin_unlock(lock);
+    if (flags & EFLAGS_IF) {
+        latency_irqs_on(LATENCY_CALLER());
+        cpu_irq_enable();
+    }
+}
+
+//Print per-lock acquisition, contention and hold-time statistics
+void spinlock_print_stats(void) {
+    uint32_t i;
+    uint32_t count = atomic_read(&tracked_count);
+    if (count > SPINLOCK_MAX_TRACKED) {
+        count = SPINLOCK_MAX_TRACKED;
+    }
+    serial_puts("\n=== Lock Statistics ===\n");
+    serial_puts("Lock         | Acquired | Contended | Avg Hold | Max Hold (ns)\n");
+    serial_puts("----------------------------------------------------------------\n");
+    for (i = 0; i < count; i++) {
+        spinlock_t *lock = tracked_locks[i];
+        kprintf("%-12s | %8u | %9u | %8u | %u\n", lock->name, lock->acquisitions, lock->contentions,
+                lock->acquisitions ? (uint32_t)clock_cycles_to_ns(udiv64(lock->hold_total, lock->acquisitions)) : 0,
+                (uint32_t)clock_cycles_to_ns(lock->hold_max));
+    }
+    serial_puts("----------------------------------------------------------------\n\n");
+}
+
+/**
+ * Initialize an empty MPSC queue
+ * @param queue: Queue to initialize
+ */
+void mpsc_init(mpsc_queue_t *queue) {
+    queue->stub.next = NULL;
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+}
+
+/**
+ * Append a node; safe from any number of CPUs and from interrupt handlers
+ * @param queue: Target queue
+ * @param node: Node embedded in the caller's structure
+ */
+void mpsc_push(mpsc_queue_t *queue, mpsc_node_t *node) {
+    mpsc_node_t *prev;
+    node->next = NULL;
+    prev = __sync_lock_test_and_set(&queue->head, node);
+    prev->next = node;
+}
+
+/**
+ * Remove the oldest node; must only be called by the single consumer
+ * @param queue: Source queue
+ * @return: Oldest node, or NULL if empty (or a producer is mid-push)
+ */
+mpsc_node_t* mpsc_pop(mpsc_queue_t *queue) {
+    mpsc_node_t *tail = queue->tail;
+    mpsc_node_t *next = tail->next;
+    if (tail == &queue->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = next->next;
+    }
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    if (tail != queue->head) {
+        return NULL;
+    }
+    mpsc_push(queue, &queue->stub);
+    next = tail->next;
+    if (next != NULL) {
+        queue->tail = next;
+        return tail;
+    }
+    return NULL;
+}
@@ -0,0 +1,86 @@
+/* spinlock.h - Kernel synchronization primitives */
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include "types.h"
+
+#define SPINLOCK_MAX_TRACKED  32
+
+//Atomic counter
+typedef struct {
+    volatile uint32_t value;
+} atomic_t;
+
+#define ATOMIC_INIT(v) { (v) }
+
+static inline uint32_t atomic_read(const atomic_t *a) {
+    return a->value;
+}
+
+static inline void atomic_set(atomic_t *a, uint32_t v) {
+    a->value = v;
+}
+
+static inline uint32_t atomic_add_return(atomic_t *a, uint32_t v) {
+    return __sync_add_and_fetch(&a->value, v);
+}
+
+static inline uint32_t atomic_sub_return(atomic_t *a, uint32_t v) {
+    return __sync_sub_and_fetch(&a->value, v);
+}
+
+static inline uint32_t atomic_inc(atomic_t *a) {
+    return atomic_add_return(a, 1);
+}
+
+static inline uint32_t atomic_dec(atomic_t *a) {
+    return atomic_sub_return(a, 1);
+}
+
+/* Returns 1 and stores new_value if *a == expected, 0 otherwise */
+static inline uint32_t atomic_cmpxchg(atomic_t *a, uint32_t expected, uint32_t new_value) {
+    return __sync_bool_compare_and_swap(&a->value, expected, new_value);
+}
+
+//Ticket spinlock: FIFO handoff, with hold/contention statistics
+typedef struct {
+    volatile uint32_t next_ticket;
+    volatile uint32_t now_serving;
+    const char *name;
+    uint32_t registered;
+    uint32_t acquisitions;
+    uint32_t contentions;         /* Acquisitions that had to wait */
+    uint32_t hold_max;            /* Longest hold, in TSC cycles */
+    uint64_t hold_total;
+    uint64_t acquired_at;
+} spinlock_t;
+
+#define SPINLOCK_INIT(lock_name) { 0, 0, (lock_name), 0, 0, 0, 0, 0, 0 }
+
+//Intrusive multi-producer/single-consumer queue (lock-free push and pop)
+typedef struct mpsc_node {
+    struct mpsc_node *volatile next;
+} mpsc_node_t;
+
+typedef struct {
+    mpsc_node_t *volatile head;   /* Producers swap themselves in here */
+    mpsc_node_t *tail;            /* Owned by the single consumer */
+    mpsc_node_t stub;
+} mpsc_queue_t;
+
+/* Recover the enclosing structure from an embedded member */
+#define container_of(ptr, type, member) \
+    ((type *)((uint8_t *)(ptr) - __builtin_offsetof(type, member)))
+
+//Function declarations
+void spin_lock_init(spinlock_t *lock, const char *name);
+void spin_lock(spinlock_t *lock);
+uint32_t spin_trylock(spinlock_t *lock);
+void spin_unlock(spinlock_t *lock);
+uint32_t spin_lock_irqsave(spinlock_t *lock);
+void spin_unlock_irqrestore(spinlock_t *lock, uint32_t flags);
+void spinlock_print_stats(void);
+void mpsc_init(mpsc_queue_t *queue);
+void mpsc_push(mpsc_queue_t *queue, mpsc_node_t *node);
+mpsc_node_t* mpsc_pop(mpsc_queue_t *queue);
+#endif
@@ -21,4 +21,21 @@ char* strcpy(char* dest, const char* src) {
     char* original_dest = dest;
     while ((*dest++ = *src++));
     return original_dest;
+}
+
+void* memset(void* dest, int value, size_t count) {
+    uint8_t* d = (uint8_t*)dest;
+    while (count--) {
+        *d++ = (uint8_t)value;
+    }
+    return dest;
+}
+
+void* memcpy(void* dest, const void* src, size_t count) {
+    uint8_t* d = (uint8_t*)dest;
+    const uint8_t* s = (const uint8_t*)src;
+    while (count--) {
+        *d++ = *s++;
+    }
+    return dest;
 }
\ No newline at end of file
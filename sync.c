@@ -0,0 +1,644 @@
+/* sync.c - Sleeping mutexes, semaphores and condition variables
+ *
+ * Unlike spinlocks these block the waiting process through the scheduler, so
+ * they are what a process uses to wait for a resource. Every object keeps
+ * its waiters on a queue threaded through per-process records (a process
+ * waits on at most one thing at a time), and a release hands the object
+ * straight to the highest-priority waiter (lowest priority value, FIFO among
+ * equals), so a woken process never has to retry.
+ *
+ * Mutexes use priority inheritance: a process that blocks on a mutex lends
+ * its priority to the owner, and on down the chain if that owner is itself
+ * blocked on a mutex, for up to SYNC_PI_DEPTH owners. An owner drops back to
+ * the highest priority still justified by its remaining waiters when it
+ * unlocks. A condition variable wait releases its mutex, and a signal moves
+ * the waiter onto the mutex's queue rather than waking it just to block again.
+ */
+#include "sync.h"
+#include "process.h"
+#include "scheduler.h"
+#include "spinlock.h"
+#include "serial.h"
+#include "string.h"
+#include "kprintf.h"
+
+//What one process is waiting on, and what it owns
+typedef struct {
+    uint32_t next;                    /* Next waiter on the same queue, slot + 1 */
+    uint32_t *queue;                  /* Queue we wait on, NULL if none */
+    sync_stats_t *waiting_on;         /* Object the wait is charged to */
+    mutex_t *blocked_on;              /* Mutex whose owner inherits our priority */
+    mutex_t *cond_mutex;              /* Condvar wait: mutex taken back when signalled */
+    uint32_t since;                   /* Tick the wait began */
+    uint32_t boosted;                 /* Running on an inherited priority */
+    mutex_t *held;                    /* Mutexes owned, newest first */
+} sync_task_t;
+
+static const char *sync_kind_names[] = { "mutex", "sem", "condvar" };
+static sync_task_t sync_tasks[MAX_PROCESSES];
+static sync_stats_t *tracked_objects[SYNC_MAX_TRACKED];
+static uint32_t tracked_count = 0;
+/* Taken before the scheduler lock, never inside it */
+static spinlock_t sync_lock = SPINLOCK_INIT("sync");
+
+static uint32_t sync_slot(process_control_block_t *pcb) {
+    return (uint32_t)(pcb - process_slot(0));
+}
+
+static sync_task_t *sync_task(process_control_block_t *pcb) {
+    return &sync_tasks[sync_slot(pcb)];
+}
+
+/* Live, non-null process or NULL */
+static process_control_block_t *sync_pcb(uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    if (pid == 0 || pcb == NULL || pcb->state == TERMINATED) {
+        return NULL;
+    }
+    return pcb;
+}
+
+static uint32_t sync_can_block(process_control_block_t *pcb) {
+    return pcb->sched_class == SCHED_CLASS_NORMAL && (pcb->state == READY || pcb->state == CURRENT);
+}
+
+/* List an object in sync_print_stats() the first time it is used */
+static void sync_track(sync_stats_t *stats) {
+    uint32_t i;
+    if (stats->registered) {
+        return;
+    }
+    stats->registered = 1;
+    /* Re-initialized objects are already listed */
+    for (i = 0; i < tracked_count; i++) {
+        if (tracked_objects[i] == stats) {
+            return;
+        }
+    }
+    if (tracked_count < SYNC_MAX_TRACKED) {
+        tracked_objects[tracked_count++] = stats;
+    }
+}
+
+/* Drop a destroyed object from sync_print_stats(); caller holds sync_lock */
+static void sync_untrack(sync_stats_t *stats) {
+    uint32_t i;
+    for (i = 0; i < tracked_count; i++) {
+        if (tracked_objects[i] == stats) {
+            break;
+        }
+    }
+    if (i == tracked_count) {
+        return;
+    }
+    tracked_count--;
+    for (; i < tracked_count; i++) {
+        tracked_objects[i] = tracked_objects[i + 1];
+    }
+    stats->registered = 0;
+}
+
+static void sync_stats_init(sync_stats_t *stats, const char *name, sync_kind_t kind) {
+    memset(stats, 0, sizeof(*stats));
+    stats->name = name;
+    stats->kind = kind;
+}
+
+/* Append a process to a wait queue and start its wait clock */
+static void sync_enqueue(process_control_block_t *pcb, uint32_t *queue, sync_stats_t *stats) {
+    sync_task_t *task = sync_task(pcb);
+    uint32_t slot = sync_slot(pcb) + 1;
+    task->next = 0;
+    task->queue = queue;
+    task->waiting_on = stats;
+    task->since = scheduler_get_time();
+    stats->contentions++;
+    while (*queue != 0) {
+        queue = &sync_tasks[*queue - 1].next;
+    }
+    *queue = slot;
+}
+
+/* Unlink a waiter from its queue and charge the wait to the object */
+static void sync_dequeue(process_control_block_t *pcb) {
+    sync_task_t *task = sync_task(pcb);
+    uint32_t slot = sync_slot(pcb) + 1;
+    uint32_t *link = task->queue;
+    uint32_t waited = scheduler_get_time() - task->since;
+    while (*link != 0 && *link != slot) {
+        link = &sync_tasks[*link - 1].next;
+    }
+    if (*link == slot) {
+        *link = task->next;
+    }
+    task->next = 0;
+    task->queue = NULL;
+    task->waiting_on->wait_total += waited;
+    if (waited > task->waiting_on->wait_max) {
+        task->waiting_on->wait_max = waited;
+    }
+    task->waiting_on = NULL;
+}
+
+/* Highest-priority waiter on a queue, first come among equals; NULL if empty */
+static process_control_block_t *sync_best_waiter(uint32_t queue) {
+    process_control_block_t *best = NULL;
+    while (queue != 0) {
+        process_control_block_t *pcb = process_slot(queue - 1);
+        if (best == NULL || pcb->priority < best->priority) {
+            best = pcb;
+        }
+        queue = sync_tasks[queue - 1].next;
+    }
+    return best;
+}
+
+/* Priority a mutex's waiters lend its owner; ~0 if none */
+static uint32_t mutex_waiter_priority(mutex_t *mutex) {
+    process_control_block_t *best = sync_best_waiter(mutex->waiters);
+    return best != NULL ? best->priority : ~0U;
+}
+
+/* Raise a mutex's owner, and the owners it waits behind, to at least priority */
+static void sync_boost(mutex_t *mutex, uint32_t priority) {
+    uint32_t depth;
+    for (depth = 0; mutex != NULL && depth < SYNC_PI_DEPTH; depth++) {
+        process_control_block_t *owner = process_get_pcb(mutex->owner);
+        sync_task_t *task;
+        if (owner == NULL || owner->priority <= priority) {
+            return;
+        }
+        task = sync_task(owner);
+        task->boosted = 1;
+        owner->priority = priority;
+        mutex->stats.boosts++;
+        mutex = task->blocked_on;
+    }
+}
+
+/* Drop inheritance a process no longer needs, then recheck the owner it waits on */
+static void sync_unboost(process_control_block_t *pcb) {
+    uint32_t depth;
+    for (depth = 0; pcb != NULL && depth < SYNC_PI_DEPTH; depth++) {
+        sync_task_t *task = sync_task(pcb);
+        uint32_t priority;
+        mutex_t *held;
+        if (!task->boosted) {
+            return;
+        }
+        priority = pcb->base_priority;
+        for (held = task->held; held != NULL; held = held->next_held) {
+            uint32_t lent = mutex_waiter_priority(held);
+            if (lent < priority) {
+                priority = lent;
+            }
+        }
+        pcb->priority = priority;
+        task->boosted = priority != pcb->base_priority;
+        pcb = task->blocked_on != NULL ? process_get_pcb(task->blocked_on->owner) : NULL;
+    }
+}
+
+static void mutex_take(mutex_t *mutex, process_control_block_t *pcb) {
+    sync_task_t *task = sync_task(pcb);
+    mutex->owner = pcb->process_id;
+    mutex->next_held = task->held;
+    task->held = mutex;
+    mutex->stats.acquisitions++;
+}
+
+/* Give a waiter a mutex it queued for and let it run; caller holds sync_lock */
+static void mutex_grant(mutex_t *mutex, process_control_block_t *waiter) {
+    sync_dequeue(waiter);
+    sync_task(waiter)->blocked_on = NULL;
+    mutex_take(mutex, waiter);
+    /* Whoever still waits now lends its priority to the new owner */
+    if (mutex->waiters != 0) {
+        sync_boost(mutex, mutex_waiter_priority(mutex));
+    }
+    scheduler_wake(waiter->process_id);
+}
+
+/* Release a mutex, handing it to the best waiter; caller holds sync_lock */
+static void mutex_release(mutex_t *mutex, process_control_block_t *owner) {
+    mutex_t **link = &sync_task(owner)->held;
+    process_control_block_t *waiter;
+    while (*link != NULL && *link != mutex) {
+        link = &(*link)->next_held;
+    }
+    if (*link == mutex) {
+        *link = mutex->next_held;
+    }
+    mutex->next_held = NULL;
+    mutex->owner = 0;
+    waiter = sync_best_waiter(mutex->waiters);
+    if (waiter != NULL) {
+        mutex_grant(mutex, waiter);
+    }
+    sync_unboost(owner);
+}
+
+//Forget every process's waits and holdings; the process table has been emptied
+void sync_init(void) {
+    uint32_t flags = spin_lock_irqsave(&sync_lock);
+    memset(sync_tasks, 0, sizeof(sync_tasks));
+    spin_unlock_irqrestore(&sync_lock, flags);
+}
+
+/**
+ * Initialize a mutex
+ * One that does not live in static storage must be passed to mutex_destroy()
+ * before its memory is reused, since sync_print_stats() keeps a pointer to it.
+ * @param mutex: Mutex to initialize
+ * @param name: Name shown in sync_print_stats()
+ */
+void mutex_init(mutex_t *mutex, const char *name) {
+    mutex->owner = 0;
+    mutex->waiters = 0;
+    mutex->next_held = NULL;
+    sync_stats_init(&mutex->stats, name, SYNC_MUTEX);
+}
+
+/**
+ * Retire a mutex so its memory can be reused
+ * @param mutex: Mutex that nobody holds, waits on or will retake after a condvar wait
+ * @return: 1 if destroyed, 0 if it is still in use
+ */
+uint32_t mutex_destroy(mutex_t *mutex) {
+    uint32_t in_use;
+    uint32_t i;
+    uint32_t flags = spin_lock_irqsave(&sync_lock);
+    in_use = mutex->owner != 0 || mutex->waiters != 0;
+    for (i = 0; i < MAX_PROCESSES && !in_use; i++) {
+        in_use = sync_tasks[i].cond_mutex == mutex;
+    }
+    if (!in_use) {
+        sync_untrack(&mutex->stats);
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    if (in_use) {
+        serial_puts("[SYNC] ERROR: Cannot destroy a mutex that is in use\n");
+    }
+    return !in_use;
+}
+
+/**
+ * Lock a mutex, blocking while another process holds it
+ * A blocked caller lends its priority to the owner until it gets the mutex.
+ * @param mutex: Mutex to lock
+ * @param pid: Process taking it
+ * @return: SYNC_OK if taken, SYNC_BLOCKED if the caller waits (it owns the
+ *          mutex once woken), SYNC_ERROR if it already holds it or cannot block
+ */
+sync_status_t mutex_lock(mutex_t *mutex, uint32_t pid) {
+    process_control_block_t *pcb = sync_pcb(pid);
+    sync_status_t status = SYNC_ERROR;
+    const char *error = NULL;
+    uint32_t flags;
+    if (pcb == NULL) {
+        serial_puts("[SYNC] ERROR: Invalid process\n");
+        return SYNC_ERROR;
+    }
+    flags = spin_lock_irqsave(&sync_lock);
+    sync_track(&mutex->stats);
+    if (mutex->owner == 0) {
+        mutex_take(mutex, pcb);
+        status = SYNC_OK;
+    }
+    else if (mutex->owner == pid) {
+        error = "[SYNC] ERROR: Mutex already held by this process\n";
+    }
+    else if (!sync_can_block(pcb)) {
+        error = "[SYNC] ERROR: Process cannot block\n";
+    }
+    else {
+        sync_enqueue(pcb, &mutex->waiters, &mutex->stats);
+        sync_task(pcb)->blocked_on = mutex;
+        sync_boost(mutex, pcb->priority);
+        scheduler_block(pid);
+        status = SYNC_BLOCKED;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    if (error != NULL) {
+        serial_puts(error);
+    }
+    return status;
+}
+
+/**
+ * Lock a mutex only if it is free
+ * @param mutex: Mutex to lock
+ * @param pid: Process taking it
+ * @return: 1 if taken, 0 otherwise
+ */
+uint32_t mutex_trylock(mutex_t *mutex, uint32_t pid) {
+    process_control_block_t *pcb = sync_pcb(pid);
+    uint32_t taken = 0;
+    uint32_t flags;
+    if (pcb == NULL) {
+        return 0;
+    }
+    flags = spin_lock_irqsave(&sync_lock);
+    sync_track(&mutex->stats);
+    if (mutex->owner == 0) {
+        mutex_take(mutex, pcb);
+        taken = 1;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    return taken;
+}
+
+/**
+ * Unlock a mutex; the highest-priority waiter becomes the owner
+ * The caller gives up any priority it inherited through this mutex.
+ * @param mutex: Mutex to unlock
+ * @param pid: Current owner
+ * @return: 1 if unlocked, 0 if pid does not hold it
+ */
+uint32_t mutex_unlock(mutex_t *mutex, uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    uint32_t unlocked = 0;
+    uint32_t flags;
+    if (pcb == NULL || pid == 0) {
+        serial_puts("[SYNC] ERROR: Unlock of a mutex not held by this process\n");
+        return 0;
+    }
+    flags = spin_lock_irqsave(&sync_lock);
+    if (mutex->owner == pid) {
+        mutex_release(mutex, pcb);
+        unlocked = 1;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    if (!unlocked) {
+        serial_puts("[SYNC] ERROR: Unlock of a mutex not held by this process\n");
+    }
+    return unlocked;
+}
+
+/**
+ * Initialize a counting semaphore
+ * One that does not live in static storage must be passed to sem_destroy()
+ * before its memory is reused.
+ * @param sem: Semaphore to initialize
+ * @param name: Name shown in sync_print_stats()
+ * @param count: Units initially available
+ */
+void sem_init(semaphore_t *sem, const char *name, uint32_t count) {
+    sem->count = count;
+    sem->waiters = 0;
+    sync_stats_init(&sem->stats, name, SYNC_SEMAPHORE);
+}
+
+/**
+ * Retire a semaphore so its memory can be reused
+ * @param sem: Semaphore with no waiters
+ * @return: 1 if destroyed, 0 if a process still waits on it
+ */
+uint32_t sem_destroy(semaphore_t *sem) {
+    uint32_t destroyed = 0;
+    uint32_t flags = spin_lock_irqsave(&sync_lock);
+    if (sem->waiters == 0) {
+        sync_untrack(&sem->stats);
+        destroyed = 1;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    if (!destroyed) {
+        serial_puts("[SYNC] ERROR: Cannot destroy a semaphore that is waited on\n");
+    }
+    return destroyed;
+}
+
+/**
+ * Take one unit, blocking while none are available
+ * @param sem: Semaphore
+ * @param pid: Process taking the unit
+ * @return: SYNC_OK if taken, SYNC_BLOCKED if the caller waits (it has the
+ *          unit once woken), SYNC_ERROR if it cannot block
+ */
+sync_status_t sem_wait(semaphore_t *sem, uint32_t pid) {
+    process_control_block_t *pcb = sync_pcb(pid);
+    sync_status_t status = SYNC_ERROR;
+    uint32_t flags;
+    if (pcb == NULL) {
+        serial_puts("[SYNC] ERROR: Invalid process\n");
+        return SYNC_ERROR;
+    }
+    flags = spin_lock_irqsave(&sync_lock);
+    sync_track(&sem->stats);
+    if (sem->count > 0) {
+        sem->count--;
+        sem->stats.acquisitions++;
+        status = SYNC_OK;
+    }
+    else if (sync_can_block(pcb)) {
+        sync_enqueue(pcb, &sem->waiters, &sem->stats);
+        scheduler_block(pid);
+        status = SYNC_BLOCKED;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    if (status == SYNC_ERROR) {
+        serial_puts("[SYNC] ERROR: Process cannot block\n");
+    }
+    return status;
+}
+
+/**
+ * Take one unit only if one is available
+ * @param sem: Semaphore
+ * @return: 1 if taken, 0 otherwise
+ */
+uint32_t sem_trywait(semaphore_t *sem) {
+    uint32_t taken = 0;
+    uint32_t flags = spin_lock_irqsave(&sync_lock);
+    sync_track(&sem->stats);
+    if (sem->count > 0) {
+        sem->count--;
+        sem->stats.acquisitions++;
+        taken = 1;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    return taken;
+}
+
+/**
+ * Release one unit; it goes straight to the highest-priority waiter, if any
+ * @param sem: Semaphore
+ */
+void sem_post(semaphore_t *sem) {
+    process_control_block_t *waiter;
+    uint32_t flags = spin_lock_irqsave(&sync_lock);
+    sync_track(&sem->stats);
+    waiter = sync_best_waiter(sem->waiters);
+    if (waiter != NULL) {
+        sync_dequeue(waiter);
+        sem->stats.acquisitions++;
+        scheduler_wake(waiter->process_id);
+    }
+    else {
+        sem->count++;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+}
+
+/**
+ * Initialize a condition variable
+ * One that does not live in static storage must be passed to cond_destroy()
+ * before its memory is reused.
+ * @param cond: Condition variable to initialize
+ * @param name: Name shown in sync_print_stats()
+ */
+void cond_init(condvar_t *cond, const char *name) {
+    cond->waiters = 0;
+    sync_stats_init(&cond->stats, name, SYNC_CONDVAR);
+}
+
+/**
+ * Retire a condition variable so its memory can be reused
+ * @param cond: Condition variable with no waiters
+ * @return: 1 if destroyed, 0 if a process still waits on it
+ */
+uint32_t cond_destroy(condvar_t *cond) {
+    uint32_t destroyed = 0;
+    uint32_t flags = spin_lock_irqsave(&sync_lock);
+    if (cond->waiters == 0) {
+        sync_untrack(&cond->stats);
+        destroyed = 1;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    if (!destroyed) {
+        serial_puts("[SYNC] ERROR: Cannot destroy a condition variable that is waited on\n");
+    }
+    return destroyed;
+}
+
+/**
+ * Release a mutex and wait on a condition variable, atomically
+ * The caller always blocks, and holds the mutex again once woken.
+ * @param cond: Condition variable
+ * @param mutex: Mutex held by the caller
+ * @param pid: Waiting process
+ * @return: SYNC_BLOCKED, or SYNC_ERROR if it does not hold the mutex or cannot block
+ */
+sync_status_t cond_wait(condvar_t *cond, mutex_t *mutex, uint32_t pid) {
+    process_control_block_t *pcb = sync_pcb(pid);
+    sync_status_t status = SYNC_ERROR;
+    uint32_t flags;
+    if (pcb == NULL) {
+        serial_puts("[SYNC] ERROR: Invalid process\n");
+        return SYNC_ERROR;
+    }
+    flags = spin_lock_irqsave(&sync_lock);
+    sync_track(&cond->stats);
+    if (mutex->owner == pid && sync_can_block(pcb)) {
+        sync_enqueue(pcb, &cond->waiters, &cond->stats);
+        sync_task(pcb)->cond_mutex = mutex;
+        mutex_release(mutex, pcb);
+        scheduler_block(pid);
+        status = SYNC_BLOCKED;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    if (status == SYNC_ERROR) {
+        serial_puts("[SYNC] ERROR: Condition wait needs the mutex and a process that can block\n");
+    }
+    return status;
+}
+
+/* Move the best condvar waiter to its mutex; caller holds sync_lock */
+static uint32_t cond_wake_one(condvar_t *cond) {
+    process_control_block_t *waiter = sync_best_waiter(cond->waiters);
+    sync_task_t *task;
+    mutex_t *mutex;
+    if (waiter == NULL) {
+        return 0;
+    }
+    task = sync_task(waiter);
+    mutex = task->cond_mutex;
+    task->cond_mutex = NULL;
+    sync_dequeue(waiter);
+    cond->stats.acquisitions++;
+    if (mutex->owner == 0) {
+        mutex_take(mutex, waiter);
+        scheduler_wake(waiter->process_id);
+    }
+    else {
+        /* Wait morphing: stay blocked, now on the mutex */
+        sync_enqueue(waiter, &mutex->waiters, &mutex->stats);
+        task->blocked_on = mutex;
+        sync_boost(mutex, waiter->priority);
+    }
+    return 1;
+}
+
+/**
+ * Wake the highest-priority waiter of a condition variable
+ * @param cond: Condition variable
+ * @return: 1 if a waiter was woken, 0 if there was none
+ */
+uint32_t cond_signal(condvar_t *cond) {
+    uint32_t woken;
+    uint32_t flags = spin_lock_irqsave(&sync_lock);
+    woken = cond_wake_one(cond);
+    spin_unlock_irqrestore(&sync_lock, flags);
+    return woken;
+}
+
+/**
+ * Wake every waiter of a condition variable
+ * @param cond: Condition variable
+ * @return: Number of waiters woken
+ */
+uint32_t cond_broadcast(condvar_t *cond) {
+    uint32_t woken = 0;
+    uint32_t flags = spin_lock_irqsave(&sync_lock);
+    while (cond_wake_one(cond)) {
+        woken++;
+    }
+    spin_unlock_irqrestore(&sync_lock, flags);
+    return woken;
+}
+
+/**
+ * Drop a terminated process from every wait queue and release its mutexes
+ * Each mutex it held passes to that mutex's best waiter.
+ * @param pid: Process that exited
+ */
+void sync_process_exit(uint32_t pid) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    sync_task_t *task;
+    uint32_t flags;
+    if (pcb == NULL || pid == 0) {
+        return;
+    }
+    flags = spin_lock_irqsave(&sync_lock);
+    task = sync_task(pcb);
+    if (task->queue != NULL) {
+        mutex_t *blocked_on = task->blocked_on;
+        sync_dequeue(pcb);
+        task->blocked_on = NULL;
+        /* The owner no longer owes us our priority */
+        if (blocked_on != NULL) {
+            sync_unboost(process_get_pcb(blocked_on->owner));
+        }
+    }
+    while (task->held != NULL) {
+        mutex_release(task->held, pcb);
+    }
+    memset(task, 0, sizeof(*task));
+    spin_unlock_irqrestore(&sync_lock, flags);
+}
+
+//Print contention statistics for every mutex, semaphore and condvar used so far
+void sync_print_stats(void) {
+    uint32_t i;
+    serial_puts("\n=== Sleeping Locks ===\n");
+    serial_puts("Name         | Kind    | Acquired | Contended | Avg Wait | Max Wait (ticks) | Boosts\n");
+    serial_puts("--------------------------------------------------------------------------------\n");
+    for (i = 0; i < tracked_count; i++) {
+        sync_stats_t *stats = tracked_objects[i];
+        kprintf("%-12s | %-7s | %8u | %9u | %8u | %16u | %u\n", stats->name,
+                sync_kind_names[stats->kind], stats->acquisitions, stats->contentions,
+                stats->contentions ? stats->wait_total / stats->contentions : 0,
+                stats->wait_max, stats->boosts);
+    }
+    serial_puts("\n");
+}
\ No newline at end of file
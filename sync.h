@@ -0,0 +1,75 @@
+/* sync.h - Sleeping mutexes, semaphores and condition variables */
+#ifndef SYNC_H
+#define SYNC_H
+
+#include "types.h"
+
+#define SYNC_MAX_TRACKED    32        /* Objects listed by sync_print_stats(); *_destroy() drops one */
+#define SYNC_PI_DEPTH       8         /* Owner chain length priority inheritance follows */
+
+//Outcome of an acquire
+typedef enum {
+    SYNC_OK = 0,                      /* Acquired now */
+    SYNC_BLOCKED = 1,                 /* Caller blocked; it holds the object once woken */
+    SYNC_ERROR = 2
+} sync_status_t;
+
+typedef enum {
+    SYNC_MUTEX = 0,
+    SYNC_SEMAPHORE = 1,
+    SYNC_CONDVAR = 2
+} sync_kind_t;
+
+//Contention statistics, common to every kind
+typedef struct {
+    const char *name;
+    sync_kind_t kind;
+    uint32_t registered;
+    uint32_t acquisitions;            /* Mutex locks, semaphore downs, condvar wakeups */
+    uint32_t contentions;             /* Of those, how many had to block */
+    uint32_t wait_total;              /* Ticks spent blocked */
+    uint32_t wait_max;
+    uint32_t boosts;                  /* Mutex: owner priority raised by a waiter */
+} sync_stats_t;
+
+//Sleeping mutex with priority inheritance; waiters get it in priority order
+typedef struct sync_mutex {
+    uint32_t owner;                   /* PID, 0 while free */
+    uint32_t waiters;                 /* Wait queue, as table slot + 1 */
+    struct sync_mutex *next_held;     /* Owner's list of held mutexes */
+    sync_stats_t stats;
+} mutex_t;
+
+//Counting semaphore
+typedef struct {
+    uint32_t count;
+    uint32_t waiters;
+    sync_stats_t stats;
+} semaphore_t;
+
+//Condition variable, used with a mutex_t
+typedef struct {
+    uint32_t waiters;
+    sync_stats_t stats;
+} condvar_t;
+
+//Function declarations
+void sync_init(void);
+void mutex_init(mutex_t *mutex, const char *name);
+uint32_t mutex_destroy(mutex_t *mutex);
+sync_status_t mutex_lock(mutex_t *mutex, uint32_t pid);
+uint32_t mutex_trylock(mutex_t *mutex, uint32_t pid);
+uint32_t mutex_unlock(mutex_t *mutex, uint32_t pid);
+void sem_init(semaphore_t *sem, const char *name, uint32_t count);
+uint32_t sem_destroy(semaphore_t *sem);
+sync_status_t sem_wait(semaphore_t *sem, uint32_t pid);
+uint32_t sem_trywait(semaphore_t *sem);
+void sem_post(semaphore_t *sem);
+void cond_init(condvar_t *cond, const char *name);
+uint32_t cond_destroy(condvar_t *cond);
+sync_status_t cond_wait(condvar_t *cond, mutex_t *mutex, uint32_t pid);
+uint32_t cond_signal(condvar_t *cond);
+uint32_t cond_broadcast(condvar_t *cond);
+void sync_process_exit(uint32_t pid);
+void sync_print_stats(void);
+#endif
\ No newline at end of file
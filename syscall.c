@@ -0,0 +1,186 @@
+/* syscall.c - System call table and ring 3 entry paths
+ *
+ * SYSENTER is the primary way into the kernel: no descriptor lookups and
+ * no stack frame to build, so a round trip costs a fraction of an
+ * interrupt. int 0x80 stays as the fallback for CPUs without SEP and for
+ * code that cannot give up ECX/EDX. Both land in syscall_dispatch().
+ *
+ * Processes still do not run their own code, so ring 3 is entered
+ * explicitly: syscall_run_user() runs a function at CPL 3 on behalf of a
+ * process until it makes SYS_EXIT. Process stacks are allocator
+ * bookkeeping rather than memory the kernel owns, so the code runs on a
+ * per-CPU user stack instead.
+ */
+#include "syscall.h"
+#include "gdt.h"
+#include "interrupt.h"
+#include "process.h"
+#include "smp.h"
+#include "cpu.h"
+#include "serial.h"
+#include "kprintf.h"
+
+#define CPUID_FEAT_EDX_SEP          (1 << 11)
+#define MSR_IA32_SYSENTER_CS        0x174
+#define MSR_IA32_SYSENTER_ESP       0x175
+#define MSR_IA32_SYSENTER_EIP       0x176
+
+//Per-CPU state at the top of each syscall stack (offsets used by syscall_entry.S)
+typedef struct {
+    uint32_t kernel_esp;              /* Saved by syscall_enter_user(), 0 outside ring 3 */
+    uint32_t user_irqs;               /* Ring 3 runs with interrupts enabled */
+    uint32_t pid;                     /* Process the ring 3 code runs as */
+    uint32_t calls[SYSCALL_PATH_COUNT];
+} syscall_cpu_t;
+
+/* Provided by syscall_entry.S */
+extern void syscall_sysenter_entry(void);
+extern void syscall_int80_entry(void);
+extern uint32_t syscall_enter_user(uint32_t entry, uint32_t user_esp, uint32_t *kernel_esp);
+extern void syscall_leave_user(uint32_t kernel_esp, uint32_t code) __attribute__((noreturn));
+extern void syscall_user_return(void);
+
+static uint8_t syscall_stacks[SMP_MAX_CPUS][SYSCALL_STACK_SIZE] __attribute__((aligned(16)));
+static uint8_t syscall_user_stacks[SMP_MAX_CPUS][SYSCALL_USER_STACK_SIZE] __attribute__((aligned(16)));
+static uint32_t syscall_sep = 0;
+static uint32_t syscall_unknown = 0;
+
+static syscall_cpu_t *syscall_cpu(uint32_t cpu) {
+    return (syscall_cpu_t *)(syscall_stacks[cpu] + SYSCALL_STACK_SIZE) - 1;
+}
+
+static uint32_t sys_null(uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+    return 0;
+}
+
+static uint32_t sys_exit(uint32_t code, uint32_t arg2, uint32_t arg3) {
+    syscall_cpu_t *state = syscall_cpu(smp_cpu_id());
+    uint32_t kernel_esp = state->kernel_esp;
+    (void)arg2;
+    (void)arg3;
+    if (kernel_esp == 0) {
+        return SYSCALL_ERROR;
+    }
+    state->kernel_esp = 0;
+    syscall_leave_user(kernel_esp, code);
+}
+
+static uint32_t sys_getpid(uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+    return syscall_cpu(smp_cpu_id())->pid;
+}
+
+static uint32_t sys_write(uint32_t buffer, uint32_t length, uint32_t arg3) {
+    (void)arg3;
+    if (length > SYSCALL_WRITE_MAX) {
+        length = SYSCALL_WRITE_MAX;
+    }
+    return serial_write((const char *)buffer, length);
+}
+
+static const syscall_handler_t syscall_table[SYS_COUNT] = {
+    [SYS_NULL] = sys_null,
+    [SYS_EXIT] = sys_exit,
+    [SYS_GETPID] = sys_getpid,
+    [SYS_WRITE] = sys_write
+};
+
+//Install the int 0x80 gate and set up the boot CPU; needs gdt_init() and interrupt_init() first
+void syscall_init(void) {
+    idt_set_gate(SYSCALL_VECTOR, (uint32_t)syscall_int80_entry, IDT_GATE_USER_INTERRUPT);
+    syscall_unknown = 0;
+    syscall_init_cpu(0);
+    serial_puts(syscall_sep ? "[SYSCALL] SYSENTER ready, int 0x80 fallback installed\n"
+                            : "[SYSCALL] No SYSENTER, using int 0x80\n");
+}
+
+/**
+ * Point the calling CPU's TSS and SYSENTER MSRs at its syscall stack
+ * @param cpu: Logical index of the calling CPU
+ */
+void syscall_init_cpu(uint32_t cpu) {
+    uint32_t eax, ebx, ecx, edx;
+    syscall_cpu_t *state = syscall_cpu(cpu);
+    state->kernel_esp = 0;
+    state->calls[SYSCALL_PATH_SYSENTER] = 0;
+    state->calls[SYSCALL_PATH_INT80] = 0;
+    gdt_set_kernel_stack(cpu, (uint32_t)state);
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    syscall_sep = (edx & CPUID_FEAT_EDX_SEP) != 0;
+    if (syscall_sep) {
+        wrmsr(MSR_IA32_SYSENTER_CS, GDT_KERNEL_CODE);
+        wrmsr(MSR_IA32_SYSENTER_ESP, (uint32_t)state);
+        wrmsr(MSR_IA32_SYSENTER_EIP, (uint32_t)syscall_sysenter_entry);
+    }
+}
+
+//1 if ring 3 code may use syscall_sysenter()
+uint32_t syscall_sysenter_available(void) {
+    return syscall_sep;
+}
+
+/**
+ * Run one system call; both entry paths call this
+ * @param number: syscall_number_t
+ * @return: The handler's result, SYSCALL_ERROR for an unknown number
+ */
+uint32_t syscall_dispatch(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+    if (number >= SYS_COUNT) {
+        syscall_unknown++;
+        return SYSCALL_ERROR;
+    }
+    return syscall_table[number](arg1, arg2, arg3);
+}
+
+/**
+ * Run a function in ring 3 until it makes SYS_EXIT
+ * Returning from entry counts as SYS_EXIT with its return value.
+ * @param pid: Process the code runs as
+ * @param entry: Function to run at CPL 3; it may only reach the kernel through system calls
+ * @param arg: Passed to entry
+ * @return: The exit code, or SYSCALL_ERROR if pid is not a live process
+ */
+uint32_t syscall_run_user(uint32_t pid, syscall_user_entry_t entry, uint32_t arg) {
+    process_control_block_t *pcb = process_get_pcb(pid);
+    uint32_t cpu = smp_cpu_id();
+    syscall_cpu_t *state = syscall_cpu(cpu);
+    uint32_t *stack;
+    if (pid == 0 || pcb == NULL || pcb->state == TERMINATED) {
+        serial_puts("[SYSCALL] ERROR: No such process to run in ring 3\n");
+        return SYSCALL_ERROR;
+    }
+    stack = (uint32_t *)(syscall_user_stacks[cpu] + SYSCALL_USER_STACK_SIZE);
+    *--stack = arg;
+    *--stack = (uint32_t)syscall_user_return;
+    state->pid = pid;
+    state->user_irqs = (cpu_save_flags() & EFLAGS_IF) != 0;
+    return syscall_enter_user((uint32_t)entry, (uint32_t)stack, &state->kernel_esp);
+}
+
+//System calls made on every CPU through one path
+uint32_t syscall_path_count(syscall_path_t path) {
+    uint32_t total = 0;
+    uint32_t cpu;
+    for (cpu = 0; cpu < smp_cpu_count(); cpu++) {
+        total += syscall_cpu(cpu)->calls[path];
+    }
+    return total;
+}
+
+//Print the entry paths in use and per-CPU call counts
+void syscall_print_stats(void) {
+    uint32_t cpu;
+    serial_puts("\n=== System Calls ===\n");
+    kprintf("SYSENTER: %s\n", syscall_sep ? "yes" : "no (int 0x80 only)");
+    serial_puts("CPU | SYSENTER   | int 0x80\n");
+    for (cpu = 0; cpu < smp_cpu_count(); cpu++) {
+        kprintf("%3u | %10u | %10u\n", cpu, syscall_cpu(cpu)->calls[SYSCALL_PATH_SYSENTER],
+                syscall_cpu(cpu)->calls[SYSCALL_PATH_INT80]);
+    }
+    kprintf("Unknown call numbers: %u\n\n", syscall_unknown);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+/* syscall.h - System call table and ring 3 entry paths */
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+#include "types.h"
+
+#define SYSCALL_VECTOR      0x80      /* int 0x80 fallback */
+#define SYSCALL_STACK_SIZE  4096      /* Per-CPU kernel stack for entries from ring 3 */
+#define SYSCALL_USER_STACK_SIZE 4096  /* Per-CPU stack ring 3 code runs on */
+#define SYSCALL_ERROR       0xFFFFFFFF
+#define SYSCALL_WRITE_MAX   256       /* Longest SYS_WRITE */
+
+//Call numbers
+typedef enum {
+    SYS_NULL = 0,                     /* Does nothing; measures entry and exit */
+    SYS_EXIT = 1,                     /* (code) Leave ring 3; syscall_run_user() returns code */
+    SYS_GETPID = 2,                   /* () PID the ring 3 code runs as */
+    SYS_WRITE = 3,                    /* (buffer, length) Console output; returns bytes written */
+    SYS_COUNT
+} syscall_number_t;
+
+//Entry paths
+typedef enum {
+    SYSCALL_PATH_SYSENTER = 0,
+    SYSCALL_PATH_INT80 = 1,
+    SYSCALL_PATH_COUNT
+} syscall_path_t;
+
+typedef uint32_t (*syscall_handler_t)(uint32_t arg1, uint32_t arg2, uint32_t arg3);
+typedef uint32_t (*syscall_user_entry_t)(uint32_t arg);
+
+/*
+ * Ring 3 side. The call number goes in EAX and up to three arguments in
+ * EBX, ESI and EDI; the result comes back in EAX. ECX and EDX do not
+ * survive: SYSENTER uses them to pass the return stack and address.
+ */
+static inline uint32_t syscall_sysenter(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+    uint32_t result;
+    __asm__ volatile ("movl %%esp, %%ecx\n\t"
+                      "movl $1f, %%edx\n\t"
+                      "sysenter\n"
+                      "1:"
+                      : "=a"(result)
+                      : "a"(number), "b"(arg1), "S"(arg2), "D"(arg3)
+                      : "ecx", "edx", "memory");
+    return result;
+}
+
+static inline uint32_t syscall_int80(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3) {
+    uint32_t result;
+    __asm__ volatile ("int $0x80"
+                      : "=a"(result)
+                      : "a"(number), "b"(arg1), "S"(arg2), "D"(arg3)
+                      : "ecx", "edx", "memory");
+    return result;
+}
+
+//Function declarations
+void syscall_init(void);
+void syscall_init_cpu(uint32_t cpu);
+uint32_t syscall_sysenter_available(void);
+uint32_t syscall_dispatch(uint32_t number, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+uint32_t syscall_run_user(uint32_t pid, syscall_user_entry_t entry, uint32_t arg);
+uint32_t syscall_path_count(syscall_path_t path);
+void syscall_print_stats(void);
+#endif
\ No newline at end of file
@@ -1,11 +1,13 @@
 /* test_kernel.c - Kernel entry point for running tests */
 #include "types.h"
 #include "serial.h"
+#include "clock.h"
 #include "test_suite.h"
 
 void kmain(void) {
     /* Initialize hardware */
     serial_init();
+    clock_init();
     
     /* Run all tests */
     run_all_tests();
@@ -5,6 +5,23 @@
 #include "scheduler.h"
 #include "serial.h"
 #include "string.h"
+#include "spinlock.h"
+#include "trace.h"
+#include "workload.h"
+#include "kprintf.h"
+#include "debugcon.h"
+#include "clock.h"
+#include "profile.h"
+#include "latency.h"
+#include "ipc.h"
+#include "sync.h"
+#include "shm.h"
+#include "ring.h"
+#include "gdt.h"
+#include "interrupt.h"
+#include "syscall.h"
+#include "deferred.h"
+#include "initrd.h"
 
 /* Test counters */
 static uint32_t tests_run = 0;
@@ -65,6 +82,14 @@ void test_memory_allocate(void) {
     memory_free(addr1);
     uint32_t reused = memory_allocate(512, 1);
     ASSERT(reused != 0, "Memory can be reused after deallocation");
+    
+    /* Test 6: The heap moves above memory in use, but only while empty */
+    ASSERT_EQ(memory_reserve_below(PROCESS_HEAP_START + 0x1234), 0, "Heap in use is not moved");
+    memory_init();
+    ASSERT_EQ(memory_reserve_below(PROCESS_HEAP_START + 0x1234), 1, "Empty heap moves above reserved memory");
+    ASSERT_EQ(memory_allocate(16, 1), PROCESS_HEAP_START + 0x2000, "Heap restarts on the next page");
+    ASSERT_EQ(memory_reserve_below(0x100000), 1, "Memory below the heap needs no move");
+    memory_init();
 }
 
 void test_memory_free_process(void) {
@@ -241,6 +266,1053 @@ void test_scheduler_aging(void) {
     tests_run++;
 }
 
+void test_scheduler_edf(void) {
+    serial_puts("\n--- SCHEDULER EDF TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(RR, 10);
+    
+    uint32_t pid1 = process_create(2, 4096, 8192);
+    uint32_t pid2 = process_create(2, 4096, 8192);
+    uint32_t pid3 = process_create(2, 4096, 8192);
+    
+    /* Admission control: 20% + 62.5% fits, another 40% does not */
+    ASSERT_EQ(scheduler_set_edf(pid1, 2, 10, 10), 1, "EDF admits task within utilization bound");
+    ASSERT_EQ(scheduler_set_edf(pid2, 5, 10, 8), 1, "EDF admits constrained-deadline task");
+    ASSERT_EQ(scheduler_set_edf(pid3, 4, 10, 10), 0, "EDF rejects over-utilized task set");
+    ASSERT_EQ(scheduler_set_edf(pid3, 5, 4, 10), 0, "EDF rejects deadline beyond period");
+    ASSERT_EQ(scheduler_edf_utilization(), 8250, "EDF utilization tracks admitted tasks");
+    ASSERT_EQ(scheduler_set_edf(pid1, 5, 10, 10), 0, "EDF rejects a re-admission that does not fit");
+    ASSERT_EQ(scheduler_edf_utilization(), 8250, "Rejected re-admission keeps the old reservation");
+    ASSERT_EQ(scheduler_set_edf(pid1, 3, 10, 10), 1, "EDF re-admits against the rest of the task set");
+    ASSERT_EQ(scheduler_edf_utilization(), 9250, "Re-admission replaces the old reservation");
+    ASSERT_EQ(scheduler_set_edf(pid1, 2, 10, 10), 1, "EDF re-admits with the original budget");
+    scheduler_block(pid3);
+    ASSERT_EQ(scheduler_set_edf(pid3, 1, 10, 10), 0, "EDF rejects a blocked process");
+    ASSERT_EQ(scheduler_edf_utilization(), 8250, "Rejected blocked process reserves nothing");
+    scheduler_wake(pid3);
+    
+    /* Earliest deadline runs first, ahead of the normal class */
+    ASSERT_EQ(scheduler_get_next_process(), pid2, "EDF picks earliest deadline first");
+    
+    /* pid2 exhausts its 5-tick budget, then pid1 takes over */
+    scheduler_schedule();
+    uint32_t i;
+    for (i = 0; i < 5; i++) {
+        scheduler_update_time();
+    }
+    ASSERT_EQ(process_get_state(pid1), CURRENT, "EDF switches to next deadline when budget is spent");
+    
+    /* After both jobs finish the normal class gets the CPU */
+    scheduler_update_time();
+    scheduler_update_time();
+    ASSERT_EQ(process_get_state(pid3), CURRENT, "Normal class runs when no EDF job is active");
+    
+    for (i = 0; i < 30; i++) {
+        scheduler_update_time();
+    }
+    ASSERT_EQ(scheduler_edf_deadline_misses(), 0, "Admitted EDF task set meets all deadlines");
+    
+    /* Terminating an EDF process releases its reservation */
+    process_terminate(pid1);
+    ASSERT_EQ(scheduler_edf_utilization(), 6250, "Terminated EDF task releases utilization");
+    
+    scheduler_init(RR, 10);
+}
+
+void test_scheduler_trace(void) {
+    serial_puts("\n--- SCHEDULER TRACE TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(FCFS, 0);
+    uint32_t pid = process_create(1, 4096, 8192);
+    
+    uint32_t head = trace_head();
+    scheduler_schedule();
+    ASSERT_EQ(trace_head(), head + 1, "Context switch is recorded in trace");
+    
+    trace_event_t event;
+    ASSERT_EQ(trace_read(head, &event), 1, "Trace entry can be read back");
+    ASSERT(event.from_pid == 0 && event.to_pid == pid, "Trace entry has from/to PIDs");
+    ASSERT_EQ(event.reason, TRACE_REASON_SCHEDULE, "Trace entry records switch reason");
+    ASSERT_EQ(event.runqueue_len, 1, "Trace entry records run-queue length");
+    
+    scheduler_context_switch(pid, 0);
+    trace_read(head + 1, &event);
+    ASSERT_EQ(event.reason, TRACE_REASON_DIRECT, "Direct context switch is traced");
+    ASSERT_EQ(trace_read(head + 2, &event), 0, "Unwritten trace entry is not readable");
+}
+
+void test_scheduler_mlfq(void) {
+    serial_puts("\n--- SCHEDULER MLFQ TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(MLFQ, 2);
+    uint32_t pid1 = process_create(1, 4096, 8192);
+    uint32_t pid2 = process_create(1, 4096, 8192);
+    process_control_block_t *pcb1 = process_get_pcb(pid1);
+    process_control_block_t *pcb2 = process_get_pcb(pid2);
+    
+    scheduler_schedule();
+    ASSERT_EQ(scheduler_current_process(), pid1, "MLFQ runs first arrival at top level");
+    
+    /* Exhausting the level-0 slice demotes the process */
+    scheduler_update_time();
+    scheduler_update_time();
+    ASSERT_EQ(pcb1->mlfq_level, 1, "MLFQ demotes process that used its whole quantum");
+    ASSERT_EQ(scheduler_current_process(), pid2, "MLFQ switches to higher-level process");
+    
+    /* Yielding early keeps an interactive process on top */
+    scheduler_update_time();
+    scheduler_yield();
+    ASSERT_EQ(pcb2->mlfq_level, 0, "MLFQ keeps yielding process at top level");
+    ASSERT_EQ(scheduler_current_process(), pid2, "MLFQ re-picks interactive process over demoted one");
+    
+    /* Both demoted: lower levels get longer slices */
+    scheduler_update_time();
+    scheduler_update_time();
+    ASSERT_EQ(pcb2->mlfq_level, 1, "MLFQ demotes second process after its quantum");
+    ASSERT_EQ(scheduler_current_process(), pid1, "MLFQ is FIFO within a level");
+    uint32_t i;
+    for (i = 0; i < 3; i++) {
+        scheduler_update_time();
+    }
+    ASSERT_EQ(scheduler_current_process(), pid1, "MLFQ level-1 quantum is twice the base");
+    scheduler_update_time();
+    ASSERT_EQ(pcb1->mlfq_level, 2, "MLFQ demotes again after the longer quantum");
+    
+    /* A yield from a lower level promotes */
+    scheduler_yield();
+    ASSERT_EQ(pcb2->mlfq_level, 0, "MLFQ promotes process that yields before its quantum");
+    
+    /* Periodic boost returns everyone to the top level */
+    do {
+        scheduler_update_time();
+    } while (scheduler_get_time() % MLFQ_BOOST_INTERVAL != 0);
+    ASSERT(pcb1->mlfq_level + pcb2->mlfq_level <= 1, "MLFQ periodic boost resets levels");
+}
+
+void test_scheduler_accounting(void) {
+    serial_puts("\n--- SCHEDULER ACCOUNTING TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(MLFQ, 4);
+    uint32_t pid1 = process_create(1, 4096, 8192);
+    uint32_t pid2 = process_create(1, 4096, 8192);
+    process_control_block_t *pcb1 = process_get_pcb(pid1);
+    process_control_block_t *pcb2 = process_get_pcb(pid2);
+    uint32_t i;
+    
+    scheduler_schedule();
+    ASSERT_EQ(pcb1->switches_in, 1, "Switch-in is counted");
+    
+    /* Yield hands the CPU to the earlier arrival: a voluntary switch */
+    scheduler_update_time();
+    scheduler_yield();
+    ASSERT_EQ(scheduler_current_process(), pid2, "Yield switches to waiting process");
+    ASSERT_EQ(pcb1->voluntary_switches, 1, "Yield counts as voluntary switch");
+    ASSERT_EQ(pcb1->involuntary_switches, 0, "Yield is not counted as involuntary");
+    ASSERT(pcb1->cpu_cycles > 0, "CPU cycles accumulate while CURRENT");
+    
+    /* Quantum expiry is an involuntary switch */
+    for (i = 0; i < 4; i++) {
+        scheduler_update_time();
+    }
+    ASSERT_EQ(pcb2->involuntary_switches, 1, "Preemption counts as involuntary switch");
+    ASSERT_EQ(pcb2->voluntary_switches, 0, "Preemption is not counted as voluntary");
+    
+    /* Load average rises with two runnable processes */
+    uint32_t loads[3];
+    do {
+        scheduler_update_time();
+    } while (scheduler_get_time() % LOAD_SAMPLE_TICKS != 0);
+    scheduler_get_loadavg(loads);
+    ASSERT(loads[0] > 0 && loads[0] <= 2 * LOAD_FIXED_1, "1s load average tracks runnable processes");
+    ASSERT(loads[0] > loads[2], "Short load average reacts faster than long one");
+}
+
+void test_scheduler_workload(void) {
+    serial_puts("\n--- SCHEDULER WORKLOAD TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(RR, 5);
+    uint32_t pid1 = process_create(1, 4096, 8192);
+    uint32_t pid2 = process_create(1, 4096, 8192);
+    
+    /* Blocking the running process hands its CPU on */
+    scheduler_schedule();
+    ASSERT_EQ(scheduler_current_process(), pid1, "First process is running");
+    ASSERT_EQ(scheduler_block(pid1), 1, "Running process blocks");
+    ASSERT_EQ(process_get_state(pid1), BLOCKED, "Blocked process is BLOCKED");
+    ASSERT_EQ(scheduler_current_process(), pid2, "Blocking switches to next process");
+    scheduler_wake(pid1);
+    ASSERT_EQ(process_get_state(pid1), READY, "Woken process is READY");
+    
+    /* Synthetic job mix: everything finishes and bystanders are restored */
+    workload_config_t config = { 2000, 2, 2, 4, 7 };
+    workload_result_t rr;
+    workload_result_t fcfs;
+    workload_run(&config, &rr);
+    ASSERT_EQ(rr.spawned, 8, "Workload spawns every job");
+    ASSERT_EQ(rr.completed, 8, "Workload jobs complete under RR");
+    ASSERT(rr.switches > 0, "Workload counts context switches");
+    ASSERT(rr.wait_p99 >= rr.wait_p95 && rr.turnaround_p95 >= rr.turnaround_avg,
+           "Percentiles are ordered");
+    ASSERT(process_get_state(pid1) == READY && process_get_state(pid2) == READY,
+           "Parked processes are woken after the run");
+    
+    /* Same jobs without preemption: fewer switches */
+    ASSERT_EQ(scheduler_set_algorithm(FCFS, 5), 1, "Policy switches at run time");
+    workload_run(&config, &fcfs);
+    ASSERT_EQ(fcfs.completed, 8, "Workload jobs complete under FCFS");
+    ASSERT(fcfs.switches < rr.switches, "FCFS switches less often than RR");
+}
+
+static timer_wheel_t test_wheel;
+static uint32_t test_timer_fired[8];
+static uint32_t test_timer_count = 0;
+
+/* Log the tick each expiry ran on */
+static void test_timer_record(timer_event_t *timer) {
+    (void)timer;
+    if (test_timer_count < 8) {
+        test_timer_fired[test_timer_count] = test_wheel.next_tick - 1;
+    }
+    test_timer_count++;
+}
+
+void test_timer_wheel(void) {
+    serial_puts("\n--- TIMER WHEEL TESTS ---\n");
+    static timer_event_t timers[6];
+    const uint32_t far = (1U << 20) + 5;
+    uint32_t i;
+    
+    timer_wheel_init(&test_wheel, 0);
+    for (i = 0; i < 6; i++) {
+        timer_setup(&timers[i], test_timer_record);
+    }
+    timer_add(&test_wheel, &timers[0], 3);
+    timer_add(&test_wheel, &timers[1], 300);
+    timer_add(&test_wheel, &timers[2], 20000);
+    timer_add(&test_wheel, &timers[3], far);
+    timer_add(&test_wheel, &timers[4], 50);
+    timer_add(&test_wheel, &timers[5], 1U << 30);
+    ASSERT_EQ(test_wheel.pending, 6, "Wheel counts pending timers");
+    ASSERT_EQ(timer_cancel(&test_wheel, &timers[4]), 1, "Cancel dequeues a pending timer");
+    ASSERT_EQ(timer_cancel(&test_wheel, &timers[4]), 0, "Cancelling an idle timer is a no-op");
+    
+    test_timer_count = 0;
+    timer_advance(&test_wheel, 2);
+    ASSERT_EQ(test_timer_count, 0, "Nothing fires early");
+    timer_advance(&test_wheel, 3);
+    ASSERT(test_timer_count == 1 && test_timer_fired[0] == 3, "Root-level timer fires on its tick");
+    timer_advance(&test_wheel, 299);
+    ASSERT_EQ(test_timer_count, 1, "Cascaded timer does not fire early");
+    timer_advance(&test_wheel, 300);
+    ASSERT(test_timer_count == 2 && test_timer_fired[1] == 300, "Level-1 timer fires on its exact tick");
+    timer_advance(&test_wheel, far);
+    ASSERT(test_timer_count == 4 && test_timer_fired[2] == 20000 && test_timer_fired[3] == far,
+           "Level-2 and level-3 timers fire on their exact ticks");
+    ASSERT(timer_pending(&timers[5]), "Timer beyond the wheel's range stays queued");
+    
+    /* Re-arming moves a pending timer; a tick already past fires on the next one */
+    timer_add(&test_wheel, &timers[5], far + 5);
+    timer_add(&test_wheel, &timers[0], 0);
+    timer_advance(&test_wheel, far + 5);
+    ASSERT(test_timer_count == 6 && test_timer_fired[4] == far + 1 && test_timer_fired[5] == far + 5,
+           "Overdue timer fires next tick, moved timer on its new tick");
+    ASSERT_EQ(test_wheel.pending, 0, "Wheel is empty once everything fired");
+}
+
+void test_scheduler_timers(void) {
+    serial_puts("\n--- SCHEDULER TIMER TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(FCFS, 0);
+    uint32_t pid1 = process_create(1, 4096, 8192);
+    uint32_t pid2 = process_create(3, 4096, 8192);
+    process_control_block_t *pcb2 = process_get_pcb(pid2);
+    uint32_t i;
+    
+    scheduler_schedule();
+    ASSERT_EQ(scheduler_current_process(), pid1, "Higher priority process runs");
+    ASSERT_EQ(scheduler_sleep(pid2, 3), 1, "Waiting process goes to sleep");
+    scheduler_update_time();
+    scheduler_update_time();
+    ASSERT_EQ(process_get_state(pid2), BLOCKED, "Sleeper stays blocked until its timeout");
+    scheduler_update_time();
+    ASSERT_EQ(process_get_state(pid2), READY, "Sleep timer wakes the process on time");
+    
+    ASSERT_EQ(scheduler_sleep(pid2, 100), 1, "Process sleeps again");
+    scheduler_wake(pid2);
+    ASSERT(process_get_state(pid2) == READY && !timer_pending(&pcb2->sleep_timer),
+           "Early wake cancels the sleep timer");
+    
+    /* pid2 waits behind pid1 until its aging timer fires */
+    for (i = 0; i < AGING_THRESHOLD - 1; i++) {
+        scheduler_update_time();
+    }
+    ASSERT_EQ(pcb2->priority, 3, "No promotion before the aging threshold");
+    scheduler_update_time();
+    ASSERT_EQ(pcb2->priority, 2, "Aging timer promotes a long-waiting process");
+    ASSERT_EQ(scheduler_wait_time(pcb2), 0, "Promotion restarts the wait clock");
+    
+    process_terminate(pid2);
+    ASSERT(!timer_pending(&pcb2->aging_timer) && !timer_pending(&pcb2->sleep_timer),
+           "Terminated process leaves no timers queued");
+    
+    scheduler_init(RR, 10);
+}
+
+void test_ipc(void) {
+    serial_puts("\n--- IPC TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(RR, 10);
+    uint32_t server = process_create(1, 4096, 8192);
+    uint32_t client = process_create(1, 4096, 8192);
+    uint32_t other = process_create(1, 4096, 8192);
+    ipc_msg_t msg = { { 0, 0, 0, 0 } };
+    ipc_msg_t request = { { 7, 1, 2, 3 } };
+    ipc_msg_t reply = { { 42, 0, 0, 0xFFFFFFFF } };
+    ipc_stats_t stats;
+    uint32_t from = 0;
+    
+    /* Rendezvous: the receiver is waiting, so the call switches straight to it */
+    scheduler_schedule();
+    ASSERT_EQ(scheduler_current_process(), server, "Server runs first");
+    ASSERT_EQ(ipc_receive(server, IPC_ANY, &from, &msg), IPC_PENDING, "Receive with no sender blocks");
+    ASSERT_EQ(process_get_state(server), BLOCKED, "Waiting receiver is blocked");
+    ASSERT_EQ(scheduler_current_process(), client, "Client runs while the server waits");
+    ASSERT_EQ(ipc_call(client, server, &request), IPC_PENDING, "Call waits for the reply");
+    ASSERT_EQ(scheduler_current_process(), server, "Call hands the CPU straight to the server");
+    ASSERT_EQ(process_get_state(client), BLOCKED, "Caller blocks until the reply");
+    ASSERT_EQ(ipc_take(server, &from, &msg), IPC_OK, "Server collects the request");
+    ASSERT(from == client && msg.words[0] == 7 && msg.words[3] == 3, "Request arrives intact");
+    ASSERT_EQ(process_get_pcb(server)->context.ebx, 7, "Message travels in the saved registers");
+    ASSERT_EQ(ipc_reply(other, client, &reply), IPC_ERROR, "Only the called server can reply");
+    ASSERT_EQ(ipc_reply(server, client, &reply), IPC_OK, "Server replies");
+    ASSERT_EQ(scheduler_current_process(), client, "Reply hands the CPU back to the client");
+    ASSERT_EQ(process_get_state(server), READY, "Replying server stays runnable");
+    ASSERT_EQ(ipc_take(client, &from, &msg), IPC_OK, "Client collects the reply");
+    ASSERT(from == server && msg.words[0] == 42 && msg.words[3] == 0xFFFFFFFF, "Reply arrives intact");
+    ASSERT_EQ(ipc_take(client, &from, &msg), IPC_ERROR, "A reply is collected only once");
+    
+    /* Sender first: it queues on the receiver, which then takes it without blocking */
+    ASSERT_EQ(ipc_send(other, server, &request), IPC_PENDING, "Send with no receiver blocks");
+    ASSERT_EQ(process_get_state(other), BLOCKED, "Queued sender is blocked");
+    ASSERT_EQ(ipc_take(other, &from, &msg), IPC_PENDING, "Nothing to collect while blocked");
+    ASSERT_EQ(ipc_receive(server, client, &from, &msg), IPC_PENDING, "Receive filters by source");
+    ASSERT_EQ(ipc_send(client, server, &reply), IPC_OK, "Accepted sender completes at once");
+    ASSERT_EQ(ipc_take(server, &from, &msg), IPC_OK, "Filtered receive gets its message");
+    ASSERT(from == client && msg.words[0] == 42, "Queued sender was skipped");
+    ASSERT_EQ(ipc_receive(server, IPC_ANY, &from, &msg), IPC_OK, "Queued sender is taken at once");
+    ASSERT(from == other && msg.words[1] == 1, "Queued message comes from the sender's registers");
+    ASSERT_EQ(process_get_state(other), READY, "Sender is released");
+    ASSERT_EQ(ipc_take(other, &from, &msg), IPC_OK, "Released sender sees its send complete");
+    
+    /* Reply-and-wait: answer one caller and wait for the next in one step */
+    ASSERT_EQ(ipc_call(other, server, &request), IPC_PENDING, "Second call queues");
+    ASSERT_EQ(ipc_receive(server, IPC_ANY, &from, &msg), IPC_OK, "Server takes the queued call");
+    ASSERT_EQ(process_get_state(other), BLOCKED, "Taken caller waits for the reply");
+    ASSERT_EQ(ipc_reply_wait(server, other, &reply, IPC_ANY, &from, &msg), IPC_PENDING,
+              "Reply-and-wait blocks with no next sender");
+    ASSERT(process_get_state(server) == BLOCKED && process_get_state(other) != BLOCKED,
+           "Server waits and the caller is released");
+    ASSERT_EQ(ipc_take(other, &from, &msg), IPC_OK, "Caller collects the reply");
+    
+    /* A sender that cannot block must not stay queued */
+    scheduler_block(other);
+    ASSERT_EQ(ipc_send(other, client, &request), IPC_ERROR, "Send fails when the sender cannot block");
+    scheduler_wake(other);
+    ASSERT_EQ(ipc_take(other, &from, &msg), IPC_ERROR, "Failed send leaves nothing to collect");
+    
+    /* A partner exiting releases whoever waits on it */
+    ASSERT_EQ(ipc_call(client, server, &request), IPC_PENDING, "Call to waiting server");
+    process_terminate(server);
+    ASSERT_EQ(process_get_state(client), READY, "Server exit releases the caller");
+    ASSERT_EQ(ipc_take(client, &from, &msg), IPC_ERROR, "Released caller sees the failure");
+    ASSERT_EQ(ipc_send(client, server, &request), IPC_ERROR, "Cannot send to an exited process");
+    ipc_get_stats(&stats);
+    ASSERT(stats.handoffs >= 2 && stats.aborted == 1, "Handoffs and aborts are counted");
+    ASSERT_EQ(ipc_receive(client, IPC_ANY, &from, &msg), IPC_PENDING, "Failed sender was dequeued");
+    
+    scheduler_init(RR, 10);
+}
+
+/* Sleeping locks outlive the test, so keep them out of the stack */
+static mutex_t test_mutex_a;
+static mutex_t test_mutex_b;
+static semaphore_t test_sem;
+static condvar_t test_cond;
+
+void test_sleeping_locks(void) {
+    serial_puts("\n--- SLEEPING LOCK TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(FCFS, 0);
+    uint32_t low = process_create(4, 4096, 8192);
+    uint32_t mid = process_create(2, 4096, 8192);
+    uint32_t high = process_create(1, 4096, 8192);
+    process_control_block_t *low_pcb = process_get_pcb(low);
+    process_control_block_t *mid_pcb = process_get_pcb(mid);
+    uint32_t i;
+    mutex_init(&test_mutex_a, "test_a");
+    mutex_init(&test_mutex_b, "test_b");
+    
+    /* Priority inheritance, passed down a chain of owners */
+    ASSERT_EQ(mutex_lock(&test_mutex_a, low), SYNC_OK, "Free mutex is taken at once");
+    ASSERT_EQ(mutex_lock(&test_mutex_a, low), SYNC_ERROR, "Mutexes are not recursive");
+    ASSERT_EQ(mutex_lock(&test_mutex_b, mid), SYNC_OK, "Second mutex taken");
+    ASSERT_EQ(mutex_lock(&test_mutex_b, low), SYNC_BLOCKED, "Held mutex blocks the caller");
+    ASSERT_EQ(process_get_state(low), BLOCKED, "Waiter is blocked");
+    ASSERT_EQ(mid_pcb->priority, 2, "Lower-priority waiter lends nothing");
+    ASSERT_EQ(mutex_lock(&test_mutex_a, high), SYNC_BLOCKED, "High-priority process blocks");
+    ASSERT_EQ(low_pcb->priority, 1, "Owner inherits the waiter's priority");
+    ASSERT_EQ(mid_pcb->priority, 1, "Inheritance follows the owner's own wait");
+    ASSERT_EQ(mutex_trylock(&test_mutex_a, mid), 0, "Trylock fails on a held mutex");
+    ASSERT_EQ(mutex_unlock(&test_mutex_a, mid), 0, "Only the owner can unlock");
+    ASSERT_EQ(mutex_unlock(&test_mutex_b, mid), 1, "Owner unlocks");
+    ASSERT_EQ(mid_pcb->priority, 2, "Unlock drops inherited priority");
+    ASSERT(test_mutex_b.owner == low && process_get_state(low) == READY,
+           "Unlock hands the mutex to the waiter");
+    ASSERT_EQ(low_pcb->priority, 1, "New owner keeps what it still owes");
+    ASSERT_EQ(mutex_unlock(&test_mutex_a, low), 1, "Boosted owner unlocks");
+    ASSERT_EQ(low_pcb->priority, 4, "Owner returns to its own priority");
+    ASSERT(test_mutex_a.owner == high && process_get_state(high) == READY, "High-priority waiter gets the mutex");
+    ASSERT(test_mutex_a.stats.contentions == 1 && test_mutex_a.stats.boosts >= 1,
+           "Contention and boosts are counted");
+    ASSERT_EQ(mutex_unlock(&test_mutex_b, low), 1, "Release second mutex");
+    
+    /* Counting semaphore: units go to waiters by priority */
+    sem_init(&test_sem, "test_sem", 1);
+    ASSERT_EQ(sem_wait(&test_sem, low), SYNC_OK, "Available unit is taken");
+    ASSERT_EQ(sem_trywait(&test_sem), 0, "No unit left");
+    ASSERT_EQ(sem_wait(&test_sem, mid), SYNC_BLOCKED, "Empty semaphore blocks");
+    ASSERT_EQ(sem_wait(&test_sem, high), SYNC_BLOCKED, "Second waiter blocks");
+    sem_post(&test_sem);
+    ASSERT(process_get_state(high) == READY && process_get_state(mid) == BLOCKED,
+           "Post wakes the highest-priority waiter");
+    sem_post(&test_sem);
+    ASSERT_EQ(process_get_state(mid), READY, "Next post wakes the next waiter");
+    sem_post(&test_sem);
+    ASSERT_EQ(test_sem.count, 1, "Post with no waiters adds a unit");
+    
+    /* Condition variable: a signalled waiter queues on the mutex if it is held */
+    cond_init(&test_cond, "test_cond");
+    ASSERT_EQ(mutex_lock(&test_mutex_b, low), SYNC_OK, "Take mutex for the wait");
+    ASSERT_EQ(cond_wait(&test_cond, &test_mutex_b, mid), SYNC_ERROR, "Wait needs the mutex");
+    ASSERT_EQ(cond_wait(&test_cond, &test_mutex_b, low), SYNC_BLOCKED, "Condition wait blocks");
+    ASSERT_EQ(test_mutex_b.owner, 0, "Waiting releases the mutex");
+    ASSERT_EQ(mutex_lock(&test_mutex_b, mid), SYNC_OK, "Signaller takes the mutex");
+    ASSERT_EQ(cond_signal(&test_cond), 1, "Signal finds the waiter");
+    ASSERT_EQ(process_get_state(low), BLOCKED, "Signalled waiter waits for the mutex");
+    ASSERT_EQ(mutex_unlock(&test_mutex_b, mid), 1, "Signaller unlocks");
+    ASSERT(test_mutex_b.owner == low && process_get_state(low) == READY,
+           "Woken waiter holds the mutex again");
+    ASSERT_EQ(cond_signal(&test_cond), 0, "Signal with no waiters does nothing");
+    
+    /* Aging a boosted owner promotes its base priority, so the promotion outlives the boost */
+    ASSERT_EQ(mutex_lock(&test_mutex_b, high), SYNC_BLOCKED, "High-priority process waits on the owner");
+    ASSERT_EQ(low_pcb->priority, 1, "Owner is boosted");
+    scheduler_context_switch(scheduler_current_process(), mid);
+    for (i = 0; i < AGING_THRESHOLD; i++) {
+        scheduler_update_time();
+    }
+    ASSERT_EQ(low_pcb->priority, 1, "Aging keeps the inherited priority");
+    ASSERT_EQ(low_pcb->base_priority, 3, "Aging promotes the base priority while boosted");
+    ASSERT_EQ(mutex_unlock(&test_mutex_b, low), 1, "Boosted owner unlocks");
+    ASSERT_EQ(low_pcb->priority, 3, "Unlock keeps the aging promotion");
+    ASSERT_EQ(mutex_unlock(&test_mutex_b, high), 1, "Waiter got the mutex and releases it");
+    ASSERT_EQ(mutex_lock(&test_mutex_b, low), SYNC_OK, "Owner takes the mutex back");
+    
+    /* Exit releases held mutexes to the next waiter */
+    ASSERT_EQ(mutex_lock(&test_mutex_b, mid), SYNC_BLOCKED, "Wait behind the owner");
+    process_terminate(low);
+    ASSERT(test_mutex_b.owner == mid && process_get_state(mid) == READY,
+           "Exiting owner passes the mutex on");
+    process_terminate(high);
+    ASSERT_EQ(test_mutex_a.owner, 0, "Exit with no waiters frees the mutex");
+    
+    /* Destroy refuses objects in use and drops the rest from the stats list */
+    ASSERT_EQ(mutex_destroy(&test_mutex_b), 0, "Held mutex is not destroyed");
+    ASSERT_EQ(mutex_unlock(&test_mutex_b, mid), 1, "Release for destroy");
+    ASSERT_EQ(mutex_destroy(&test_mutex_b), 1, "Free mutex is destroyed");
+    ASSERT_EQ(test_mutex_b.stats.registered, 0, "Destroyed mutex leaves the stats list");
+    ASSERT_EQ(sem_wait(&test_sem, mid), SYNC_OK, "Take the last unit");
+    ASSERT_EQ(sem_wait(&test_sem, mid), SYNC_BLOCKED, "Wait on the empty semaphore");
+    ASSERT_EQ(sem_destroy(&test_sem), 0, "Semaphore with a waiter is not destroyed");
+    sem_post(&test_sem);
+    ASSERT(sem_destroy(&test_sem) && !test_sem.stats.registered, "Semaphore is destroyed once idle");
+    ASSERT(cond_destroy(&test_cond) && !test_cond.stats.registered, "Idle condition variable is destroyed");
+    mutex_init(&test_mutex_b, "test_b");
+    
+    scheduler_init(RR, 10);
+}
+
+void test_shared_memory(void) {
+    serial_puts("\n--- SHARED MEMORY TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(RR, 10);
+    uint32_t p1 = process_create(1, 4096, 8192);
+    uint32_t p2 = process_create(1, 4096, 8192);
+    uint32_t p3 = process_create(1, 4096, 8192);
+    
+    uint32_t region = shm_create("frames", 16384, p1);
+    ASSERT(region >= PROCESS_HEAP_START, "Region is allocated from the process heap");
+    ASSERT_EQ(shm_create("frames", 4096, p2), 0, "Region names are unique");
+    ASSERT_EQ(shm_create("a-name-far-too-long", 4096, p2), 0, "Overlong name is rejected");
+    ASSERT_EQ(shm_refcount("frames"), 1, "Creator holds the first reference");
+    ASSERT_EQ(shm_attach("frames", p2), region, "Every process sees the same address");
+    ASSERT_EQ(shm_attach("frames", p2), region, "Attaching twice is harmless");
+    ASSERT_EQ(shm_refcount("frames"), 2, "One reference per attached process");
+    ASSERT_EQ(shm_attach("missing", p3), 0, "Unknown region cannot be attached");
+    ASSERT_EQ(shm_size("frames"), 16384, "Region keeps its size");
+    
+    /* The region belongs to no process: freeing a process's memory leaves it alone */
+    memory_free_process(p1);
+    ASSERT_EQ(shm_attach("frames", p3), region, "Region survives its creator's heap");
+    ASSERT_EQ(shm_detach(region, p1), 1, "Creator detaches");
+    ASSERT_EQ(shm_detach(region, p1), 0, "Detach only once");
+    process_terminate(p2);
+    ASSERT_EQ(shm_refcount("frames"), 1, "Exit drops the process's reference");
+    ASSERT_EQ(shm_detach(region, p3), 1, "Last process detaches");
+    ASSERT_EQ(shm_refcount("frames"), 0, "Last detach destroys the region");
+    ASSERT_EQ(shm_attach("frames", p3), 0, "Destroyed region is gone");
+    ASSERT_EQ(memory_allocate(16384, p3), region, "Region memory is returned to the heap");
+    
+    scheduler_init(RR, 10);
+}
+
+void test_ring_channels(void) {
+    serial_puts("\n--- RING CHANNEL TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(RR, 10);
+    uint32_t producer = process_create(1, 4096, 8192);
+    uint32_t consumer = process_create(1, 4096, 8192);
+    uint32_t in[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint32_t out[8];
+    uint32_t i, ordered = 1;
+    
+    ASSERT(ring_create("bad", 0, producer, consumer) == NULL, "Zero capacity is rejected");
+    ASSERT(ring_create("bad", 8, producer, 999) == NULL, "Unknown consumer is rejected");
+    ring_t *ring = ring_create("pipe", 5, producer, consumer);
+    ASSERT(ring != NULL, "Ring is created");
+    ASSERT_EQ(ring->mask + 1, 8, "Capacity rounds up to a power of two");
+    ASSERT_EQ((uint32_t)&ring->tail - (uint32_t)&ring->head, RING_CACHE_LINE, "Head and tail sit on separate cache lines");
+    ASSERT_EQ(ring_consume(ring, out, 8), 0, "Empty ring yields nothing");
+    
+    ASSERT_EQ(ring_publish(ring, in, 6), 6, "Batch is published");
+    ASSERT_EQ(ring_consume(ring, out, 4), 4, "Consume takes at most max");
+    ASSERT_EQ(out[3], 4, "Entries come out in order");
+    ASSERT_EQ(ring_publish(ring, in, 8), 6, "Publish stops at the free space");
+    ASSERT_EQ(ring->full, 1, "Short batch is counted as full");
+    ASSERT_EQ(ring_count(ring), 8, "Ring is full");
+    ASSERT_EQ(ring_consume(ring, out, 8), 8, "Wrapped ring drains in one batch");
+    for (i = 0; i < 8; i++) {
+        if (out[i] != (i < 2 ? 5 + i : i - 1)) {
+            ordered = 0;
+        }
+    }
+    ASSERT(ordered, "Order survives the wrap");
+    ASSERT_EQ(ring->publishes, 2, "One head update per batch");
+    
+    /* The consumer only sleeps on an empty ring, and only that transition wakes it */
+    ASSERT_EQ(ring_publish(ring, in, 1), 1, "Single entry published");
+    ASSERT_EQ(ring_wait(ring), RING_OK, "Wait returns at once while entries are queued");
+    ring_consume(ring, out, 8);
+    ASSERT_EQ(ring_wait(ring), RING_BLOCKED, "Wait on an empty ring blocks");
+    ASSERT_EQ(process_get_state(consumer), BLOCKED, "Consumer is blocked");
+    ring_publish(ring, in, 3);
+    ASSERT(process_get_state(consumer) != BLOCKED, "Publish to an empty ring wakes the consumer");
+    ring_publish(ring, in, 3);
+    ASSERT_EQ(ring->wakeups, 1, "Publishing to a non-empty ring does not wake again");
+    
+    /* Closing */
+    process_terminate(producer);
+    ASSERT_EQ(ring_consume(ring, out, 8), 6, "Queued entries outlive the producer");
+    ASSERT_EQ(ring_wait(ring), RING_ERROR, "Drained ring with no producer reports closure");
+    ring_close(ring, consumer);
+    ASSERT(ring->slots == NULL, "Closing both ends frees the ring");
+    ASSERT_EQ(ring_publish(ring, in, 1), 0, "Closed ring accepts nothing");
+    
+    scheduler_init(RR, 10);
+}
+
+/* Ring 3 side of the system call tests: exercise both paths, exit with a checksum */
+static uint32_t user_syscall_probe(uint32_t pid) {
+    uint32_t sum = 0;
+    if (syscall_sysenter_available()) {
+        sum += syscall_sysenter(SYS_GETPID, 0, 0, 0) == pid;
+        sum += syscall_sysenter(SYS_NULL, 0, 0, 0) == 0;
+        sum += syscall_sysenter(SYS_COUNT, 0, 0, 0) == SYSCALL_ERROR;
+    }
+    sum += (syscall_int80(SYS_GETPID, 0, 0, 0) == pid) << 4;
+    sum += (syscall_int80(SYS_NULL, 0, 0, 0) == 0) << 4;
+    syscall_int80(SYS_EXIT, sum, 0, 0);
+    return 0;
+}
+
+/* Ring 3: fall off the end instead of calling SYS_EXIT */
+static uint32_t user_return_value(uint32_t value) {
+    return value * 2;
+}
+
+void test_system_calls(void) {
+    serial_puts("\n--- SYSTEM CALL TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(RR, 10);
+    gdt_init();
+    interrupt_init();
+    syscall_init();
+    uint32_t pid = process_create(1, 4096, 4096);
+    uint16_t cs, ds;
+    
+    /* The table, called directly */
+    ASSERT_EQ(syscall_dispatch(SYS_NULL, 1, 2, 3), 0, "Null call returns 0");
+    ASSERT_EQ(syscall_dispatch(SYS_COUNT, 0, 0, 0), SYSCALL_ERROR, "Unknown number is rejected");
+    ASSERT_EQ(syscall_dispatch(SYS_EXIT, 0, 0, 0), SYSCALL_ERROR, "Exit outside ring 3 is refused");
+    ASSERT_EQ(syscall_run_user(999, user_return_value, 0), SYSCALL_ERROR, "Unknown process cannot enter ring 3");
+    
+    /* A real trip through ring 3 */
+    uint32_t expected = syscall_sysenter_available() ? 3 + 32 : 32;
+    ASSERT_EQ(syscall_run_user(pid, user_syscall_probe, pid), expected, "Ring 3 calls return through both paths");
+    ASSERT_EQ(syscall_path_count(SYSCALL_PATH_INT80), 3, "int 0x80 entries counted");
+    ASSERT_EQ(syscall_path_count(SYSCALL_PATH_SYSENTER), syscall_sysenter_available() ? 3 : 0,
+              "SYSENTER entries counted");
+    ASSERT_EQ(syscall_run_user(pid, user_return_value, 21), 42, "Returning from the entry function exits");
+    __asm__ volatile ("mov %%cs, %0; mov %%ds, %1" : "=r"(cs), "=r"(ds));
+    ASSERT_EQ(cs, GDT_KERNEL_CODE, "Back on the kernel code segment");
+    ASSERT_EQ(ds, GDT_KERNEL_DATA, "Kernel data segments restored");
+    
+    process_terminate(pid);
+    scheduler_init(RR, 10);
+}
+
+#define DEFERRED_TEST_ITEMS (DEFERRED_IRQ_BUDGET + 4)
+
+static uint32_t deferred_test_runs;
+static deferred_work_t deferred_test_items[DEFERRED_TEST_ITEMS];
+static deferred_work_t deferred_test_self;
+
+static void deferred_test_count(void *arg) {
+    deferred_test_runs += (uint32_t)(uintptr_t)arg;
+}
+
+/* Queues itself again until it has run three times */
+static void deferred_test_requeue(void *arg) {
+    (void)arg;
+    if (++deferred_test_runs < 3) {
+        deferred_queue(&deferred_test_self);
+    }
+}
+
+void test_deferred_work(void) {
+    serial_puts("\n--- DEFERRED WORK TESTS ---\n");
+    
+    memory_init();
+    process_init();
+    scheduler_init(RR, 10);
+    interrupt_init();      /* Interrupt exits enable interrupts; every line stays masked */
+    deferred_init();
+    uint32_t worker = deferred_worker_pid(0);
+    deferred_stats_t stats;
+    uint32_t i;
+    uint32_t sections;
+    uint32_t traced;
+    
+    ASSERT(worker != 0, "Boot CPU has a worker process");
+    ASSERT_EQ(process_get_state(worker), BLOCKED, "Idle worker is blocked");
+    for (i = 0; i < DEFERRED_TEST_ITEMS; i++) {
+        deferred_work_init(&deferred_test_items[i], deferred_test_count, (void *)1);
+    }
+    deferred_test_runs = 0;
+    ASSERT_EQ(deferred_queue(&deferred_test_items[0]), 1, "Work is queued");
+    ASSERT_EQ(deferred_queue(&deferred_test_items[0]), 0, "Pending work is not queued twice");
+    ASSERT_EQ(deferred_test_runs, 0, "Queued work waits for a drain");
+    deferred_get_stats(0, &stats);
+    ASSERT_EQ(stats.depth, 1, "Depth counts queued items");
+    ASSERT_EQ(stats.already_pending, 1, "Folded requests are counted");
+    
+    /* An interrupt exit runs one budget and leaves the rest to the worker */
+    for (i = 1; i < DEFERRED_TEST_ITEMS; i++) {
+        deferred_queue(&deferred_test_items[i]);
+    }
+    deferred_irq_exit();
+    ASSERT_EQ(deferred_test_runs, DEFERRED_IRQ_BUDGET, "Interrupt exit stops at its budget");
+    deferred_get_stats(0, &stats);
+    ASSERT_EQ(stats.depth, DEFERRED_TEST_ITEMS - DEFERRED_IRQ_BUDGET, "Leftover work stays queued");
+    ASSERT_EQ(stats.max_depth, DEFERRED_TEST_ITEMS, "Deepest queue is kept");
+    ASSERT(process_get_state(worker) != BLOCKED, "Leftover work wakes the worker");
+    /* Every line is masked, so interrupts can be on for the latency tracer to see the worker */
+    traced = latency_set_enabled(1);
+    sections = latency_sections();
+    cpu_irq_enable();
+    ASSERT_EQ(deferred_worker_run(), DEFERRED_TEST_ITEMS - DEFERRED_IRQ_BUDGET, "Worker runs the rest");
+    cpu_irq_disable();
+    ASSERT_EQ(latency_sections(), sections + 2, "Claim and close-and-block sections are traced");
+    latency_set_enabled(traced);
+    ASSERT_EQ(process_get_state(worker), BLOCKED, "Worker blocks once the queue is empty");
+    ASSERT_EQ(deferred_worker_run(), 0, "Empty queue gives the worker nothing");
+    deferred_irq_exit();
+    deferred_get_stats(0, &stats);
+    ASSERT_EQ(stats.run_irq_exit, DEFERRED_IRQ_BUDGET, "Empty queue makes interrupt exit a no-op");
+    ASSERT_EQ(stats.run_irq_exit + stats.run_worker, stats.queued, "Every queued item ran once");
+    ASSERT_EQ(stats.worker_wakeups, 1, "Worker woken once");
+    ASSERT(stats.latency_max > 0 && stats.latency_total >= stats.latency_max, "Queueing delay is measured");
+    
+    /* Work may queue itself again from its own run; the worker keeps draining */
+    deferred_work_init(&deferred_test_self, deferred_test_requeue, NULL);
+    deferred_test_runs = 0;
+    deferred_queue(&deferred_test_self);
+    ASSERT_EQ(deferred_worker_run(), 3, "Requeued work runs again in the same drain");
+    
+    process_terminate(worker);
+    ASSERT_EQ(deferred_worker_pid(0), 0, "Terminated worker is forgotten");
+    deferred_queue(&deferred_test_items[0]);
+    deferred_irq_exit();
+    deferred_get_stats(0, &stats);
+    ASSERT_EQ(stats.depth, 0, "Work still runs without a worker");
+    
+    scheduler_init(RR, 10);
+}
+
+/* ============================================================================
+   DRIVER TESTS
+   ============================================================================ */
+
+void test_serial_write(void) {
+    serial_puts("\n--- SERIAL DRIVER TESTS ---\n");
+    
+    /* Output is polled until serial_enable_irq(): every byte goes out at once */
+    ASSERT_EQ(serial_write("serial_write\n", 13), 13, "Non-blocking write accepts whole buffer");
+    ASSERT_EQ(serial_tx_pending(), 0, "Nothing left queued in polled mode");
+    ASSERT_EQ(serial_write("", 0), 0, "Empty write accepts nothing");
+    ASSERT_EQ(serial_set_muted(1), 0, "Console starts unmuted");
+    ASSERT_EQ(serial_write("dropped", 7), 7, "Muted write still reports bytes accepted");
+    ASSERT_EQ(serial_set_muted(0), 1, "Unmute returns previous setting");
+    
+    /* Line discipline: backspace edits, Enter completes the line */
+    char line[8];
+    const char *typed = "lx\bs\r";
+    while (*typed) {
+        serial_rx_input(*typed++);
+    }
+    ASSERT_EQ(serial_read_line(line, sizeof(line)), 2, "Read returns edited line length");
+    ASSERT(line[0] == 'l' && line[1] == 's' && line[2] == '\0', "Backspace removes typed character");
+    
+    /* Lines longer than the buffer are truncated, not split */
+    typed = "0123456789\rok\r";
+    while (*typed) {
+        serial_rx_input(*typed++);
+    }
+    ASSERT_EQ(serial_read_line(line, sizeof(line)), 7, "Long line is truncated to buffer");
+    ASSERT_EQ(serial_read_line(line, sizeof(line)), 2, "Next line starts after the newline");
+}
+
+void test_kprintf(void) {
+    serial_puts("\n--- KPRINTF TESTS ---\n");
+    char buf[64];
+    
+    ksnprintf(buf, sizeof(buf), "%u|%d|%i", 4294967295U, -42, 0);
+    ASSERT(strcmp(buf, "4294967295|-42|0") == 0, "Decimal conversions");
+    ksnprintf(buf, sizeof(buf), "%5u|%-5u|%05d|%-3s|", 42, 42, -42, "ab");
+    ASSERT(strcmp(buf, "   42|42   |-0042|ab |") == 0, "Field widths and flags");
+    ksnprintf(buf, sizeof(buf), "%x|%X|%08X|%p", 0xbeef, 0xbeef, 0x1F, (void *)0x1000);
+    ASSERT(strcmp(buf, "beef|BEEF|0000001F|0x1000") == 0, "Hex conversions");
+    ksnprintf(buf, sizeof(buf), "%llu|%llX|%lld", 12345678901234567890ULL, 0x123456789ABCULL, -5000000000LL);
+    ASSERT(strcmp(buf, "12345678901234567890|123456789ABC|-5000000000") == 0, "64-bit conversions");
+    ksnprintf(buf, sizeof(buf), "%c%c|%%|%*u|%-*u|", 'o', 'k', 4, 7, 3, 8);
+    ASSERT(strcmp(buf, "ok|%|   7|8  |") == 0, "Chars, percent and star widths");
+    ASSERT_EQ(ksnprintf(buf, 6, "%s", "truncated"), 9, "Returns untruncated length");
+    ASSERT(strcmp(buf, "trunc") == 0, "Truncated output is NUL terminated");
+    
+    char digits[10];
+    ASSERT_EQ(kfmt_dec(digits, 1000000007), 10, "Table conversion handles ten digits");
+    ASSERT(digits[0] == '1' && digits[9] == '7', "Table conversion digit order");
+}
+
+void test_clock(void) {
+    serial_puts("\n--- CLOCK TESTS ---\n");
+    uint32_t khz = clock_tsc_khz();
+    
+    ASSERT(khz > 0, "TSC rate is known");
+    ASSERT(clock_cycles_to_ns(0) == 0, "Zero cycles is zero time");
+    ASSERT(clock_cycles_to_ns(khz) == 1000000, "One millisecond of cycles");
+    ASSERT(clock_cycles_to_ns((uint64_t)khz * 3600000) == 3600000000000ULL, "An hour of cycles converts without overflow");
+    
+    uint64_t before = clock_now_ns();
+    uint64_t start = clock_cycles();
+    clock_delay_us(200);
+    ASSERT(clock_cycles_to_ns(clock_cycles() - start) >= 200000, "Delay waits at least as long as asked");
+    ASSERT(clock_now_ns() >= before + 200000, "Monotonic clock advances across the delay");
+}
+
+void test_profile(void) {
+    serial_puts("\n--- PROFILER TESTS ---\n");
+    uint32_t i;
+    
+    profile_reset();
+    for (i = 0; i < 3; i++) {
+        profile_record(0x101000, 0, 0);
+    }
+    profile_record(0x102000, 0, 0);
+    ASSERT_EQ(profile_samples(), 4, "Every sample is counted");
+    ASSERT_EQ(profile_count(0x101000), 3, "Samples at one EIP share a bucket");
+    ASSERT_EQ(profile_count(0x102000), 1, "Different EIPs get separate buckets");
+    ASSERT_EQ(profile_count(0x103000), 0, "Unsampled EIP has no count");
+    
+    /* Colliding EIPs probe onward instead of merging */
+    for (i = 0; i < 64; i++) {
+        profile_record(0x200000 + i * PROFILE_BUCKETS * 4, 0, 0);
+    }
+    ASSERT_EQ(profile_count(0x200000 + 63 * PROFILE_BUCKETS * 4), 1, "Hash collisions keep exact counts");
+    
+    ASSERT_EQ(profile_start(PROFILE_MIN_HZ - 1), 0, "Rate below the PIT range is rejected");
+    profile_reset();
+    ASSERT_EQ(profile_samples(), 0, "Reset clears the histogram");
+}
+
+void test_latency(void) {
+    serial_puts("\n--- LATENCY TRACER TESTS ---\n");
+    static spinlock_t lock = SPINLOCK_INIT("test-latency");
+    uint32_t cycles_per_us = clock_tsc_khz() / 1000;
+    latency_section_t section;
+    uint32_t before;
+    uint32_t flags;
+    
+    latency_reset();
+    ASSERT_EQ(latency_sections(), 0, "Reset clears the section count");
+    latency_record(0x101000, 0x101100, (uint64_t)cycles_per_us * 3);
+    latency_record(0x102000, 0x102100, (uint64_t)cycles_per_us * 20000);
+    latency_record(0x101000, 0x101100, 10);
+    ASSERT_EQ(latency_sections(), 3, "Every section is counted");
+    ASSERT_EQ(latency_bucket_count(0), 1, "Sub-microsecond section lands in bucket 0");
+    ASSERT_EQ(latency_bucket_count(2), 1, "3us section lands in the 2-4us bucket");
+    ASSERT_EQ(latency_bucket_count(LATENCY_BUCKETS - 1), 1, "20ms section lands in the top bucket");
+    ASSERT_EQ(latency_max_cycles(), cycles_per_us * 20000, "Max is the longest section");
+    ASSERT(latency_worst(0, &section) && section.off_site == 0x102000 && section.on_site == 0x102100,
+           "Longest section keeps both call sites");
+    ASSERT(latency_worst(1, &section) && section.off_site == 0x101000 && section.cycles == cycles_per_us * 3,
+           "Longest sections are kept in descending order");
+    ASSERT_EQ(latency_worst(3, &section), 0, "Unfilled ranks are reported empty");
+    
+    /* An irqsave pair is traced only if it actually turned interrupts off */
+    before = latency_sections();
+    flags = spin_lock_irqsave(&lock);
+    spin_unlock_irqrestore(&lock, flags);
+    ASSERT_EQ(latency_sections(), before + ((flags & EFLAGS_IF) ? 1 : 0), "Outermost irqsave pair is one section");
+    
+    latency_set_enabled(0);
+    latency_record(0x103000, 0x103100, 100);
+    ASSERT_EQ(latency_sections(), before + ((flags & EFLAGS_IF) ? 1 : 0), "Disabled tracer records nothing");
+    latency_set_enabled(1);
+    latency_reset();
+}
+
+void test_debugcon(void) {
+    serial_puts("\n--- DEBUGCON TESTS ---\n");
+    dbg_record_t record;
+    const uint8_t *bytes = (const uint8_t *)&record;
+    
+    ASSERT_EQ(sizeof(dbg_record_t), DEBUGCON_RECORD_SIZE, "Records are 16 bytes");
+    debugcon_encode(&record, DBG_EV_ALLOC, 3, 0x1234, 0x1122334455667788ULL, 0x200000, 4096);
+    ASSERT(bytes[0] == DBG_EV_ALLOC && bytes[1] == 3, "Type and CPU lead the record");
+    ASSERT(bytes[2] == 0x34 && bytes[3] == 0x12, "Argument is little-endian");
+    ASSERT_EQ(record.tsc_lo, 0x55667788, "Only the low TSC word is stored");
+    ASSERT(bytes[8] == 0x00 && bytes[10] == 0x20 && record.b == 4096, "Payload words follow the TSC");
+    
+    /* The test kernel boots without -debugcon */
+    ASSERT_EQ(debugcon_set_enabled(1), 0, "Enabling without the port fails");
+    ASSERT_EQ(debugcon_active, 0, "Hooks stay disabled");
+}
+
+#define INITRD_TEST_DATA_SIZE ((INITRD_CACHE_BLOCKS + 4) * INITRD_BLOCK_SIZE + 20)
+#define INITRD_TEST_IMAGE_SIZE (INITRD_TEST_DATA_SIZE + 8 * INITRD_BLOCK_SIZE)
+
+static uint8_t initrd_test_image[INITRD_TEST_IMAGE_SIZE] __attribute__((aligned(INITRD_BLOCK_SIZE)));
+
+/* Zero-padded octal field with a NUL in the last byte, as tar writes it */
+static void initrd_test_octal(uint8_t *field, uint32_t len, uint32_t value) {
+    field[--len] = '\0';
+    while (len--) {
+        field[len] = (uint8_t)('0' + (value & 7));
+        value >>= 3;
+    }
+}
+
+/* Append a ustar header and its data, as tar would */
+static uint32_t initrd_test_add(uint32_t pos, const char *name, char type, const char *data, uint32_t size) {
+    uint8_t *header = initrd_test_image + pos;
+    uint32_t sum = 0;
+    uint32_t i;
+    memset(header, 0, INITRD_BLOCK_SIZE);
+    strcpy((char *)header, name);
+    initrd_test_octal(header + 124, 12, size);
+    header[156] = (uint8_t)type;
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    memset(header + 148, ' ', 8);
+    for (i = 0; i < INITRD_BLOCK_SIZE; i++) {
+        sum += header[i];
+    }
+    initrd_test_octal(header + 148, 7, sum);
+    pos += INITRD_BLOCK_SIZE;
+    for (i = 0; i < size; i++) {
+        initrd_test_image[pos + i] = data ? (uint8_t)data[i] : (uint8_t)(i * 7);
+    }
+    return pos + ((size + INITRD_BLOCK_SIZE - 1) & ~(INITRD_BLOCK_SIZE - 1));
+}
+
+void test_initrd(void) {
+    serial_puts("\n--- INITRD TESTS ---\n");
+    
+    static uint8_t buf[1024];
+    char long_name[INITRD_NAME_LEN + 1];
+    const initrd_file_t *hello;
+    const initrd_file_t *data;
+    initrd_stats_t stats;
+    uint32_t pos, i, ok;
+    
+    memset(initrd_test_image, 0, sizeof(initrd_test_image));
+    pos = initrd_test_add(0, "./hello.txt", '0', "Hello, initrd", 13);
+    pos = initrd_test_add(pos, "./dir/", '5', NULL, 0);
+    initrd_test_add(pos, "./dir/data.bin", '0', NULL, INITRD_TEST_DATA_SIZE);
+    ASSERT_EQ(initrd_mount(initrd_test_image, sizeof(initrd_test_image)), 1, "ustar image mounts");
+    ASSERT_EQ(initrd_file_count(), 2, "Regular files are indexed, directories skipped");
+    hello = initrd_open("hello.txt");
+    data = initrd_open("/dir/data.bin");
+    ASSERT(hello != NULL && strcmp(hello->name, "hello.txt") == 0, "Leading ./ is stripped");
+    ASSERT(data != NULL && data->size == INITRD_TEST_DATA_SIZE, "Lookup ignores a leading / and reads the size");
+    ASSERT(initrd_open("missing") == NULL, "Unknown file is not found");
+    ASSERT(initrd_file(0) == hello && initrd_file(2) == NULL, "Files are listed in archive order");
+    
+    /* Aligned ranges are handed out in place */
+    ASSERT(initrd_map(data, 0, data->size) == initrd_test_image + data->offset, "Aligned map points into the image");
+    ASSERT(initrd_map(data, INITRD_BLOCK_SIZE, 10) == initrd_test_image + data->offset + INITRD_BLOCK_SIZE, "Map at a later block");
+    ASSERT(initrd_map(data, 1, 10) == NULL, "Unaligned map is refused");
+    ASSERT(initrd_map(hello, 0, 14) == NULL, "Map past the end is refused");
+    
+    /* Partial blocks go through the cache, whole blocks straight from the image */
+    initrd_reset_stats();
+    ASSERT_EQ(initrd_read(data, 100, buf, 1000), 1000, "Read spanning three blocks");
+    ok = 1;
+    for (i = 0; i < 1000; i++) {
+        ok &= buf[i] == (uint8_t)((100 + i) * 7);
+    }
+    ASSERT(ok, "Read returns the file bytes");
+    initrd_get_stats(&stats);
+    ASSERT_EQ(stats.direct_blocks, 1, "Middle block is copied directly");
+    ASSERT_EQ(stats.cache_misses, 2, "Head and tail blocks are cached");
+    ASSERT_EQ(initrd_read(data, 200, buf, 10), 10, "Small read");
+    initrd_get_stats(&stats);
+    ASSERT_EQ(stats.cache_hits, 1, "Small read hits the cached block");
+    ASSERT_EQ(initrd_read(hello, 7, buf, sizeof(buf)), 6, "Read is clamped to the file");
+    ASSERT(buf[0] == 'i' && buf[5] == 'd', "Clamped read returns the tail");
+    ASSERT_EQ(initrd_read(hello, 13, buf, 1), 0, "Read at the end returns nothing");
+    
+    /* One byte from every block: the cache fills, then the oldest blocks are evicted */
+    initrd_mount(initrd_test_image, sizeof(initrd_test_image));
+    for (i = 0; i < INITRD_CACHE_BLOCKS + 5; i++) {
+        initrd_read(data, i * INITRD_BLOCK_SIZE + 1, buf, 1);
+    }
+    initrd_get_stats(&stats);
+    ASSERT_EQ(stats.cache_misses, INITRD_CACHE_BLOCKS + 5, "Every new block misses");
+    ASSERT_EQ(stats.cache_evictions, 5, "Full cache evicts");
+    initrd_read(data, INITRD_CACHE_BLOCKS * INITRD_BLOCK_SIZE + 2, buf, 1);
+    initrd_read(data, 2, buf, 1);
+    initrd_get_stats(&stats);
+    ASSERT_EQ(stats.cache_hits, 1, "Recent block is still cached");
+    ASSERT_EQ(stats.cache_evictions, 6, "Least recently used block was evicted");
+    
+    /* Damaged archives are refused */
+    initrd_test_image[0] ^= 1;
+    ASSERT_EQ(initrd_mount(initrd_test_image, sizeof(initrd_test_image)), 0, "Bad header checksum is refused");
+    ASSERT_EQ(initrd_file_count(), 0, "Refused image has no files");
+    initrd_test_image[0] ^= 1;
+    ASSERT_EQ(initrd_mount(initrd_test_image, 5 * INITRD_BLOCK_SIZE), 0, "Truncated archive is refused");
+    ASSERT(initrd_read(hello, 0, buf, 1) == 0 && initrd_map(hello, 0, 1) == NULL, "Nothing is read once unmounted");
+    
+    /* A name that fills the whole header field has no NUL of its own */
+    memset(long_name, 'n', INITRD_NAME_LEN);
+    long_name[INITRD_NAME_LEN] = '\0';
+    memset(initrd_test_image, 0, sizeof(initrd_test_image));
+    initrd_test_add(0, long_name, '0', "x", 1);
+    ASSERT_EQ(initrd_mount(initrd_test_image, sizeof(initrd_test_image)), 1, "Archive with a full-length name mounts");
+    hello = initrd_open(long_name);
+    ASSERT(hello != NULL && strlen(hello->name) == INITRD_NAME_LEN && hello->offset == INITRD_BLOCK_SIZE,
+           "Full-length name is kept whole");
+    initrd_unmount();
+}
+
+/* ============================================================================
+   SYNCHRONIZATION TESTS
+   ============================================================================ */
+
+typedef struct {
+    uint32_t value;
+    mpsc_node_t node;
+} test_item_t;
+
+void test_sync_primitives(void) {
+    serial_puts("\n--- SYNCHRONIZATION TESTS ---\n");
+    
+    /* Atomic counters */
+    atomic_t counter = ATOMIC_INIT(5);
+    ASSERT_EQ(atomic_inc(&counter), 6, "Atomic increment returns new value");
+    ASSERT_EQ(atomic_dec(&counter), 5, "Atomic decrement returns new value");
+    ASSERT_EQ(atomic_cmpxchg(&counter, 4, 9), 0, "Atomic cmpxchg fails on mismatch");
+    ASSERT_EQ(atomic_cmpxchg(&counter, 5, 9), 1, "Atomic cmpxchg succeeds on match");
+    ASSERT_EQ(atomic_read(&counter), 9, "Atomic cmpxchg stores new value");
+    
+    /* Ticket spinlock */
+    spinlock_t lock;
+    spin_lock_init(&lock, "test");
+    spin_lock(&lock);
+    ASSERT_EQ(spin_trylock(&lock), 0, "Trylock fails while lock is held");
+    spin_unlock(&lock);
+    ASSERT_EQ(spin_trylock(&lock), 1, "Trylock succeeds on free lock");
+    spin_unlock(&lock);
+    uint32_t flags = spin_lock_irqsave(&lock);
+    spin_unlock_irqrestore(&lock, flags);
+    ASSERT_EQ(lock.acquisitions, 3, "Lock statistics count acquisitions");
+    ASSERT_EQ(lock.now_serving, lock.next_ticket, "Released lock has no pending tickets");
+    
+    /* MPSC queue preserves FIFO order */
+    mpsc_queue_t queue;
+    test_item_t items[3];
+    uint32_t i;
+    mpsc_init(&queue);
+    ASSERT(mpsc_pop(&queue) == NULL, "Empty MPSC queue pops NULL");
+    for (i = 0; i < 3; i++) {
+        items[i].value = i + 1;
+        mpsc_push(&queue, &items[i].node);
+    }
+    uint32_t order_ok = 1;
+    for (i = 0; i < 3; i++) {
+        mpsc_node_t *node = mpsc_pop(&queue);
+        if (node == NULL || container_of(node, test_item_t, node)->value != i + 1) {
+            order_ok = 0;
+        }
+    }
+    ASSERT(order_ok, "MPSC queue pops in FIFO order");
+    ASSERT(mpsc_pop(&queue) == NULL, "Drained MPSC queue pops NULL");
+}
+
 /* ============================================================================
    INTEGRATION TESTS
    ============================================================================ */
@@ -327,6 +1399,31 @@ void run_all_tests(void) {
     test_scheduler_get_next_process();
     test_scheduler_update_time();
     test_scheduler_aging();
+    test_scheduler_edf();
+    test_scheduler_trace();
+    test_scheduler_mlfq();
+    test_scheduler_accounting();
+    test_scheduler_workload();
+    test_timer_wheel();
+    test_scheduler_timers();
+    test_ipc();
+    test_sleeping_locks();
+    test_shared_memory();
+    test_ring_channels();
+    test_system_calls();
+    test_deferred_work();
+    
+    /* Driver tests */
+    test_serial_write();
+    test_kprintf();
+    test_clock();
+    test_profile();
+    test_latency();
+    test_debugcon();
+    test_initrd();
+    
+    /* Synchronization tests */
+    test_sync_primitives();
     
     /* Integration tests */
     test_integration_full_lifecycle();
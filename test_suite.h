@@ -20,6 +20,31 @@ void test_scheduler_init(void);
 void test_scheduler_get_next_process(void);
 void test_scheduler_update_time(void);
 void test_scheduler_aging(void);
+void test_scheduler_edf(void);
+void test_scheduler_trace(void);
+void test_scheduler_mlfq(void);
+void test_scheduler_accounting(void);
+void test_scheduler_workload(void);
+void test_timer_wheel(void);
+void test_scheduler_timers(void);
+void test_ipc(void);
+void test_sleeping_locks(void);
+void test_shared_memory(void);
+void test_ring_channels(void);
+void test_system_calls(void);
+void test_deferred_work(void);
+
+/* Driver tests */
+void test_serial_write(void);
+void test_kprintf(void);
+void test_clock(void);
+void test_profile(void);
+void test_latency(void);
+void test_debugcon(void);
+void test_initrd(void);
+
+/* Synchronization tests */
+void test_sync_primitives(void);
 
 /* Integration tests */
 void test_integration_full_lifecycle(void);
@@ -0,0 +1,179 @@
+/* timer.c - Hierarchical timing wheel for tick-based timeouts
+ *
+ * Timers due within the next 256 ticks sit in the root wheel, one slot per
+ * tick. Later ones sit in one of three coarser 64-slot levels, each slot
+ * covering 64 times the span of a slot on the level below. Whenever the
+ * root wheel wraps, the matching slot of the next level is re-filed one
+ * level down (and so on up the levels), so a timer is moved at most three
+ * times before it runs. Adding and cancelling are O(1) list operations and
+ * a tick only touches the timers that are actually due or being moved.
+ */
+#include "timer.h"
+#include "string.h"
+
+static void timer_link(timer_event_t **head, timer_event_t *timer) {
+    timer->next = *head;
+    if (timer->next != NULL) {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+}
+
+static void timer_unlink(timer_event_t *timer) {
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/* Slot a timer belongs in, judged from the next tick to be processed */
+static timer_event_t **timer_slot(timer_wheel_t *wheel, uint32_t expires) {
+    uint32_t delta = expires - wheel->next_tick;
+    uint32_t level;
+    if ((int32_t)delta < 0) {
+        /* Already due: run on the next tick processed */
+        return &wheel->root[wheel->next_tick & (TIMER_ROOT_SIZE - 1)];
+    }
+    if (delta < TIMER_ROOT_SIZE) {
+        return &wheel->root[expires & (TIMER_ROOT_SIZE - 1)];
+    }
+    if (delta > TIMER_MAX_DELTA) {
+        /* Beyond the top level: park in its farthest slot, re-filed when that cascades */
+        delta = TIMER_MAX_DELTA;
+        expires = wheel->next_tick + delta;
+    }
+    for (level = 0; level < TIMER_LEVELS - 1; level++) {
+        if (delta < 1U << (TIMER_ROOT_BITS + (level + 1) * TIMER_LEVEL_BITS)) {
+            break;
+        }
+    }
+    return &wheel->levels[level][(expires >> (TIMER_ROOT_BITS + level * TIMER_LEVEL_BITS)) &
+                                 (TIMER_LEVEL_SIZE - 1)];
+}
+
+/* Re-file the current slot of one level; returns that slot's index */
+static uint32_t timer_cascade(timer_wheel_t *wheel, uint32_t level) {
+    uint32_t index = (wheel->next_tick >> (TIMER_ROOT_BITS + level * TIMER_LEVEL_BITS)) &
+                     (TIMER_LEVEL_SIZE - 1);
+    timer_event_t *timer = wheel->levels[level][index];
+    wheel->levels[level][index] = NULL;
+    while (timer != NULL) {
+        timer_event_t *next = timer->next;
+        timer_link(timer_slot(wheel, timer->expires), timer);
+        wheel->cascaded++;
+        timer = next;
+    }
+    return index;
+}
+
+/**
+ * Initialize an empty wheel
+ * @param wheel: Wheel to initialize; anything it held is forgotten
+ * @param now: Current tick; the first timer_advance() processes now + 1
+ */
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->next_tick = now + 1;
+}
+
+/**
+ * Dequeue every pending timer without running it, then restart the clock
+ * @param wheel: Previously initialized wheel
+ * @param now: Current tick
+ */
+void timer_wheel_reset(timer_wheel_t *wheel, uint32_t now) {
+    uint32_t i;
+    uint32_t level;
+    for (i = 0; i < TIMER_ROOT_SIZE; i++) {
+        while (wheel->root[i] != NULL) {
+            timer_unlink(wheel->root[i]);
+        }
+    }
+    for (level = 0; level < TIMER_LEVELS; level++) {
+        for (i = 0; i < TIMER_LEVEL_SIZE; i++) {
+            while (wheel->levels[level][i] != NULL) {
+                timer_unlink(wheel->levels[level][i]);
+            }
+        }
+    }
+    timer_wheel_init(wheel, now);
+}
+
+/**
+ * Prepare a timer that is not queued anywhere
+ * @param timer: Timer to set up
+ * @param callback: Run from timer_advance() once the timer expires
+ */
+void timer_setup(timer_event_t *timer, timer_callback_t callback) {
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expires = 0;
+    timer->callback = callback;
+}
+
+/**
+ * Queue a timer, moving it if it is already pending
+ * @param wheel: Wheel to queue on
+ * @param timer: Set-up timer
+ * @param expires: Absolute tick to fire on; a tick already processed fires on the next one
+ */
+void timer_add(timer_wheel_t *wheel, timer_event_t *timer, uint32_t expires) {
+    if (timer_pending(timer)) {
+        timer_unlink(timer);
+        wheel->pending--;
+    }
+    timer->expires = expires;
+    timer_link(timer_slot(wheel, expires), timer);
+    wheel->pending++;
+}
+
+/**
+ * Dequeue a timer without running it
+ * @param wheel: Wheel the timer is queued on
+ * @param timer: Timer to cancel
+ * @return: 1 if it was pending, 0 otherwise
+ */
+uint32_t timer_cancel(timer_wheel_t *wheel, timer_event_t *timer) {
+    if (!timer_pending(timer)) {
+        return 0;
+    }
+    timer_unlink(timer);
+    wheel->pending--;
+    return 1;
+}
+
+/**
+ * Process every tick up to and including now, running expired callbacks
+ * Callbacks may add or cancel any timer, including their own.
+ * @param wheel: Wheel to advance
+ * @param now: Current tick
+ */
+void timer_advance(timer_wheel_t *wheel, uint32_t now) {
+    while ((int32_t)(now - wheel->next_tick) >= 0) {
+        uint32_t index = wheel->next_tick & (TIMER_ROOT_SIZE - 1);
+        uint32_t level = 0;
+        timer_event_t *expired;
+        if (index == 0) {
+            while (level < TIMER_LEVELS && timer_cascade(wheel, level) == 0) {
+                level++;
+            }
+        }
+        /* Move the due list to a local head so callbacks can cancel entries on it */
+        expired = wheel->root[index];
+        wheel->root[index] = NULL;
+        if (expired != NULL) {
+            expired->pprev = &expired;
+        }
+        wheel->next_tick++;
+        while (expired != NULL) {
+            timer_event_t *timer = expired;
+            timer_unlink(timer);
+            wheel->pending--;
+            wheel->expired++;
+            timer->callback(timer);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+/* timer.h - Hierarchical timing wheel for tick-based timeouts */
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "types.h"
+
+//Wheel geometry: an 8-bit first level, then three 6-bit levels (2^26 ticks, ~18h at 1ms)
+#define TIMER_ROOT_BITS     8
+#define TIMER_LEVEL_BITS    6
+#define TIMER_ROOT_SIZE     (1 << TIMER_ROOT_BITS)
+#define TIMER_LEVEL_SIZE    (1 << TIMER_LEVEL_BITS)
+#define TIMER_LEVELS        3         /* Levels above the root */
+#define TIMER_MAX_DELTA     ((1U << (TIMER_ROOT_BITS + TIMER_LEVELS * TIMER_LEVEL_BITS)) - 1)
+
+struct timer_event;
+typedef void (*timer_callback_t)(struct timer_event *timer);
+
+//One timeout; embed it in the object it belongs to and recover that with container_of()
+typedef struct timer_event {
+    struct timer_event *next;
+    struct timer_event **pprev;       /* Link pointing at us, NULL while not queued */
+    uint32_t expires;                 /* Absolute tick */
+    timer_callback_t callback;
+} timer_event_t;
+
+//Timer wheel; not locked, the owner serializes access
+typedef struct {
+    timer_event_t *root[TIMER_ROOT_SIZE];
+    timer_event_t *levels[TIMER_LEVELS][TIMER_LEVEL_SIZE];
+    uint32_t next_tick;               /* Next tick timer_advance() will process */
+    uint32_t pending;
+    uint32_t expired;                 /* Callbacks run since init */
+    uint32_t cascaded;                /* Timers moved down a level since init */
+} timer_wheel_t;
+
+//Whether a timer is queued on a wheel
+static inline uint32_t timer_pending(const timer_event_t *timer) {
+    return timer->pprev != NULL;
+}
+
+//Function declarations
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now);
+void timer_wheel_reset(timer_wheel_t *wheel, uint32_t now);
+void timer_setup(timer_event_t *timer, timer_callback_t callback);
+void timer_add(timer_wheel_t *wheel, timer_event_t *timer, uint32_t expires);
+uint32_t timer_cancel(timer_wheel_t *wheel, timer_event_t *timer);
+void timer_advance(timer_wheel_t *wheel, uint32_t now);
+#endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""bench_compare.py - Compare two `make bench` outputs
+
+Usage:
+    make bench > old.txt        # on the baseline build
+    make bench > new.txt        # on the candidate build
+    tools/bench_compare.py old.txt new.txt [--threshold 10]
+
+Cases are matched on name and parameters and compared on median_ns. Cases
+slower by more than the threshold (percent) are flagged and make the script
+exit with status 1, so it can gate a CI job.
+"""
+import argparse
+import sys
+
+
+def parse(path):
+    """Return {(name, params): {field: int}} from the BENCH lines of a run."""
+    results = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) < 2 or fields[0] != "BENCH":
+                continue
+            name = fields[1]
+            params = []
+            values = {}
+            for field in fields[2:]:
+                key, _, value = field.partition("=")
+                if value.isdigit() and key in ("ops", "trials", "min_ns", "median_ns",
+                                                "max_ns", "median_cycles"):
+                    values[key] = int(value)
+                else:
+                    params.append(field)
+            if "median_ns" in values:
+                results[(name, " ".join(params))] = values
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two kacchiOS benchmark runs")
+    parser.add_argument("baseline")
+    parser.add_argument("candidate")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="percent slowdown in median_ns that counts as a regression (default 10)")
+    args = parser.parse_args()
+
+    old = parse(args.baseline)
+    new = parse(args.candidate)
+    if not old or not new:
+        print("error: no BENCH lines in %s" % (args.baseline if not old else args.candidate),
+              file=sys.stderr)
+        return 2
+
+    regressions = 0
+    print("%-28s %-22s %10s %10s %8s" % ("benchmark", "params", "old ns", "new ns", "change"))
+    for key in sorted(set(old) | set(new)):
+        name, params = key
+        if key not in old or key not in new:
+            print("%-28s %-22s %s" % (name, params, "only in " + ("candidate" if key in new else "baseline")))
+            continue
+        before = old[key]["median_ns"]
+        after = new[key]["median_ns"]
+        change = (after - before) * 100.0 / before if before else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-28s %-22s %10u %10u %+7.1f%%%s" % (name, params, before, after, change, flag))
+    print("%u regression(s) above %.1f%%" % (regressions, args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
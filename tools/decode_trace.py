@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""decode_trace.py - Decode a kacchiOS debugcon capture (make run-trace)
+
+Records are 16 bytes, little-endian, laid out as dbg_record_t in debugcon.h:
+type u8, cpu u8, arg u16, tsc_lo u32, a u32, b u32.
+
+Usage:
+    tools/decode_trace.py trace.bin                 # CSV on stdout
+    tools/decode_trace.py trace.bin -o trace.csv
+    tools/decode_trace.py trace.bin --chrome trace.json [--tsc-mhz 2400]
+
+The Chrome trace opens in chrome://tracing or https://ui.perfetto.dev.
+"""
+import argparse
+import csv
+import json
+import struct
+import sys
+
+RECORD = struct.Struct("<BBHIII")
+
+EV_SYNC = 0
+EV_SWITCH = 1
+EV_ALLOC = 2
+EV_FREE = 3
+EV_IRQ_ENTER = 4
+EV_IRQ_EXIT = 5
+EV_MARK = 6
+
+EVENT_NAMES = {
+    EV_SYNC: "sync",
+    EV_SWITCH: "switch",
+    EV_ALLOC: "alloc",
+    EV_FREE: "free",
+    EV_IRQ_ENTER: "irq_enter",
+    EV_IRQ_EXIT: "irq_exit",
+    EV_MARK: "mark",
+}
+
+# trace_reason_t in trace.h
+REASON_NAMES = ["schedule", "quantum", "edf", "steal", "direct", "yield", "block", "exit", "handoff"]
+
+
+def read_events(path):
+    """Yield (tsc, type, cpu, arg, a, b) with the TSC rebuilt from SYNC records."""
+    with open(path, "rb") as f:
+        data = f.read()
+    tail = len(data) % RECORD.size
+    if tail:
+        print("warning: ignoring %d trailing bytes (truncated record)" % tail, file=sys.stderr)
+    tsc_hi = None
+    for offset in range(0, len(data) - tail, RECORD.size):
+        ev_type, cpu, arg, tsc_lo, a, b = RECORD.unpack_from(data, offset)
+        if ev_type == EV_SYNC:
+            tsc_hi = a
+            continue
+        if tsc_hi is None:
+            # Capture started mid-stream; drop records until the first SYNC
+            continue
+        yield (tsc_hi << 32) | tsc_lo, ev_type, cpu, arg, a, b
+
+
+def describe(ev_type, arg, a, b):
+    """Return (pid, detail) columns for the CSV."""
+    if ev_type == EV_SWITCH:
+        reason = REASON_NAMES[arg] if arg < len(REASON_NAMES) else str(arg)
+        return b, "from=%u to=%u reason=%s" % (a, b, reason)
+    if ev_type in (EV_ALLOC, EV_FREE):
+        return arg, "addr=0x%08X size=%u" % (a, b)
+    if ev_type == EV_IRQ_ENTER:
+        return "", "irq=%u eip=0x%08X" % (arg, a)
+    if ev_type == EV_IRQ_EXIT:
+        return "", "irq=%u" % arg
+    return "", "arg=%u a=0x%08X b=0x%08X" % (arg, a, b)
+
+
+def write_csv(events, out):
+    writer = csv.writer(out)
+    writer.writerow(["tsc", "cpu", "event", "pid", "detail"])
+    count = 0
+    for tsc, ev_type, cpu, arg, a, b in events:
+        pid, detail = describe(ev_type, arg, a, b)
+        writer.writerow([tsc, cpu, EVENT_NAMES.get(ev_type, str(ev_type)), pid, detail])
+        count += 1
+    return count
+
+
+def write_chrome(events, out, tsc_mhz):
+    """One track per CPU: process run spans, IRQ spans, allocator instants and a heap counter."""
+    trace = []
+    base = None
+    running = {}      # cpu -> (pid, start_us)
+    heap_bytes = 0
+    last_us = 0.0
+    for tsc, ev_type, cpu, arg, a, b in events:
+        if base is None:
+            base = tsc
+        us = (tsc - base) / tsc_mhz
+        last_us = us
+        if ev_type == EV_SWITCH:
+            if cpu in running:
+                pid, start = running[cpu]
+                trace.append({"name": "pid %u" % pid, "ph": "X", "pid": 0, "tid": cpu,
+                              "ts": start, "dur": us - start})
+            running[cpu] = (b, us)
+            reason = REASON_NAMES[arg] if arg < len(REASON_NAMES) else str(arg)
+            trace.append({"name": "switch", "ph": "i", "s": "t", "pid": 0, "tid": cpu, "ts": us,
+                          "args": {"from": a, "to": b, "reason": reason}})
+        elif ev_type in (EV_ALLOC, EV_FREE):
+            heap_bytes += b if ev_type == EV_ALLOC else -b
+            trace.append({"name": EVENT_NAMES[ev_type], "ph": "i", "s": "t", "pid": 0, "tid": cpu,
+                          "ts": us, "args": {"pid": arg, "address": "0x%08X" % a, "size": b}})
+            trace.append({"name": "heap bytes", "ph": "C", "pid": 0, "ts": us,
+                          "args": {"allocated": heap_bytes}})
+        elif ev_type == EV_IRQ_ENTER:
+            trace.append({"name": "irq %u" % arg, "ph": "B", "pid": 0, "tid": 1000 + cpu, "ts": us,
+                          "args": {"eip": "0x%08X" % a}})
+        elif ev_type == EV_IRQ_EXIT:
+            trace.append({"name": "irq %u" % arg, "ph": "E", "pid": 0, "tid": 1000 + cpu, "ts": us})
+        else:
+            trace.append({"name": "mark %u" % arg, "ph": "i", "s": "g", "pid": 0, "tid": cpu,
+                          "ts": us, "args": {"a": a, "b": b}})
+    for cpu, (pid, start) in running.items():
+        trace.append({"name": "pid %u" % pid, "ph": "X", "pid": 0, "tid": cpu,
+                      "ts": start, "dur": last_us - start})
+    cpus = sorted({e["tid"] for e in trace if "tid" in e})
+    for tid in cpus:
+        label = "cpu %u irqs" % (tid - 1000) if tid >= 1000 else "cpu %u" % tid
+        trace.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": tid, "args": {"name": label}})
+    json.dump({"traceEvents": trace, "displayTimeUnit": "ns"}, out)
+    return len(trace)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a kacchiOS debugcon capture")
+    parser.add_argument("capture", help="file written by QEMU -debugcon file:...")
+    parser.add_argument("-o", "--output", help="CSV output file (default: stdout)")
+    parser.add_argument("--chrome", metavar="JSON", help="write a Chrome trace instead of CSV")
+    parser.add_argument("--tsc-mhz", type=float, default=1000.0,
+                        help="TSC frequency used to convert cycles to microseconds (default 1000)")
+    args = parser.parse_args()
+
+    events = read_events(args.capture)
+    if args.chrome:
+        with open(args.chrome, "w") as out:
+            count = write_chrome(events, out, args.tsc_mhz)
+        print("wrote %u trace events to %s" % (count, args.chrome), file=sys.stderr)
+    elif args.output:
+        with open(args.output, "w", newline="") as out:
+            count = write_csv(events, out)
+        print("wrote %u records to %s" % (count, args.output), file=sys.stderr)
+    else:
+        write_csv(events, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
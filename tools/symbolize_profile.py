@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""symbolize_profile.py - Symbolize a kacchiOS `profile dump` against kernel.elf
+
+Capture the serial console (e.g. `make run | tee serial.log`), then run
+`profile start`, the workload of interest, `profile stop` and `profile dump`.
+
+Usage:
+    tools/symbolize_profile.py serial.log                     # flat profile by function
+    tools/symbolize_profile.py serial.log --addresses 20      # hottest EIPs with file:line
+    tools/symbolize_profile.py serial.log --folded > out.folded
+    flamegraph.pl out.folded > profile.svg
+
+Folded stacks come from the most recent PROFILE_STACK_SAMPLES samples and
+are only deep with a `make PROFILE_FP=1` kernel.
+"""
+import argparse
+import bisect
+import collections
+import subprocess
+import sys
+
+
+def load_symbols(elf):
+    """Sorted (address, name) list of text symbols from nm."""
+    out = subprocess.run(["nm", "-n", "--defined-only", elf], check=True,
+                         capture_output=True, text=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[1] in "tTwW":
+            symbols.append((int(parts[0], 16), parts[2]))
+    return symbols
+
+
+def make_resolver(symbols):
+    addresses = [address for address, _ in symbols]
+
+    def resolve(pc):
+        i = bisect.bisect_right(addresses, pc) - 1
+        return symbols[i][1] if i >= 0 else "0x%08x" % pc
+    return resolve
+
+
+def read_dump(path):
+    """Return (header fields, {eip: count}, [stack, ...]) from the last dump in the log."""
+    header, flat, stacks = {}, {}, []
+    inside = False
+    with open(path, errors="replace") as f:
+        for raw in f:
+            line = raw.strip()
+            if line.startswith("PROFILE_BEGIN"):
+                header = dict(field.split("=", 1) for field in line.split()[1:] if "=" in field)
+                flat, stacks, inside = {}, [], True
+            elif line.startswith("PROFILE_END"):
+                inside = False
+            elif inside and line.startswith("P "):
+                _, eip, count = line.split()
+                flat[int(eip, 16)] = int(count)
+            elif inside and line.startswith("S "):
+                stacks.append([int(pc, 16) for pc in line.split()[1:]])
+    if not header:
+        sys.exit("error: no PROFILE_BEGIN in %s" % path)
+    return header, flat, stacks
+
+
+def print_flat(header, flat, resolve, out):
+    by_function = collections.Counter()
+    for eip, count in flat.items():
+        by_function[resolve(eip)] += count
+    total = sum(by_function.values()) or 1
+    out.write("# %s samples at %s Hz, %s dropped\n" % (header.get("samples", "?"), header.get("hz", "?"),
+                                                      header.get("dropped", "0")))
+    out.write("%8s %7s %7s  %s\n" % ("samples", "self%", "cum%", "function"))
+    cumulative = 0
+    for function, count in by_function.most_common():
+        cumulative += count
+        out.write("%8u %6.2f%% %6.2f%%  %s\n" % (count, count * 100.0 / total, cumulative * 100.0 / total, function))
+
+
+def print_addresses(flat, elf, limit, out):
+    hottest = sorted(flat.items(), key=lambda item: -item[1])[:limit]
+    if not hottest:
+        return
+    lines = subprocess.run(["addr2line", "-f", "-e", elf] + ["0x%x" % eip for eip, _ in hottest],
+                           check=True, capture_output=True, text=True).stdout.splitlines()
+    out.write("%8s  %-10s  %s\n" % ("samples", "eip", "location"))
+    for i, (eip, count) in enumerate(hottest):
+        function, location = lines[2 * i], lines[2 * i + 1]
+        out.write("%8u  0x%08x  %s (%s)\n" % (count, eip, function, location))
+
+
+def print_folded(stacks, resolve, out):
+    folded = collections.Counter()
+    for stack in stacks:
+        # Callers are return addresses; step back into the call instruction
+        names = [resolve(pc if depth == 0 else pc - 1) for depth, pc in enumerate(stack)]
+        folded[";".join(reversed(names))] += 1
+    for frames, count in folded.most_common():
+        out.write("%s %u\n" % (frames, count))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Symbolize a kacchiOS profile dump")
+    parser.add_argument("log", help="serial log containing PROFILE_BEGIN ... PROFILE_END")
+    parser.add_argument("--elf", default="kernel.elf", help="kernel image the dump came from")
+    parser.add_argument("--folded", action="store_true", help="emit folded stacks for flamegraph.pl")
+    parser.add_argument("--addresses", type=int, metavar="N", help="list the N hottest EIPs with file:line")
+    args = parser.parse_args()
+
+    header, flat, stacks = read_dump(args.log)
+    resolve = make_resolver(load_symbols(args.elf))
+    if args.folded:
+        print_folded(stacks, resolve, sys.stdout)
+    elif args.addresses:
+        print_addresses(flat, args.elf, args.addresses, sys.stdout)
+    else:
+        print_flat(header, flat, resolve, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
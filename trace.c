@@ -0,0 +1,82 @@
+/* trace.c - Lock-free ring buffer of context switches */
+#include "trace.h"
+#include "cpu.h"
+#include "serial.h"
+#include "spinlock.h"
+#include "kprintf.h"
+#include "debugcon.h"
+#include "clock.h"
+
+static trace_event_t trace_buffer[TRACE_BUFFER_SIZE];
+static atomic_t trace_next = ATOMIC_INIT(0);
+
+static const char *trace_reason_names[] = {
+    "schedule", "quantum", "edf", "steal", "direct", "yield", "block", "exit", "handoff"
+};
+
+/**
+ * Record a context switch
+ * Safe from any CPU: each writer claims its own slot, oldest entries are overwritten.
+ * @param cpu: CPU performing the switch
+ * @param from_pid: Process being switched out
+ * @param to_pid: Process being switched in
+ * @param reason: Why the switch happened
+ * @param runqueue_len: READY processes on the CPU at decision time
+ */
+void trace_switch(uint32_t cpu, uint32_t from_pid, uint32_t to_pid,
+                  trace_reason_t reason, uint32_t runqueue_len) {
+    uint32_t seq = atomic_inc(&trace_next) - 1;
+    trace_event_t *event = &trace_buffer[seq & (TRACE_BUFFER_SIZE - 1)];
+    event->seq = 0;
+    __asm__ volatile ("" : : : "memory");
+    event->tsc = rdtsc();
+    event->from_pid = (uint16_t)from_pid;
+    event->to_pid = (uint16_t)to_pid;
+    event->runqueue_len = (uint16_t)runqueue_len;
+    event->cpu = (uint8_t)cpu;
+    event->reason = (uint8_t)reason;
+    __asm__ volatile ("" : : : "memory");
+    event->seq = seq + 1;
+    debugcon_emit(DBG_EV_SWITCH, reason, from_pid, to_pid);
+}
+
+//Total number of switches recorded so far
+uint32_t trace_head(void) {
+    return atomic_read(&trace_next);
+}
+
+/**
+ * Copy out one recorded switch
+ * @param seq: Sequence number, 0 .. trace_head() - 1
+ * @param out: Destination
+ * @return: 1 if the entry is still in the buffer and complete, 0 otherwise
+ */
+uint32_t trace_read(uint32_t seq, trace_event_t *out) {
+    trace_event_t *event = &trace_buffer[seq & (TRACE_BUFFER_SIZE - 1)];
+    if (event->seq != seq + 1) {
+        return 0;
+    }
+    *out = *event;
+    __asm__ volatile ("" : : : "memory");
+    return event->seq == seq + 1;
+}
+
+//Dump the buffer oldest-first as CSV for offline analysis
+void trace_dump(void) {
+    uint32_t head = trace_head();
+    uint32_t seq = head > TRACE_BUFFER_SIZE ? head - TRACE_BUFFER_SIZE : 0;
+    trace_event_t event;
+    serial_puts("\n=== Context Switch Trace ===\n");
+    serial_puts("seq,tsc,ns,cpu,from,to,reason,runqueue\n");
+    for (; seq < head; seq++) {
+        if (!trace_read(seq, &event)) {
+            continue;
+        }
+        kprintf("%u,0x%016llX,%llu,%u,%u,%u,%s,%u\n", seq, event.tsc, clock_tsc_to_ns(event.tsc),
+                event.cpu, event.from_pid, event.to_pid, event.reason <= TRACE_REASON_HANDOFF ? trace_reason_names[event.reason] : "?",
+                event.runqueue_len);
+    }
+    serial_puts("=== ");
+    serial_put_dec(head);
+    serial_puts(" switches recorded ===\n\n");
+}
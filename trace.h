@@ -0,0 +1,40 @@
+/* trace.h - Context-switch trace ring buffer */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "types.h"
+
+#define TRACE_BUFFER_SIZE  1024    /* Entries; must be a power of two */
+
+//Why a switch happened
+typedef enum {
+    TRACE_REASON_SCHEDULE = 0,     /* Explicit scheduler_schedule() / need_resched */
+    TRACE_REASON_QUANTUM = 1,      /* Round-robin time slice expired */
+    TRACE_REASON_EDF = 2,          /* EDF release, completion or deadline drop */
+    TRACE_REASON_STEAL = 3,        /* Next process was stolen from another CPU */
+    TRACE_REASON_DIRECT = 4,       /* scheduler_context_switch() called directly */
+    TRACE_REASON_YIELD = 5,        /* Running process gave up the CPU voluntarily */
+    TRACE_REASON_BLOCK = 6,        /* Running process blocked */
+    TRACE_REASON_EXIT = 7,         /* Running process terminated */
+    TRACE_REASON_HANDOFF = 8       /* scheduler_handoff(): CPU given straight to an IPC partner */
+} trace_reason_t;
+
+//One recorded context switch (24 bytes)
+typedef struct {
+    uint64_t tsc;                  /* Time stamp counter at the switch */
+    uint32_t seq;                  /* Sequence number + 1; 0 while being written */
+    uint16_t from_pid;
+    uint16_t to_pid;
+    uint16_t runqueue_len;         /* READY processes on this CPU at decision time */
+    uint8_t cpu;
+    uint8_t reason;
+    uint32_t reserved;
+} trace_event_t;
+
+//Function declarations
+void trace_switch(uint32_t cpu, uint32_t from_pid, uint32_t to_pid,
+                  trace_reason_t reason, uint32_t runqueue_len);
+uint32_t trace_head(void);
+uint32_t trace_read(uint32_t seq, trace_event_t *out);
+void trace_dump(void);
+#endif
@@ -2,15 +2,24 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#ifdef KACCHI_HOSTED
+/* Hosted build (make host-bench): share the host's definitions with libc code */
+#include <stdint.h>
+#include <stddef.h>
+#else
 typedef unsigned int   uint32_t;
 typedef unsigned short uint16_t;
 typedef unsigned char  uint8_t;
 typedef int            int32_t;
 typedef short          int16_t;
 typedef char           int8_t;
+typedef unsigned long long uint64_t;
+typedef long long          int64_t;
 
 typedef uint32_t size_t;
+typedef uint32_t uintptr_t;
 
 #define NULL  ((void*)0)
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,265 @@
+/* workload.c - Synthetic scheduler workloads and metrics
+ *
+ * Processes in kacchiOS do not execute code yet, so the generator plays
+ * their part: every tick the process the scheduler made CURRENT consumes
+ * one tick of its service demand, I/O jobs sleep after each burst, and
+ * jobs exit once their demand is met. Everything else - who
+ * runs, for how long, and when - is decided by the real scheduler.
+ */
+#include "workload.h"
+#include "process.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "string.h"
+#include "trace.h"
+#include "clock.h"
+#include "math64.h"
+
+//One synthetic job
+typedef struct {
+    workload_kind_t kind;
+    uint32_t pid;              /* 0 until spawned */
+    uint32_t priority;
+    uint32_t arrival;          /* Run-relative tick it is spawned on */
+    uint32_t service;          /* CPU ticks still needed */
+    uint32_t burst;            /* WORKLOAD_IO: ticks run between sleeps */
+    uint32_t burst_left;
+    uint32_t sleep;            /* WORKLOAD_IO: ticks slept after each burst */
+    uint32_t wait;             /* Ticks spent READY */
+    uint32_t running;          /* CURRENT during this tick */
+    uint32_t done;
+} workload_job_t;
+
+static workload_job_t jobs[WORKLOAD_MAX_JOBS];
+static uint32_t wait_samples[WORKLOAD_MAX_JOBS];
+static uint32_t turnaround_samples[WORKLOAD_MAX_JOBS];
+static uint32_t parked[MAX_PROCESSES];
+static uint32_t workload_rand_state;
+
+/* Deterministic LCG so runs with the same seed are comparable */
+static uint32_t workload_rand(uint32_t range) {
+    workload_rand_state = workload_rand_state * 1103515245 + 12345;
+    return (workload_rand_state >> 16) % range;
+}
+
+/* Build the job set for a config; returns the number of jobs */
+static uint32_t workload_generate(const workload_config_t *config) {
+    uint32_t count = 0;
+    uint32_t i;
+    uint32_t spread = config->ticks / 2 ? config->ticks / 2 : 1;
+    uint32_t clump_at = 0;
+    workload_rand_state = config->seed;
+    memset(jobs, 0, sizeof(jobs));
+    for (i = 0; i < config->cpu_bound && count < WORKLOAD_MAX_JOBS; i++, count++) {
+        jobs[count].kind = WORKLOAD_CPU;
+        jobs[count].arrival = workload_rand(spread);
+        jobs[count].service = 20 + workload_rand(61);
+        jobs[count].priority = 1 + workload_rand(4);
+    }
+    for (i = 0; i < config->io_bound && count < WORKLOAD_MAX_JOBS; i++, count++) {
+        jobs[count].kind = WORKLOAD_IO;
+        jobs[count].arrival = workload_rand(spread);
+        jobs[count].service = 10 + workload_rand(21);
+        jobs[count].burst = 1 + workload_rand(3);
+        jobs[count].burst_left = jobs[count].burst;
+        jobs[count].sleep = 5 + workload_rand(16);
+        jobs[count].priority = 1 + workload_rand(4);
+    }
+    for (i = 0; i < config->bursty && count < WORKLOAD_MAX_JOBS; i++, count++) {
+        if (i % WORKLOAD_CLUMP == 0) {
+            clump_at = workload_rand(spread + spread / 2);
+        }
+        jobs[count].kind = WORKLOAD_BURSTY;
+        jobs[count].arrival = clump_at;
+        jobs[count].service = 2 + workload_rand(9);
+        jobs[count].priority = 1 + workload_rand(4);
+    }
+    return count;
+}
+
+/* Block every other runnable process so it does not skew the numbers */
+static void workload_park_others(void) {
+    uint32_t i;
+    for (i = 1; i < process_slot_count(); i++) {
+        process_control_block_t *pcb = process_slot(i);
+        parked[i] = 0;
+        if ((pcb->state == READY || pcb->state == CURRENT) &&
+            pcb->sched_class == SCHED_CLASS_NORMAL && scheduler_block(pcb->process_id)) {
+            parked[i] = pcb->process_id;
+        }
+    }
+}
+
+static void workload_unpark_others(void) {
+    uint32_t i;
+    for (i = 1; i < process_slot_count(); i++) {
+        if (parked[i] != 0) {
+            scheduler_wake(parked[i]);
+            parked[i] = 0;
+        }
+    }
+}
+
+/* Sort samples and return the nearest-rank percentile */
+static uint32_t workload_percentile(uint32_t *samples, uint32_t count, uint32_t percent) {
+    uint32_t i;
+    uint32_t rank;
+    for (i = 1; i < count; i++) {
+        uint32_t value = samples[i];
+        uint32_t j = i;
+        while (j > 0 && samples[j - 1] > value) {
+            samples[j] = samples[j - 1];
+            j--;
+        }
+        samples[j] = value;
+    }
+    rank = (count * percent + 99) / 100;
+    return samples[rank > 0 ? rank - 1 : 0];
+}
+
+static uint32_t workload_average(const uint32_t *samples, uint32_t count) {
+    uint32_t i;
+    uint32_t sum = 0;
+    for (i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    return count ? sum / count : 0;
+}
+
+/**
+ * Run a synthetic workload against the active scheduling algorithm
+ * Other normal-class processes are blocked for the duration and woken afterwards;
+ * jobs still unfinished when the run ends are terminated and not counted.
+ * @param config: Job mix and run length
+ * @param result: Receives the metrics
+ * @return: Number of completed jobs
+ */
+uint32_t workload_run(const workload_config_t *config, workload_result_t *result) {
+    uint32_t count = workload_generate(config);
+    uint32_t switches_start;
+    uint64_t started = clock_cycles();
+    uint32_t now;
+    uint32_t i;
+    memset(result, 0, sizeof(*result));
+    result->algorithm = scheduler_get_algorithm();
+    result->quantum = scheduler_get_quantum();
+    result->ticks = config->ticks;
+    workload_park_others();
+    switches_start = trace_head();
+    for (now = 0; now < config->ticks; now++) {
+        //Arrivals; sleeping jobs are woken by the scheduler's timers
+        for (i = 0; i < count; i++) {
+            workload_job_t *job = &jobs[i];
+            if (job->pid == 0 && job->arrival == now) {
+                job->pid = process_create(job->priority, WORKLOAD_STACK_SIZE, WORKLOAD_HEAP_SIZE);
+                if (job->pid == 0) {
+                    job->done = 1;
+                    continue;
+                }
+                result->spawned++;
+            }
+        }
+        scheduler_update_time();
+        if (scheduler_need_resched()) {
+            scheduler_schedule();
+        }
+        //Snapshot first: a job finishing or blocking below hands its CPU straight on
+        for (i = 0; i < count; i++) {
+            workload_job_t *job = &jobs[i];
+            process_state_t state = job->pid != 0 && !job->done ? process_get_state(job->pid) : TERMINATED;
+            job->running = state == CURRENT;
+            if (state == READY) {
+                job->wait++;
+            }
+        }
+        //Whoever held a CPU this tick did one tick of work
+        for (i = 0; i < count; i++) {
+            workload_job_t *job = &jobs[i];
+            if (!job->running) {
+                continue;
+            }
+            job->service--;
+            if (job->service == 0) {
+                job->done = 1;
+                wait_samples[result->completed] = job->wait;
+                turnaround_samples[result->completed] = now + 1 - job->arrival;
+                result->completed++;
+                process_terminate(job->pid);
+            }
+            else if (job->kind == WORKLOAD_IO && --job->burst_left == 0) {
+                job->burst_left = job->burst;
+                scheduler_sleep(job->pid, job->sleep);
+            }
+        }
+    }
+    result->switches = trace_head() - switches_start;
+    //Reap jobs that did not finish in time
+    for (i = 0; i < count; i++) {
+        if (jobs[i].pid != 0 && !jobs[i].done) {
+            jobs[i].done = 1;
+            process_terminate(jobs[i].pid);
+        }
+    }
+    workload_unpark_others();
+    result->elapsed_ns = clock_cycles_to_ns(clock_cycles() - started);
+    result->wait_avg = workload_average(wait_samples, result->completed);
+    result->turnaround_avg = workload_average(turnaround_samples, result->completed);
+    if (result->completed > 0) {
+        result->wait_p95 = workload_percentile(wait_samples, result->completed, 95);
+        result->wait_p99 = workload_percentile(wait_samples, result->completed, 99);
+        result->turnaround_p95 = workload_percentile(turnaround_samples, result->completed, 95);
+        result->turnaround_p99 = workload_percentile(turnaround_samples, result->completed, 99);
+    }
+    return result->completed;
+}
+
+/* Print events per 1000 ticks of run time with one decimal; 64-bit so events * 10000 cannot wrap */
+static void workload_put_rate(uint32_t events, uint32_t ticks) {
+    uint64_t tenths = ticks ? udiv64((uint64_t)events * 10000, ticks) : 0;
+    serial_put_dec((uint32_t)udiv64(tenths, 10));
+    serial_puts(".");
+    serial_put_dec((uint32_t)(tenths - udiv64(tenths, 10) * 10));
+    serial_puts(" per 1000 ticks");
+}
+
+//Print a workload report
+void workload_print_result(const workload_result_t *result) {
+    scheduling_algorithm_t algorithm = (scheduling_algorithm_t)result->algorithm;
+    serial_puts("\n=== Workload Report ===\n");
+    serial_puts("Algorithm: ");
+    if (algorithm == FCFS) {
+        serial_puts("FCFS\n");
+    }
+    else {
+        serial_puts(algorithm == MLFQ ? "MLFQ (base quantum " : "Round Robin (");
+        serial_put_dec(result->quantum);
+        serial_puts(" ticks)\n");
+    }
+    serial_puts("Run length: ");
+    serial_put_dec(result->ticks);
+    serial_puts(" ticks simulated in ");
+    clock_put_ms(result->elapsed_ns);
+    serial_puts("\nJobs: ");
+    serial_put_dec(result->completed);
+    serial_puts(" of ");
+    serial_put_dec(result->spawned);
+    serial_puts(" completed\nThroughput: ");
+    workload_put_rate(result->completed, result->ticks);
+    serial_puts("\nContext switches: ");
+    serial_put_dec(result->switches);
+    serial_puts(" (");
+    workload_put_rate(result->switches, result->ticks);
+    serial_puts(")\nWait (ticks)       avg ");
+    serial_put_dec(result->wait_avg);
+    serial_puts("  p95 ");
+    serial_put_dec(result->wait_p95);
+    serial_puts("  p99 ");
+    serial_put_dec(result->wait_p99);
+    serial_puts("\nTurnaround (ticks) avg ");
+    serial_put_dec(result->turnaround_avg);
+    serial_puts("  p95 ");
+    serial_put_dec(result->turnaround_p95);
+    serial_puts("  p99 ");
+    serial_put_dec(result->turnaround_p99);
+    serial_puts("\n\n");
+}
\ No newline at end of file
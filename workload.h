@@ -0,0 +1,48 @@
+/* workload.h - Synthetic scheduler workloads and metrics */
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "types.h"
+
+#define WORKLOAD_MAX_JOBS     64
+#define WORKLOAD_CLUMP        4         /* Bursty jobs arriving on the same tick */
+#define WORKLOAD_STACK_SIZE   1024
+#define WORKLOAD_HEAP_SIZE    1024
+
+//Kinds of synthetic job
+typedef enum {
+    WORKLOAD_CPU = 0,                   /* One long compute burst */
+    WORKLOAD_IO = 1,                    /* Short bursts separated by sleeps */
+    WORKLOAD_BURSTY = 2                 /* Short jobs arriving in clumps */
+} workload_kind_t;
+
+//Workload mix; arrivals fall in the first part of the run so the queues fill up
+typedef struct {
+    uint32_t ticks;                     /* Length of the run in scheduler ticks */
+    uint32_t cpu_bound;                 /* Number of WORKLOAD_CPU jobs */
+    uint32_t io_bound;                  /* Number of WORKLOAD_IO jobs */
+    uint32_t bursty;                    /* Number of WORKLOAD_BURSTY jobs */
+    uint32_t seed;                      /* Same seed, same job set */
+} workload_config_t;
+
+//Metrics over completed jobs, times in ticks
+typedef struct {
+    uint32_t algorithm;                 /* scheduling_algorithm_t the run used */
+    uint32_t quantum;
+    uint32_t ticks;
+    uint32_t spawned;
+    uint32_t completed;
+    uint32_t switches;
+    uint32_t wait_avg;
+    uint32_t wait_p95;
+    uint32_t wait_p99;
+    uint32_t turnaround_avg;
+    uint32_t turnaround_p95;
+    uint32_t turnaround_p99;
+    uint64_t elapsed_ns;                /* Real time the simulation took */
+} workload_result_t;
+
+//Function declarations
+uint32_t workload_run(const workload_config_t *config, workload_result_t *result);
+void workload_print_result(const workload_result_t *result);
+#endif
\ No newline at end of file